@@ -0,0 +1,485 @@
+/* glfw_headless.cpp - the part of the GLFW API the examples use, without a display
+ *
+ * Built in place of the GLFW library when CMake is configured with
+ * -DCGCC_HEADLESS=ON. The examples do not change: glfwCreateWindow() creates an
+ * EGL context on a surfaceless display (Mesa's llvmpipe when there is no GPU)
+ * and a framebuffer object of the window's size that stands in for the default
+ * framebuffer. glfwGetProcAddress() hands out wrappers of glBindFramebuffer,
+ * glDrawBuffer and glReadBuffer that redirect framebuffer 0 and GL_BACK to it,
+ * so code that binds 0 to "go back to the screen" draws into it too.
+ *
+ * Runs are reproducible:
+ *   - glfwGetTime() is a fixed step per frame (glfwSwapBuffers), not the wall
+ *     clock, so animations land on the same pose on every machine
+ *   - the window asks to close after a fixed number of frames
+ *   - there is no input except the keys listed in CGCC_HEADLESS_KEYS, pressed
+ *     and released once before the first frame
+ *   - waiting for events (an on-demand FramePacer) counts as the window being
+ *     exposed, so every iteration draws and the frame count is reached
+ *
+ * Environment variables:
+ *   CGCC_HEADLESS_FRAMES   frames before the window closes (default 300, 0 for
+ *                          no limit)
+ *   CGCC_HEADLESS_FPS      frames per second of glfwGetTime() (default 60)
+ *   CGCC_HEADLESS_KEYS     keys to press, e.g. "GOL" (letters, digits, space)
+ *   CGCC_HEADLESS_CAPTURE  binary PPM written with the last frame
+ *
+ * glfwTerminate() prints the number of frames and the wall time they took,
+ * overall and per frame after the first one (cgcc_golden reads this line).
+ *
+ * Built with CGCC_HEADLESS_NO_FRAME_LIMIT defined (cgcc_bench, which counts its
+ * own frames) the window never asks to close by itself.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+struct GLFWwindow {
+    int width = 0, height = 0;
+    bool shouldClose = false;
+    void* userPointer = nullptr;
+    EGLContext context = EGL_NO_CONTEXT;
+    GLuint FBO = 0, colorRB = 0, depthRB = 0;
+    GLFWkeyfun keyCallback = nullptr;
+    GLFWmousebuttonfun mouseButtonCallback = nullptr;
+    GLFWwindowrefreshfun refreshCallback = nullptr;
+};
+
+namespace {
+
+struct Headless {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    GLFWwindow* current = nullptr;
+    GLFWwindow* window = nullptr; // the one window the examples create
+    int hints[3] = { 0, 0, 0 };   // major, minor, profile
+
+    int maxFrames = 300;
+    double fps = 60.0;
+    std::string keys;
+    std::string capture;
+    bool keysSent = false;
+
+    unsigned long long frames = 0;
+    double timeOffset = 0.0;
+    std::chrono::steady_clock::time_point start, firstFrame, lastFrame;
+
+    PFNGLBINDFRAMEBUFFERPROC bindFramebuffer = nullptr;
+    PFNGLDRAWBUFFERPROC drawBuffer = nullptr;
+    PFNGLREADBUFFERPROC readBuffer = nullptr;
+};
+
+Headless headless;
+
+GLenum redirectBuffer(GLenum buffer)
+{
+    if (buffer == GL_BACK || buffer == GL_FRONT || buffer == GL_BACK_LEFT || buffer == GL_FRONT_LEFT || buffer == GL_FRONT_AND_BACK)
+        return GL_COLOR_ATTACHMENT0;
+    return buffer;
+}
+
+void APIENTRY headlessBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    if (framebuffer == 0 && headless.current)
+        framebuffer = headless.current->FBO;
+    headless.bindFramebuffer(target, framebuffer);
+}
+
+void APIENTRY headlessDrawBuffer(GLenum buffer)
+{
+    headless.drawBuffer(redirectBuffer(buffer));
+}
+
+void APIENTRY headlessReadBuffer(GLenum buffer)
+{
+    headless.readBuffer(redirectBuffer(buffer));
+}
+
+int envInt(const char* name, int fallback)
+{
+    const char* value = std::getenv(name);
+    return value && *value ? std::atoi(value) : fallback;
+}
+
+// GLFW key codes of printable keys are their upper-case ASCII codes
+int keyCode(char c)
+{
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + GLFW_KEY_A;
+    return (unsigned char)c;
+}
+
+// The window's framebuffer object, bottom row first, as a top-down PPM
+bool writeCapture(GLFWwindow* window, const std::string& path)
+{
+    std::vector<unsigned char> pixels((size_t)window->width * window->height * 3);
+    headless.bindFramebuffer(GL_READ_FRAMEBUFFER, window->FBO);
+    headless.readBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, window->width, window->height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::HEADLESS::CAPTURE_NOT_WRITTEN\n" << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << window->width << " " << window->height << "\n255\n";
+    for (int y = window->height - 1; y >= 0; --y)
+        file.write((const char*)&pixels[(size_t)y * window->width * 3], (std::streamsize)window->width * 3);
+    return true;
+}
+
+} // namespace
+
+extern "C" {
+
+int glfwInit(void)
+{
+    if (headless.display != EGL_NO_DISPLAY)
+        return GLFW_TRUE;
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        headless.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (headless.display == EGL_NO_DISPLAY)
+        headless.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major = 0, minor = 0;
+    if (headless.display == EGL_NO_DISPLAY || !eglInitialize(headless.display, &major, &minor))
+    {
+        std::cout << "ERROR::HEADLESS::NO_EGL_DISPLAY" << std::endl;
+        headless.display = EGL_NO_DISPLAY;
+        return GLFW_FALSE;
+    }
+    const char* extensions = eglQueryString(headless.display, EGL_EXTENSIONS);
+    if (!extensions || !std::strstr(extensions, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cout << "ERROR::HEADLESS::NO_SURFACELESS_OPENGL" << std::endl;
+        eglTerminate(headless.display);
+        headless.display = EGL_NO_DISPLAY;
+        return GLFW_FALSE;
+    }
+#ifdef CGCC_HEADLESS_NO_FRAME_LIMIT
+    headless.maxFrames = 0;
+#else
+    headless.maxFrames = envInt("CGCC_HEADLESS_FRAMES", 300);
+#endif
+    headless.fps = envInt("CGCC_HEADLESS_FPS", 60);
+    if (headless.fps <= 0.0)
+        headless.fps = 60.0;
+    if (const char* keys = std::getenv("CGCC_HEADLESS_KEYS"))
+        headless.keys = keys;
+    if (const char* capture = std::getenv("CGCC_HEADLESS_CAPTURE"))
+        headless.capture = capture;
+    headless.start = std::chrono::steady_clock::now();
+    return GLFW_TRUE;
+}
+
+void glfwWindowHint(int hint, int value)
+{
+    if (hint == GLFW_CONTEXT_VERSION_MAJOR)
+        headless.hints[0] = value;
+    else if (hint == GLFW_CONTEXT_VERSION_MINOR)
+        headless.hints[1] = value;
+    else if (hint == GLFW_OPENGL_PROFILE)
+        headless.hints[2] = value;
+}
+
+GLFWwindow* glfwCreateWindow(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share)
+{
+    (void)title; (void)monitor; (void)share;
+    if (headless.display == EGL_NO_DISPLAY || headless.window)
+        return nullptr;
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint count = 0;
+    if (!eglChooseConfig(headless.display, configAttribs, &config, 1, &count) || count < 1)
+        config = nullptr;
+
+    // Without hints GLFW asks for the newest compatibility context; so does EGL
+    std::vector<EGLint> contextAttribs;
+    if (headless.hints[0] > 0)
+    {
+        contextAttribs.insert(contextAttribs.end(), { EGL_CONTEXT_MAJOR_VERSION, headless.hints[0], EGL_CONTEXT_MINOR_VERSION, headless.hints[1] });
+        if (headless.hints[2] == GLFW_OPENGL_CORE_PROFILE)
+            contextAttribs.insert(contextAttribs.end(), { EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT });
+        else if (headless.hints[2] == GLFW_OPENGL_COMPAT_PROFILE)
+            contextAttribs.insert(contextAttribs.end(), { EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT });
+    }
+    contextAttribs.push_back(EGL_NONE);
+    EGLContext context = eglCreateContext(headless.display, config, EGL_NO_CONTEXT, contextAttribs.data());
+    if (context == EGL_NO_CONTEXT)
+    {
+        std::cout << "ERROR::HEADLESS::CONTEXT_NOT_CREATED" << std::endl;
+        return nullptr;
+    }
+    GLFWwindow* window = new GLFWwindow;
+    window->width = width;
+    window->height = height;
+    window->context = context;
+    headless.window = window;
+    return window;
+}
+
+void glfwDestroyWindow(GLFWwindow* window)
+{
+    if (!window)
+        return;
+    if (headless.current == window)
+    {
+        if (!headless.capture.empty() && headless.frames > 0)
+            writeCapture(window, headless.capture);
+        glDeleteRenderbuffers(1, &window->colorRB);
+        glDeleteRenderbuffers(1, &window->depthRB);
+        glDeleteFramebuffers(1, &window->FBO);
+        eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        headless.current = nullptr;
+    }
+    eglDestroyContext(headless.display, window->context);
+    if (headless.window == window)
+        headless.window = nullptr;
+    delete window;
+}
+
+void glfwTerminate(void)
+{
+    if (headless.display == EGL_NO_DISPLAY)
+        return;
+    glfwDestroyWindow(headless.window);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - headless.start).count();
+    // From the first to the last frame, leaving out loading and shader compilation
+    double steady = headless.maxFrames > 1 && headless.frames >= (unsigned long long)headless.maxFrames
+        ? std::chrono::duration<double>(headless.lastFrame - headless.firstFrame).count() / (headless.maxFrames - 1) : 0.0;
+    std::cout << "HEADLESS: " << headless.frames << " frames in " << seconds * 1000.0 << " ms ("
+              << (headless.frames ? seconds * 1000.0 / headless.frames : 0.0) << " ms/frame, "
+              << steady * 1000.0 << " ms/frame after the first)" << std::endl;
+    eglTerminate(headless.display);
+    headless.display = EGL_NO_DISPLAY;
+}
+
+GLFWglproc glfwGetProcAddress(const char* name)
+{
+    if (std::strcmp(name, "glBindFramebuffer") == 0)
+        return (GLFWglproc)headlessBindFramebuffer;
+    if (std::strcmp(name, "glDrawBuffer") == 0)
+        return (GLFWglproc)headlessDrawBuffer;
+    if (std::strcmp(name, "glReadBuffer") == 0)
+        return (GLFWglproc)headlessReadBuffer;
+    return (GLFWglproc)eglGetProcAddress(name);
+}
+
+// The first time a context is made current its framebuffer object is created,
+// bound and given the whole viewport, as a window surface would be
+void glfwMakeContextCurrent(GLFWwindow* window)
+{
+    if (!window)
+    {
+        eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        headless.current = nullptr;
+        return;
+    }
+    eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, window->context);
+    headless.current = window;
+    if (window->FBO)
+        return;
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        std::cout << "ERROR::HEADLESS::GL_NOT_LOADED" << std::endl;
+        return;
+    }
+    headless.bindFramebuffer = glad_glBindFramebuffer;
+    headless.drawBuffer = glad_glDrawBuffer;
+    headless.readBuffer = glad_glReadBuffer;
+
+    glGenRenderbuffers(1, &window->colorRB);
+    glBindRenderbuffer(GL_RENDERBUFFER, window->colorRB);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, window->width, window->height);
+    glGenRenderbuffers(1, &window->depthRB);
+    glBindRenderbuffer(GL_RENDERBUFFER, window->depthRB);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, window->width, window->height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &window->FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, window->FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, window->colorRB);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, window->depthRB);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glViewport(0, 0, window->width, window->height);
+    glScissor(0, 0, window->width, window->height);
+}
+
+GLFWwindow* glfwGetCurrentContext(void)
+{
+    return headless.current;
+}
+
+void glfwSwapInterval(int interval)
+{
+    (void)interval;
+}
+
+int glfwExtensionSupported(const char* extension)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        if (std::strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), extension) == 0)
+            return GLFW_TRUE;
+    }
+    return GLFW_FALSE;
+}
+
+// There is nothing to present; the frame stays in the framebuffer object
+void glfwSwapBuffers(GLFWwindow* window)
+{
+    glFlush();
+    if (++headless.frames == 1)
+        headless.firstFrame = std::chrono::steady_clock::now();
+    // Once: the frames an example draws after the limit are not timed
+    if (headless.maxFrames > 0 && headless.frames == (unsigned long long)headless.maxFrames)
+    {
+        glFinish();
+        headless.lastFrame = std::chrono::steady_clock::now();
+        window->shouldClose = true;
+    }
+}
+
+double glfwGetTime(void)
+{
+    return headless.timeOffset + headless.frames / headless.fps;
+}
+
+void glfwSetTime(double time)
+{
+    headless.timeOffset = time - headless.frames / headless.fps;
+}
+
+void glfwPollEvents(void)
+{
+    GLFWwindow* window = headless.window;
+    if (!window || headless.keysSent)
+        return;
+    headless.keysSent = true;
+    if (!window->keyCallback)
+        return;
+    for (char c : headless.keys)
+    {
+        window->keyCallback(window, keyCode(c), 0, GLFW_PRESS, 0);
+        window->keyCallback(window, keyCode(c), 0, GLFW_RELEASE, 0);
+    }
+}
+
+// No event will ever arrive, so a wait is taken as the window being exposed
+void glfwWaitEvents(void)
+{
+    glfwPollEvents();
+    GLFWwindow* window = headless.window;
+    if (window && window->refreshCallback)
+        window->refreshCallback(window);
+}
+
+void glfwWaitEventsTimeout(double timeout)
+{
+    (void)timeout;
+    glfwWaitEvents();
+}
+
+void glfwPostEmptyEvent(void)
+{
+}
+
+int glfwWindowShouldClose(GLFWwindow* window)
+{
+    return window->shouldClose;
+}
+
+void glfwSetWindowShouldClose(GLFWwindow* window, int value)
+{
+    window->shouldClose = value != 0;
+}
+
+void glfwSetWindowTitle(GLFWwindow* window, const char* title)
+{
+    (void)window; (void)title;
+}
+
+void glfwGetFramebufferSize(GLFWwindow* window, int* width, int* height)
+{
+    if (width)
+        *width = window->width;
+    if (height)
+        *height = window->height;
+}
+
+void glfwGetWindowSize(GLFWwindow* window, int* width, int* height)
+{
+    glfwGetFramebufferSize(window, width, height);
+}
+
+// The cursor rests in the middle of the window
+void glfwGetCursorPos(GLFWwindow* window, double* x, double* y)
+{
+    if (x)
+        *x = window->width * 0.5;
+    if (y)
+        *y = window->height * 0.5;
+}
+
+int glfwGetKey(GLFWwindow* window, int key)
+{
+    (void)window; (void)key;
+    return GLFW_RELEASE;
+}
+
+int glfwGetMouseButton(GLFWwindow* window, int button)
+{
+    (void)window; (void)button;
+    return GLFW_RELEASE;
+}
+
+void glfwSetWindowUserPointer(GLFWwindow* window, void* pointer)
+{
+    window->userPointer = pointer;
+}
+
+void* glfwGetWindowUserPointer(GLFWwindow* window)
+{
+    return window->userPointer;
+}
+
+GLFWkeyfun glfwSetKeyCallback(GLFWwindow* window, GLFWkeyfun callback)
+{
+    GLFWkeyfun previous = window->keyCallback;
+    window->keyCallback = callback;
+    return previous;
+}
+
+GLFWmousebuttonfun glfwSetMouseButtonCallback(GLFWwindow* window, GLFWmousebuttonfun callback)
+{
+    GLFWmousebuttonfun previous = window->mouseButtonCallback;
+    window->mouseButtonCallback = callback;
+    return previous;
+}
+
+GLFWwindowrefreshfun glfwSetWindowRefreshCallback(GLFWwindow* window, GLFWwindowrefreshfun callback)
+{
+    GLFWwindowrefreshfun previous = window->refreshCallback;
+    window->refreshCallback = callback;
+    return previous;
+}
+
+} // extern "C"
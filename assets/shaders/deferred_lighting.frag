@@ -0,0 +1,48 @@
+// Deferred shading, lighting pass: the Phong loop of the forward shaders, run once
+// per visible pixel over the three main lights or, with CLUSTERED defined, over the
+// lights of the pixel's cluster. The #version line, the defines and the G-buffer
+// (and cluster) declarations are prepended by the program
+uniform vec3 camPos;
+uniform mat4 view;
+uniform float ka;
+uniform float kd;
+#ifndef CLUSTERED
+struct Light {
+    vec3 position;
+    vec3 color;
+    float intensity;
+};
+uniform Light lights[3];
+#endif
+out vec4 color;
+void main()
+{
+    GBufferSample g;
+    if (!readGBuffer(g)) discard;
+    vec3 N = g.normal;
+    vec3 V = normalize(camPos - g.position);
+    vec3 result = vec3(0.0);
+#ifdef CLUSTERED
+    uvec2 range = clusterLightRange(-(view * vec4(g.position, 1.0)).z);
+    for (uint k = 0u; k < range.y; ++k) {
+        PointLight light = pointLights[lightIndices[range.x + k]];
+        vec3 toLight = light.position - g.position;
+        float dist = length(toLight);
+        vec3 L = toLight / dist;
+        vec3 lightColor = light.color * light.intensity * lightFalloff(dist, light.radius);
+#else
+    for (int i = 0; i < 3; ++i) {
+        vec3 L = normalize(lights[i].position - g.position);
+        vec3 lightColor = lights[i].color * lights[i].intensity;
+#endif
+        vec3 ambient = ka * lightColor;
+        float diff = max(dot(N, L), 0.0);
+        vec3 diffuse = kd * diff * lightColor;
+        vec3 R = reflect(-L, N);
+        float spec = pow(max(dot(R, V), 0.0), g.q);
+        vec3 specular = g.ks * spec * lightColor;
+        result += (ambient + diffuse) * g.albedo + specular;
+    }
+    color = vec4(result, 1.0);
+    gl_FragDepth = g.depth;
+}
@@ -0,0 +1,12 @@
+// Deferred shading, geometry pass: only stores normal, albedo and the specular
+// parameters. The #version line and writeGBuffer() (cgcc/DeferredShading.h) are
+// prepended by the program
+uniform float ks;
+uniform float q;
+in vec3 vNormal;
+in vec3 vFragPos;
+in vec3 vColor;
+void main()
+{
+    writeGBuffer(vNormal, vColor, ks, q);
+}
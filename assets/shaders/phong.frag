@@ -0,0 +1,41 @@
+// Forward Phong with the main lights. The #version line and the permutation
+// defines (cgcc/ShaderPermutation.h: LIGHT_COUNT, USE_SPECULAR) are prepended by the program
+struct Light {
+    vec3 position;
+    vec3 color;
+    float intensity;
+};
+uniform Light lights[LIGHT_COUNT];
+uniform vec3 camPos;
+uniform float ka;
+uniform float kd;
+uniform float ks;
+uniform float q;
+in vec3 vNormal;
+in vec3 vFragPos;
+in vec3 vColor;
+out vec4 color;
+void main()
+{
+    vec3 N = normalize(vNormal);
+    vec3 V = normalize(camPos - vFragPos);
+    vec3 result = vec3(0.0);
+    for (int i = 0; i < LIGHT_COUNT; ++i) {
+        vec3 L = normalize(lights[i].position - vFragPos);
+        vec3 lightColor = lights[i].color * lights[i].intensity;
+        // Ambient
+        vec3 ambient = ka * lightColor;
+        // Diffuse
+        float diff = max(dot(N, L), 0.0);
+        vec3 diffuse = kd * diff * lightColor;
+        vec3 lit = (ambient + diffuse) * vColor;
+#ifdef USE_SPECULAR
+        // Specular
+        vec3 R = reflect(-L, N);
+        float spec = pow(max(dot(R, V), 0.0), q);
+        lit += ks * spec * lightColor;
+#endif
+        result += lit;
+    }
+    color = vec4(result, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 450
+// Hello3D (Atividade Vivencial 2): shared by every Phong program and by the depth prepass
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+layout (location = 2) in vec3 normal;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+out vec3 vNormal;
+out vec3 vFragPos;
+out vec3 vColor;
+invariant gl_Position; // the depth prepass reuses this shader and must match exactly
+void main()
+{
+    vec4 worldPos = model * vec4(position, 1.0);
+    gl_Position = projection * view * worldPos;
+    vFragPos = vec3(worldPos);
+    vNormal = mat3(transpose(inverse(model))) * normal;
+    vColor = color;
+}
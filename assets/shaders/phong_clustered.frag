@@ -0,0 +1,39 @@
+// Clustered forward Phong: same model as phong.frag, but it only loops over the
+// point lights assigned to the fragment's cluster. The #version line, the permutation
+// defines (USE_SPECULAR) and the cluster lookup declarations (cgcc/ClusteredLighting.h)
+// are prepended by the program
+uniform vec3 camPos;
+uniform mat4 view;
+uniform float ka;
+uniform float kd;
+uniform float ks;
+uniform float q;
+in vec3 vNormal;
+in vec3 vFragPos;
+in vec3 vColor;
+out vec4 color;
+void main()
+{
+    vec3 N = normalize(vNormal);
+    vec3 V = normalize(camPos - vFragPos);
+    vec3 result = vec3(0.0);
+    uvec2 range = clusterLightRange(-(view * vec4(vFragPos, 1.0)).z);
+    for (uint k = 0u; k < range.y; ++k) {
+        PointLight light = pointLights[lightIndices[range.x + k]];
+        vec3 toLight = light.position - vFragPos;
+        float dist = length(toLight);
+        vec3 L = toLight / dist;
+        vec3 lightColor = light.color * light.intensity * lightFalloff(dist, light.radius);
+        vec3 ambient = ka * lightColor;
+        float diff = max(dot(N, L), 0.0);
+        vec3 diffuse = kd * diff * lightColor;
+        vec3 lit = (ambient + diffuse) * vColor;
+#ifdef USE_SPECULAR
+        vec3 R = reflect(-L, N);
+        float spec = pow(max(dot(R, V), 0.0), q);
+        lit += ks * spec * lightColor;
+#endif
+        result += lit;
+    }
+    color = vec4(result, 1.0);
+}
@@ -0,0 +1,266 @@
+/* AllocTracker.h - heap allocations counted per subsystem
+ *
+ * GPUMemory.h follows what lives on the GPU; this follows operator new and
+ * delete on the CPU. Code says which subsystem it works for with a scope, and
+ * every allocation made inside it is charged to that subsystem:
+ *
+ *     #define CGCC_ALLOC_TRACKER_IMPLEMENTATION   // in one .cpp of the program
+ *     #include <cgcc/AllocTracker.h>
+ *
+ *     { CGCC_ALLOC_SCOPE("load"); ...loadSimpleOBJ... }
+ *     while (...)
+ *     {
+ *         CGCC_ALLOC_SCOPE("frame");
+ *         CGCC_ALLOC_FRAME();                 // once per frame, for the averages
+ *         ...
+ *     }
+ *     CGCC_ALLOC_REPORT(std::cout);           // before exiting
+ *
+ * For each subsystem the report gives the allocations and frees, the bytes
+ * asked for, the bytes still live and their peak, and the allocations per
+ * frame: the average, which includes warm-up, and the count in the last
+ * complete frame, which is the steady state. Allocations outside every scope
+ * go to "other". A free is charged to the subsystem that made the
+ * allocation, wherever it happens.
+ *
+ * The macros compile to nothing unless CGCC_ALLOC_TRACKING is defined (CMake
+ * option CGCC_ALLOC_TRACKING). When enabled, the file that defines
+ * CGCC_ALLOC_TRACKER_IMPLEMENTATION replaces the global operator new and
+ * delete (all of their forms) for the whole program. Each block gets a 16
+ * byte header in front with its size and subsystem, and the counters are
+ * relaxed atomics, so any thread can allocate; the current subsystem is per
+ * thread. malloc/free are not seen, and a LinearArena (Arena.h) shows up as
+ * its blocks only. Subsystem names must be string literals (only the pointer
+ * is kept), at most allocMaxSubsystems of them.
+ */
+
+#ifndef CGCC_ALLOCTRACKER_H
+#define CGCC_ALLOCTRACKER_H
+
+#ifdef CGCC_ALLOC_TRACKING
+
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace cgcc {
+
+const int allocMaxSubsystems = 32;
+
+struct AllocCounters {
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> frees{ 0 };
+    std::atomic<uint64_t> bytes{ 0 }; // ever asked for
+    std::atomic<uint64_t> live{ 0 };
+    std::atomic<uint64_t> peak{ 0 };
+    // Set by allocFrame(): allocations at the last frame start, and in the frame before it
+    uint64_t frameStart = 0;
+    uint64_t lastFrame = 0;
+};
+
+// Everything here is constant-initialized, so it works before main() and
+// from any static constructor that allocates. CGCC_ALLOC_FRAME() is called
+// from one thread
+struct AllocTrackerState {
+    AllocCounters counters[allocMaxSubsystems];
+    const char* names[allocMaxSubsystems] = { "other" };
+    std::atomic<int> subsystems{ 1 };
+    std::atomic<uint64_t> frames{ 0 };
+    std::mutex mutex; // registering names
+};
+
+inline AllocTrackerState allocTrackerState;
+inline thread_local int allocCurrentSubsystem = 0;
+
+// The id of a subsystem, registered on first use
+inline int allocSubsystem(const char* name)
+{
+    AllocTrackerState& state = allocTrackerState;
+    std::lock_guard<std::mutex> lock(state.mutex);
+    int count = state.subsystems.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++)
+        if (std::strcmp(state.names[i], name) == 0)
+            return i;
+    if (count == allocMaxSubsystems)
+        return 0;
+    state.names[count] = name;
+    state.subsystems.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+struct AllocScope {
+    int previous;
+    explicit AllocScope(int subsystem) : previous(allocCurrentSubsystem) { allocCurrentSubsystem = subsystem; }
+    ~AllocScope() { allocCurrentSubsystem = previous; }
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+};
+
+// In front of every tracked block, right before the pointer handed out
+struct AllocHeader {
+    uint64_t size;
+    uint32_t subsystem;
+    uint32_t offset; // from the start of the malloc'ed block
+};
+static_assert(sizeof(AllocHeader) == 16, "AllocHeader must keep blocks 16-byte aligned");
+
+inline void* allocTracked(size_t size, size_t align)
+{
+    if (align < sizeof(AllocHeader))
+        align = sizeof(AllocHeader);
+    uint8_t* raw = static_cast<uint8_t*>(std::malloc(size + sizeof(AllocHeader) + align - 1));
+    if (!raw)
+        return nullptr;
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw) + sizeof(AllocHeader);
+    uint8_t* user = reinterpret_cast<uint8_t*>((start + align - 1) & ~(uintptr_t)(align - 1));
+
+    int subsystem = allocCurrentSubsystem;
+    AllocHeader* header = reinterpret_cast<AllocHeader*>(user) - 1;
+    header->size = size;
+    header->subsystem = (uint32_t)subsystem;
+    header->offset = (uint32_t)(user - raw);
+
+    AllocCounters& counters = allocTrackerState.counters[subsystem];
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    uint64_t live = counters.live.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = counters.peak.load(std::memory_order_relaxed);
+    while (live > peak && !counters.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        ;
+    return user;
+}
+
+inline void freeTracked(void* pointer)
+{
+    if (!pointer)
+        return;
+    AllocHeader* header = static_cast<AllocHeader*>(pointer) - 1;
+    AllocCounters& counters = allocTrackerState.counters[header->subsystem];
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.live.fetch_sub(header->size, std::memory_order_relaxed);
+    std::free(static_cast<uint8_t*>(pointer) - header->offset);
+}
+
+inline void allocFrame()
+{
+    AllocTrackerState& state = allocTrackerState;
+    state.frames.fetch_add(1, std::memory_order_relaxed);
+    int count = state.subsystems.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+        AllocCounters& counters = state.counters[i];
+        uint64_t allocations = counters.allocations.load(std::memory_order_relaxed);
+        counters.lastFrame = allocations - counters.frameStart;
+        counters.frameStart = allocations;
+    }
+}
+
+inline void allocBytesText(std::ostream& out, uint64_t bytes)
+{
+    if (bytes >= 1024 * 1024)
+        out << std::fixed << std::setprecision(1) << bytes / (1024.0 * 1024.0) << " MB";
+    else if (bytes >= 1024)
+        out << std::fixed << std::setprecision(0) << bytes / 1024.0 << " KB";
+    else
+        out << bytes << " B";
+}
+
+inline void reportAllocations(std::ostream& out)
+{
+    AllocTrackerState& state = allocTrackerState;
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    uint64_t frames = state.frames.load(std::memory_order_relaxed);
+    out << "CPU heap per subsystem (" << frames << " frames):" << std::endl;
+    int count = state.subsystems.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+        const AllocCounters& counters = state.counters[i];
+        uint64_t allocations = counters.allocations.load(std::memory_order_relaxed);
+        out << "  " << std::left << std::setw(12) << state.names[i] << std::right << std::setw(10) << allocations << " allocs "
+            << std::setw(10) << counters.frees.load(std::memory_order_relaxed) << " frees  ";
+        allocBytesText(out, counters.bytes.load(std::memory_order_relaxed));
+        out << " total, ";
+        allocBytesText(out, counters.live.load(std::memory_order_relaxed));
+        out << " live, ";
+        allocBytesText(out, counters.peak.load(std::memory_order_relaxed));
+        out << " peak";
+        if (frames > 0)
+            out << ", " << std::fixed << std::setprecision(1) << (double)allocations / frames << " allocs/frame (" << counters.lastFrame << " in the last)";
+        out << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace cgcc
+
+#ifdef CGCC_ALLOC_TRACKER_IMPLEMENTATION
+
+// Kept out of line: once the compiler inlines a replaced operator delete into
+// its callers it warns about the header read in front of the pointer
+#if defined(_MSC_VER)
+#define CGCC_ALLOC_NOINLINE __declspec(noinline)
+#else
+#define CGCC_ALLOC_NOINLINE __attribute__((noinline))
+#endif
+
+CGCC_ALLOC_NOINLINE void* operator new(std::size_t size)
+{
+    void* pointer = cgcc::allocTracked(size, alignof(std::max_align_t));
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+CGCC_ALLOC_NOINLINE void* operator new[](std::size_t size) { return operator new(size); }
+CGCC_ALLOC_NOINLINE void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return cgcc::allocTracked(size, alignof(std::max_align_t)); }
+CGCC_ALLOC_NOINLINE void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return cgcc::allocTracked(size, alignof(std::max_align_t)); }
+CGCC_ALLOC_NOINLINE void* operator new(std::size_t size, std::align_val_t align)
+{
+    void* pointer = cgcc::allocTracked(size, (std::size_t)align);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+CGCC_ALLOC_NOINLINE void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+CGCC_ALLOC_NOINLINE void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return cgcc::allocTracked(size, (std::size_t)align); }
+CGCC_ALLOC_NOINLINE void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return cgcc::allocTracked(size, (std::size_t)align); }
+
+CGCC_ALLOC_NOINLINE void operator delete(void* pointer) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete[](void* pointer) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete(void* pointer, std::size_t) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete[](void* pointer, std::size_t) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete(void* pointer, const std::nothrow_t&) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete[](void* pointer, const std::nothrow_t&) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete(void* pointer, std::align_val_t) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete[](void* pointer, std::align_val_t) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { cgcc::freeTracked(pointer); }
+CGCC_ALLOC_NOINLINE void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { cgcc::freeTracked(pointer); }
+
+#endif // CGCC_ALLOC_TRACKER_IMPLEMENTATION
+
+#define CGCC_ALLOC_CONCAT_(a, b) a##b
+#define CGCC_ALLOC_CONCAT(a, b) CGCC_ALLOC_CONCAT_(a, b)
+#define CGCC_ALLOC_SCOPE(name)                                                                       \
+    static const int CGCC_ALLOC_CONCAT(cgccAllocSubsystem, __LINE__) = ::cgcc::allocSubsystem(name); \
+    ::cgcc::AllocScope CGCC_ALLOC_CONCAT(cgccAllocScope, __LINE__)(CGCC_ALLOC_CONCAT(cgccAllocSubsystem, __LINE__))
+#define CGCC_ALLOC_FRAME() ::cgcc::allocFrame()
+#define CGCC_ALLOC_REPORT(out) ::cgcc::reportAllocations(out)
+
+#else
+
+#define CGCC_ALLOC_SCOPE(name) ((void)0)
+#define CGCC_ALLOC_FRAME() ((void)0)
+#define CGCC_ALLOC_REPORT(out) ((void)0)
+
+#endif // CGCC_ALLOC_TRACKING
+
+#endif // CGCC_ALLOCTRACKER_H
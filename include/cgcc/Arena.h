@@ -0,0 +1,165 @@
+/* Arena.h - scratch memory handed out by bumping a pointer
+ *
+ * Loading a model or building a frame makes many short-lived arrays. A
+ * LinearArena serves them from a few large blocks and frees them all at once:
+ *
+ *     cgcc::LinearArena scratch;
+ *     float* values = scratch.allocate<float>(count);     // no free
+ *     std::vector<int, cgcc::ArenaAllocator<int>> list{ cgcc::ArenaAllocator<int>(scratch) };
+ *     ...
+ *     scratch.reset();                                     // everything at once
+ *
+ * When a block is full another one is added, at least twice the size of the
+ * last. reset() keeps a single block as large as all of them together, so an
+ * arena reset every load or every frame stops calling the heap once it has
+ * seen its largest load or frame.
+ *
+ * FrameArena is two of them used on alternate frames: what was allocated in
+ * frame N is still valid during frame N + 1 (e.g. data still being uploaded),
+ * and is reused in frame N + 2.
+ *
+ * Blocks come from operator new, so AllocTracker.h sees an arena as the few
+ * allocations of its blocks, charged to the subsystem that grew it.
+ *
+ * Destructors of objects placed in an arena are not run, and
+ * ArenaAllocator::deallocate does nothing, so keep to trivially destructible
+ * data or containers that do not outlive the arena's next reset.
+ */
+
+#ifndef CGCC_ARENA_H
+#define CGCC_ARENA_H
+
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+
+namespace cgcc {
+
+struct LinearArena {
+    struct Block {
+        uint8_t* data;
+        size_t size;
+        size_t used;
+    };
+    std::vector<Block> blocks;
+    size_t minBlockSize;
+    size_t highWater = 0; // most bytes handed out between two resets
+
+    explicit LinearArena(size_t blockSize = 64 * 1024) : minBlockSize(blockSize) {}
+    ~LinearArena()
+    {
+        for (Block& block : blocks)
+            ::operator delete(block.data);
+    }
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        if (!blocks.empty())
+        {
+            Block& block = blocks.back();
+            size_t start = (block.used + align - 1) & ~(align - 1);
+            if (start + bytes <= block.size)
+            {
+                block.used = start + bytes;
+                return block.data + start;
+            }
+        }
+        size_t size = blocks.empty() ? minBlockSize : blocks.back().size * 2;
+        while (size < bytes + align)
+            size *= 2;
+        addBlock(size);
+        return allocate(bytes, align);
+    }
+
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    size_t used() const
+    {
+        size_t total = 0;
+        for (const Block& block : blocks)
+            total += block.used;
+        return total;
+    }
+
+    size_t capacity() const
+    {
+        size_t total = 0;
+        for (const Block& block : blocks)
+            total += block.size;
+        return total;
+    }
+
+    // Frees everything; several blocks become one that holds them all
+    void reset()
+    {
+        highWater = std::max(highWater, used());
+        if (blocks.size() > 1)
+        {
+            size_t total = capacity();
+            for (Block& block : blocks)
+                ::operator delete(block.data);
+            blocks.clear();
+            addBlock(total);
+        }
+        for (Block& block : blocks)
+            block.used = 0;
+    }
+
+private:
+    void addBlock(size_t size)
+    {
+        uint8_t* data = static_cast<uint8_t*>(::operator new(size));
+        blocks.push_back({ data, size, 0 });
+    }
+};
+
+// Two arenas used on alternate frames; beginFrame() resets and returns this frame's one
+struct FrameArena {
+    LinearArena arenas[2];
+    int current = 0;
+
+    explicit FrameArena(size_t blockSize = 64 * 1024) : arenas{ LinearArena(blockSize), LinearArena(blockSize) } {}
+
+    LinearArena& beginFrame()
+    {
+        current ^= 1;
+        arenas[current].reset();
+        return arenas[current];
+    }
+
+    LinearArena& frame() { return arenas[current]; }
+};
+
+// Standard allocator over an arena, for std::vector and friends
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+    LinearArena* arena;
+
+    explicit ArenaAllocator(LinearArena& a) : arena(&a) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return arena->allocate<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace cgcc
+
+#endif // CGCC_ARENA_H
@@ -0,0 +1,243 @@
+/* AsyncShader.h - background shader compilation with hot reload from files
+ *
+ * An AsyncProgram is described by its stages; each stage is a prelude string
+ * (#version line, defines, GLSL chunks from the other cgcc headers) followed by
+ * the contents of a file. submitAsyncProgram() only issues glCompileShader and
+ * glLinkProgram and never reads a status back, so it does not wait on the
+ * driver. pollAsyncProgram(), called once per frame, finishes the link when it
+ * is done:
+ *   - with GL_KHR_parallel_shader_compile the driver compiles on its own
+ *     threads and GL_COMPLETION_STATUS_KHR is polled until it reports true;
+ *   - without it, the status is read one frame after submission, which gives
+ *     drivers that compile lazily or on a worker thread time to finish (the
+ *     read may still wait on drivers that do neither).
+ * Until the first link succeeds `program` stays 0 and the caller draws with a
+ * fallback program.
+ *
+ * The files are checked for edits every watchInterval seconds; an edit
+ * relinks the program in the background and it is swapped in once linked.
+ * A broken edit prints the compile log and keeps the previous program.
+ * Programs found in the binary cache (ProgramCache.h) are ready at once.
+ */
+
+#ifndef CGCC_ASYNCSHADER_H
+#define CGCC_ASYNCSHADER_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "GLExt.h"
+#include "Shader.h"
+#include "ProgramCache.h"
+#include "Trace.h"
+
+namespace cgcc {
+
+struct ShaderStageSource {
+    GLenum type;
+    std::string prelude; // prepended to the file contents
+    std::string path;    // watched source file; empty for a prelude-only stage
+};
+
+struct AsyncProgram {
+    std::vector<ShaderStageSource> stages;
+    GLuint program = 0; // last program that linked successfully, 0 until then
+    bool swapped = false; // program changed since the last poll
+
+    // Submission in flight
+    GLuint pending = 0;
+    std::vector<GLuint> pendingShaders;
+    uint64_t pendingKey = 0;
+    int pendingFrames = 0;
+
+    // File watching
+    std::vector<std::filesystem::path> watched; // stage paths, parsed once
+    std::vector<std::filesystem::file_time_type> stamps;
+    double nextWatchTime = 0.0;
+    double watchInterval = 0.5;
+};
+
+inline bool asyncProgramReady(const AsyncProgram& p)
+{
+    return p.program != 0;
+}
+
+inline bool readShaderFile(const std::string& path, std::string& out)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+inline std::filesystem::file_time_type shaderFileStamp(const std::filesystem::path& path)
+{
+    std::error_code error;
+    auto stamp = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type::min() : stamp;
+}
+
+inline void discardPendingProgram(AsyncProgram& p)
+{
+    for (GLuint shader : p.pendingShaders)
+        glDeleteShader(shader);
+    p.pendingShaders.clear();
+    if (p.pending)
+        glDeleteProgram(p.pending);
+    p.pending = 0;
+}
+
+// Replaces the current program with a newly linked one
+inline void swapInProgram(AsyncProgram& p, GLuint program)
+{
+    if (p.program)
+        glDeleteProgram(p.program);
+    p.program = program;
+    p.swapped = true;
+}
+
+// Reads the files and starts compiling (or restores the program from the binary cache)
+inline void submitAsyncProgram(AsyncProgram& p)
+{
+    CGCC_TRACE_ZONE("submit shader program");
+    discardPendingProgram(p);
+
+    std::vector<std::string> parts;
+    for (const ShaderStageSource& stage : p.stages)
+    {
+        std::string body;
+        if (!stage.path.empty() && !readShaderFile(stage.path, body))
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << stage.path << std::endl;
+            return;
+        }
+        parts.push_back(stage.prelude);
+        parts.push_back(body);
+    }
+    std::vector<const GLchar*> strings;
+    for (const std::string& part : parts)
+        strings.push_back(part.c_str());
+
+    p.pendingKey = programCacheKey(strings);
+    if (GLuint cached = loadCachedProgram(p.pendingKey))
+    {
+        swapInProgram(p, cached);
+        return;
+    }
+
+    p.pending = glCreateProgram();
+    markProgramRetrievable(p.pending);
+    for (size_t i = 0; i < p.stages.size(); ++i)
+    {
+        GLuint shader = glCreateShader(p.stages[i].type);
+        glShaderSource(shader, 2, &strings[2 * i], NULL);
+        glCompileShader(shader);
+        glAttachShader(p.pending, shader);
+        p.pendingShaders.push_back(shader);
+    }
+    glLinkProgram(p.pending);
+    p.pendingFrames = 0;
+}
+
+inline void beginAsyncProgram(AsyncProgram& p, std::vector<ShaderStageSource> stages)
+{
+    p.stages = std::move(stages);
+    p.watched.clear();
+    p.stamps.clear();
+    for (const ShaderStageSource& stage : p.stages)
+    {
+        p.watched.emplace_back(stage.path);
+        p.stamps.push_back(shaderFileStamp(p.watched.back()));
+    }
+    submitAsyncProgram(p);
+}
+
+// Called once per frame; returns true when `program` changed (uniform
+// locations must be fetched again)
+inline bool pollAsyncProgram(AsyncProgram& p, double now)
+{
+    if (now >= p.nextWatchTime)
+    {
+        p.nextWatchTime = now + p.watchInterval;
+        bool edited = false;
+        for (size_t i = 0; i < p.stages.size(); ++i)
+        {
+            if (p.stages[i].path.empty()) continue;
+            auto stamp = shaderFileStamp(p.watched[i]);
+            if (stamp != p.stamps[i])
+            {
+                p.stamps[i] = stamp;
+                edited = true;
+            }
+        }
+        if (edited)
+            submitAsyncProgram(p);
+    }
+
+    bool ready = p.pending != 0;
+    if (ready && glCaps.parallelShaderCompile)
+    {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(p.pending, GL_COMPLETION_STATUS_KHR, &completed);
+        ready = completed == GL_TRUE;
+    }
+    else if (ready)
+    {
+        ready = p.pendingFrames++ >= 1;
+    }
+
+    if (ready)
+    {
+        GLint success = GL_FALSE;
+        glGetProgramiv(p.pending, GL_LINK_STATUS, &success);
+        if (success)
+        {
+            GLuint linked = p.pending;
+            p.pending = 0;
+            discardPendingProgram(p); // only the shaders are left
+            storeCachedProgram(p.pendingKey, linked);
+            swapInProgram(p, linked);
+        }
+        else
+        {
+            // Report every stage that failed, then the link log; the previous program stays
+            GLchar infoLog[512];
+            for (size_t i = 0; i < p.pendingShaders.size(); ++i)
+            {
+                GLint compiled = GL_FALSE;
+                glGetShaderiv(p.pendingShaders[i], GL_COMPILE_STATUS, &compiled);
+                if (!compiled)
+                {
+                    glGetShaderInfoLog(p.pendingShaders[i], 512, NULL, infoLog);
+                    std::cout << "ERROR::SHADER::" << shaderStageName(p.stages[i].type) << "::COMPILATION_FAILED " << p.stages[i].path << "\n" << infoLog << std::endl;
+                }
+            }
+            glGetProgramInfoLog(p.pending, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            discardPendingProgram(p);
+        }
+    }
+
+    bool changed = p.swapped;
+    p.swapped = false;
+    return changed;
+}
+
+inline void destroyAsyncProgram(AsyncProgram& p)
+{
+    discardPendingProgram(p);
+    if (p.program)
+        glDeleteProgram(p.program);
+    p.program = 0;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_ASYNCSHADER_H
@@ -0,0 +1,497 @@
+/* BlockCompression.h - CPU encoders for BC1, BC3 and BC7 texture blocks
+ *
+ * Block-compressed textures stay compressed in video memory and are decoded by
+ * the texture units, 4x4 texels at a time:
+ *   BC1  8 bytes/block (4 bpp)  RGB, two 565 endpoints + 2-bit indices
+ *   BC3 16 bytes/block (8 bpp)  BC1 color + a BC4 alpha block (8 alpha levels)
+ *   BC7 16 bytes/block (8 bpp)  RGBA, here always mode 6: one pair of RGBA
+ *                               endpoints (7 bits + shared p-bit) and 4-bit indices
+ * compared with 32 bpp for RGBA8, i.e. 8x (BC1) or 4x (BC3/BC7) less memory.
+ *
+ * Each block is fitted along the principal axis of its colors, then the
+ * endpoints are refined once by least squares. The nearest-palette search,
+ * where most of the time goes, runs 4 texels at a time with SSE2 when the
+ * compiler targets it and falls back to the same math in scalar code.
+ *
+ * This is an offline encoder (see src/Tools/TexCompress.cpp): quality is
+ * reasonable, speed is a few seconds for a large texture, not real time.
+ */
+
+#ifndef CGCC_BLOCKCOMPRESSION_H
+#define CGCC_BLOCKCOMPRESSION_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CGCC_BC_SSE2 1
+#endif
+
+namespace cgcc {
+
+enum class BlockFormat { BC1, BC3, BC7 };
+
+inline int blockBytes(BlockFormat format)
+{
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+inline size_t compressedImageSize(BlockFormat format, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+}
+
+// 16 texels of a block, one row of floats per channel (RGBA) so the search can
+// load 4 texels of a channel at once
+struct BlockTexels {
+    float c[4][16];
+};
+
+// Reads block (bx, by) of an RGBA8 image; texels past the border repeat the last row/column
+inline void loadBlock(const uint8_t* rgba, int width, int height, int bx, int by, BlockTexels& block)
+{
+    for (int y = 0; y < 4; ++y)
+    {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; ++x)
+        {
+            int sx = std::min(bx * 4 + x, width - 1);
+            const uint8_t* texel = rgba + ((size_t)sy * width + sx) * 4;
+            for (int ch = 0; ch < 4; ++ch)
+                block.c[ch][y * 4 + x] = texel[ch];
+        }
+    }
+}
+
+// For each texel, the index of the nearest palette entry (weighted squared
+// distance over 4 channels); returns the total error
+inline float nearestIndices(const BlockTexels& block, const float (*palette)[4], int count, const float weights[4], uint8_t indices[16])
+{
+    float total = 0.0f;
+#ifdef CGCC_BC_SSE2
+    for (int group = 0; group < 4; ++group)
+    {
+        __m128 texel[4];
+        for (int ch = 0; ch < 4; ++ch)
+            texel[ch] = _mm_loadu_ps(&block.c[ch][group * 4]);
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128 bestIndex = _mm_setzero_ps();
+        for (int k = 0; k < count; ++k)
+        {
+            __m128 d = _mm_setzero_ps();
+            for (int ch = 0; ch < 4; ++ch)
+            {
+                __m128 t = _mm_sub_ps(texel[ch], _mm_set1_ps(palette[k][ch]));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_mul_ps(t, t), _mm_set1_ps(weights[ch])));
+            }
+            __m128 less = _mm_cmplt_ps(d, best);
+            best = _mm_min_ps(d, best);
+            bestIndex = _mm_or_ps(_mm_and_ps(less, _mm_set1_ps((float)k)), _mm_andnot_ps(less, bestIndex));
+        }
+        float index[4], error[4];
+        _mm_storeu_ps(index, bestIndex);
+        _mm_storeu_ps(error, best);
+        for (int j = 0; j < 4; ++j)
+        {
+            indices[group * 4 + j] = (uint8_t)index[j];
+            total += error[j];
+        }
+    }
+#else
+    for (int group = 0; group < 4; ++group)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            int i = group * 4 + j;
+            float best = FLT_MAX;
+            int bestIndex = 0;
+            for (int k = 0; k < count; ++k)
+            {
+                float d = 0.0f;
+                for (int ch = 0; ch < 4; ++ch)
+                {
+                    float t = block.c[ch][i] - palette[k][ch];
+                    d = d + (t * t) * weights[ch];
+                }
+                if (d < best)
+                {
+                    best = d;
+                    bestIndex = k;
+                }
+            }
+            indices[i] = (uint8_t)bestIndex;
+            total += best;
+        }
+    }
+#endif
+    return total;
+}
+
+// Endpoints at the extremes of the block along its principal axis (first `channels` channels)
+inline void principalEndpoints(const BlockTexels& block, int channels, float lo[4], float hi[4])
+{
+    float mean[4] = { 0, 0, 0, 0 };
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        for (int i = 0; i < 16; ++i) mean[ch] += block.c[ch][i];
+        mean[ch] /= 16.0f;
+    }
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int a = 0; a < channels; ++a)
+            for (int b = 0; b < channels; ++b)
+                cov[a][b] += (block.c[a][i] - mean[a]) * (block.c[b][i] - mean[b]);
+    }
+    // Power iteration, starting from the bounding box diagonal
+    float axis[4] = { 0, 0, 0, 0 };
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        float mn = *std::min_element(block.c[ch], block.c[ch] + 16);
+        float mx = *std::max_element(block.c[ch], block.c[ch] + 16);
+        axis[ch] = mx - mn;
+    }
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[4] = { 0, 0, 0, 0 };
+        float length = 0.0f;
+        for (int a = 0; a < channels; ++a)
+        {
+            for (int b = 0; b < channels; ++b) next[a] += cov[a][b] * axis[b];
+            length = std::max(length, std::fabs(next[a]));
+        }
+        if (length == 0.0f) break;
+        for (int a = 0; a < channels; ++a) axis[a] = next[a] / length;
+    }
+    float tMin = FLT_MAX, tMax = -FLT_MAX;
+    float norm = 0.0f;
+    for (int ch = 0; ch < channels; ++ch) norm += axis[ch] * axis[ch];
+    if (norm == 0.0f) tMin = tMax = 0.0f; // flat block
+    else
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = 0.0f;
+            for (int ch = 0; ch < channels; ++ch) t += (block.c[ch][i] - mean[ch]) * axis[ch];
+            t /= norm;
+            tMin = std::min(tMin, t);
+            tMax = std::max(tMax, t);
+        }
+    }
+    for (int ch = 0; ch < 4; ++ch)
+    {
+        lo[ch] = ch < channels ? std::clamp(mean[ch] + tMin * axis[ch], 0.0f, 255.0f) : 255.0f;
+        hi[ch] = ch < channels ? std::clamp(mean[ch] + tMax * axis[ch], 0.0f, 255.0f) : 255.0f;
+    }
+}
+
+// Least-squares endpoints for the chosen indices; weight[k] is how far palette
+// entry k lies from endpoint 0 (0) to endpoint 1 (1). Returns false if singular
+inline bool refineEndpoints(const BlockTexels& block, int channels, const uint8_t indices[16], const float* weight, float e0[4], float e1[4])
+{
+    float a = 0, b = 0, c = 0;
+    float x0[4] = { 0, 0, 0, 0 }, x1[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 16; ++i)
+    {
+        float t = weight[indices[i]];
+        a += (1 - t) * (1 - t);
+        b += (1 - t) * t;
+        c += t * t;
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            x0[ch] += (1 - t) * block.c[ch][i];
+            x1[ch] += t * block.c[ch][i];
+        }
+    }
+    float det = a * c - b * b;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        e0[ch] = std::clamp((c * x0[ch] - b * x1[ch]) / det, 0.0f, 255.0f);
+        e1[ch] = std::clamp((a * x1[ch] - b * x0[ch]) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+// Little-endian bit packing for the block layouts
+inline void putBits(uint8_t* out, int& position, uint32_t value, int count)
+{
+    for (int i = 0; i < count; ++i, ++position)
+    {
+        if (value & (1u << i))
+            out[position >> 3] |= (uint8_t)(1u << (position & 7));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// BC1
+// ---------------------------------------------------------------------------
+
+inline uint16_t packRGB565(const float c[4])
+{
+    int r = (int)std::lround(c[0] * 31.0f / 255.0f);
+    int g = (int)std::lround(c[1] * 63.0f / 255.0f);
+    int b = (int)std::lround(c[2] * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRGB565(uint16_t v, float c[4])
+{
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    c[0] = (float)((r << 3) | (r >> 2));
+    c[1] = (float)((g << 2) | (g >> 4));
+    c[2] = (float)((b << 3) | (b >> 2));
+    c[3] = 255.0f;
+}
+
+// Quantizes the endpoints and picks the indices (4-color mode); returns the error
+inline float fitBC1(const BlockTexels& block, const float e0[4], const float e1[4], uint16_t& c0, uint16_t& c1, uint8_t indices[16])
+{
+    static const float weights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+    c0 = packRGB565(e0);
+    c1 = packRGB565(e1);
+    if (c0 < c1) std::swap(c0, c1);
+    if (c0 == c1)
+    {
+        // Single color: every texel uses endpoint 0
+        float palette[1][4];
+        unpackRGB565(c0, palette[0]);
+        uint8_t unused[16];
+        std::memset(indices, 0, 16);
+        return nearestIndices(block, palette, 1, weights, unused);
+    }
+    float palette[4][4];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int ch = 0; ch < 4; ++ch)
+    {
+        palette[2][ch] = (2.0f * palette[0][ch] + palette[1][ch]) / 3.0f;
+        palette[3][ch] = (palette[0][ch] + 2.0f * palette[1][ch]) / 3.0f;
+    }
+    return nearestIndices(block, palette, 4, weights, indices);
+}
+
+inline void encodeBC1Block(const BlockTexels& block, uint8_t out[8])
+{
+    // Fraction of the way from color0 to color1 of each index
+    static const float bc1Weight[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    float lo[4], hi[4];
+    principalEndpoints(block, 3, lo, hi);
+
+    uint16_t c0, c1;
+    uint8_t indices[16];
+    float error = fitBC1(block, hi, lo, c0, c1, indices);
+
+    float e0[4], e1[4];
+    if (c0 != c1)
+    {
+        unpackRGB565(c0, e0);
+        unpackRGB565(c1, e1);
+        if (refineEndpoints(block, 3, indices, bc1Weight, e0, e1))
+        {
+            uint16_t r0, r1;
+            uint8_t refined[16];
+            if (fitBC1(block, e0, e1, r0, r1, refined) < error)
+            {
+                c0 = r0;
+                c1 = r1;
+                std::memcpy(indices, refined, 16);
+            }
+        }
+    }
+
+    std::memset(out, 0, 8);
+    out[0] = (uint8_t)(c0 & 0xFF); out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)(c1 & 0xFF); out[3] = (uint8_t)(c1 >> 8);
+    int position = 32;
+    for (int i = 0; i < 16; ++i)
+        putBits(out, position, indices[i], 2);
+}
+
+// ---------------------------------------------------------------------------
+// BC3 = BC4 alpha block followed by a BC1 color block
+// ---------------------------------------------------------------------------
+
+inline void encodeBC4AlphaBlock(const BlockTexels& block, uint8_t out[8])
+{
+    float mn = *std::min_element(block.c[3], block.c[3] + 16);
+    float mx = *std::max_element(block.c[3], block.c[3] + 16);
+    int a0 = (int)std::lround(mx), a1 = (int)std::lround(mn);
+    std::memset(out, 0, 8);
+    out[0] = (uint8_t)a0;
+    out[1] = (uint8_t)a1;
+    if (a0 == a1)
+        return; // all indices 0
+
+    // 8-level mode (a0 > a1): index 0 = a0, 1 = a1, 2..7 interpolate from a0 to a1
+    float levels[8];
+    levels[0] = (float)a0;
+    levels[1] = (float)a1;
+    for (int i = 2; i < 8; ++i)
+        levels[i] = (float)(((8 - i) * a0 + (i - 1) * a1) / 7);
+    int position = 16;
+    for (int i = 0; i < 16; ++i)
+    {
+        int best = 0;
+        for (int k = 1; k < 8; ++k)
+        {
+            if (std::fabs(block.c[3][i] - levels[k]) < std::fabs(block.c[3][i] - levels[best]))
+                best = k;
+        }
+        putBits(out, position, (uint32_t)best, 3);
+    }
+}
+
+inline void encodeBC3Block(const BlockTexels& block, uint8_t out[16])
+{
+    encodeBC4AlphaBlock(block, out);
+    encodeBC1Block(block, out + 8);
+}
+
+// ---------------------------------------------------------------------------
+// BC7 mode 6
+// ---------------------------------------------------------------------------
+
+const int bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 7-bit endpoint + p-bit closest to an RGBA color
+inline void quantizeBC7Endpoint(const float c[4], int q[4], int& p)
+{
+    float bestError = FLT_MAX;
+    for (int bit = 0; bit < 2; ++bit)
+    {
+        int candidate[4];
+        float error = 0.0f;
+        for (int ch = 0; ch < 4; ++ch)
+        {
+            candidate[ch] = std::clamp((int)std::lround((c[ch] - bit) / 2.0f), 0, 127);
+            float d = (float)(candidate[ch] * 2 + bit) - c[ch];
+            error += d * d;
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            p = bit;
+            std::copy(candidate, candidate + 4, q);
+        }
+    }
+}
+
+inline float fitBC7Mode6(const BlockTexels& block, const float e0[4], const float e1[4], int q0[4], int q1[4], int& p0, int& p1, uint8_t indices[16])
+{
+    static const float weights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    quantizeBC7Endpoint(e0, q0, p0);
+    quantizeBC7Endpoint(e1, q1, p1);
+    float palette[16][4];
+    for (int k = 0; k < 16; ++k)
+    {
+        for (int ch = 0; ch < 4; ++ch)
+        {
+            int a = q0[ch] * 2 + p0, b = q1[ch] * 2 + p1;
+            palette[k][ch] = (float)(((64 - bc7Weights4[k]) * a + bc7Weights4[k] * b + 32) >> 6);
+        }
+    }
+    return nearestIndices(block, palette, 16, weights, indices);
+}
+
+inline void encodeBC7Block(const BlockTexels& block, uint8_t out[16])
+{
+    float lo[4], hi[4];
+    principalEndpoints(block, 4, lo, hi);
+
+    int q0[4], q1[4], p0 = 0, p1 = 0;
+    uint8_t indices[16];
+    float error = fitBC7Mode6(block, lo, hi, q0, q1, p0, p1, indices);
+
+    float weight[16];
+    for (int k = 0; k < 16; ++k) weight[k] = bc7Weights4[k] / 64.0f;
+    float e0[4], e1[4];
+    for (int ch = 0; ch < 4; ++ch)
+    {
+        e0[ch] = (float)(q0[ch] * 2 + p0);
+        e1[ch] = (float)(q1[ch] * 2 + p1);
+    }
+    if (refineEndpoints(block, 4, indices, weight, e0, e1))
+    {
+        int r0[4], r1[4], rp0 = 0, rp1 = 0;
+        uint8_t refined[16];
+        if (fitBC7Mode6(block, e0, e1, r0, r1, rp0, rp1, refined) < error)
+        {
+            std::copy(r0, r0 + 4, q0);
+            std::copy(r1, r1 + 4, q1);
+            p0 = rp0;
+            p1 = rp1;
+            std::memcpy(indices, refined, 16);
+        }
+    }
+
+    // The anchor (texel 0) index is stored with 3 bits: its top bit must be 0
+    if (indices[0] & 8)
+    {
+        for (int ch = 0; ch < 4; ++ch) std::swap(q0[ch], q1[ch]);
+        std::swap(p0, p1);
+        for (int i = 0; i < 16; ++i) indices[i] = (uint8_t)(15 - indices[i]);
+    }
+
+    std::memset(out, 0, 16);
+    int position = 0;
+    putBits(out, position, 1u << 6, 7); // mode 6
+    for (int ch = 0; ch < 4; ++ch)
+    {
+        putBits(out, position, (uint32_t)q0[ch], 7);
+        putBits(out, position, (uint32_t)q1[ch], 7);
+    }
+    putBits(out, position, (uint32_t)p0, 1);
+    putBits(out, position, (uint32_t)p1, 1);
+    putBits(out, position, indices[0], 3);
+    for (int i = 1; i < 16; ++i)
+        putBits(out, position, indices[i], 4);
+}
+
+// ---------------------------------------------------------------------------
+// Whole images
+// ---------------------------------------------------------------------------
+
+// Compresses an RGBA8 image; blocks are stored row by row
+inline std::vector<uint8_t> compressImage(BlockFormat format, const uint8_t* rgba, int width, int height)
+{
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    int size = blockBytes(format);
+    std::vector<uint8_t> data((size_t)blocksX * blocksY * size);
+    BlockTexels block;
+    for (int by = 0; by < blocksY; ++by)
+    {
+        for (int bx = 0; bx < blocksX; ++bx)
+        {
+            loadBlock(rgba, width, height, bx, by, block);
+            uint8_t* out = &data[((size_t)by * blocksX + bx) * size];
+            switch (format)
+            {
+            case BlockFormat::BC1: encodeBC1Block(block, out); break;
+            case BlockFormat::BC3: encodeBC3Block(block, out); break;
+            case BlockFormat::BC7: encodeBC7Block(block, out); break;
+            }
+        }
+    }
+    return data;
+}
+
+inline bool imageHasAlpha(const uint8_t* rgba, int width, int height)
+{
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        if (rgba[i * 4 + 3] != 255)
+            return true;
+    }
+    return false;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_BLOCKCOMPRESSION_H
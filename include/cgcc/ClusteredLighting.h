@@ -0,0 +1,281 @@
+/* ClusteredLighting.h - clustered forward shading for many point lights
+ *
+ * The view frustum is split into a grid of clusters ("froxels"): screen tiles
+ * in x/y and exponentially spaced slices in depth. Every frame the CPU assigns
+ * each point light to the clusters its sphere of influence touches and uploads
+ * three shader storage buffers:
+ *
+ *   binding 0: PointLight lights[]     - all lights, world space
+ *   binding 1: uvec2 clusterRanges[]   - (offset, count) into lightIndices per cluster
+ *   binding 2: uint lightIndices[]     - light indices grouped by cluster
+ *
+ * A fragment shader includes clusteredLightingGLSL, calls clusterLightRange()
+ * with its view-space depth and loops only over the lights of its cluster.
+ * Requires GL 4.3 (glCaps.storageBuffers).
+ */
+
+#ifndef CGCC_CLUSTEREDLIGHTING_H
+#define CGCC_CLUSTEREDLIGHTING_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "GLExt.h"
+
+namespace cgcc {
+
+// std430 layout: each vec3 + float pair packs into one vec4
+struct PointLight {
+    glm::vec3 position;
+    float radius; // influence radius: the light contributes nothing beyond it
+    glm::vec3 color;
+    float intensity;
+};
+
+struct ClusterGrid {
+    GLuint dimX = 16, dimY = 9, dimZ = 24;
+    int width = 0, height = 0;
+    float zNear = 0.1f, zFar = 100.0f;
+    glm::mat4 projection = glm::mat4(1.0f);
+
+    // View-space bounds of every cluster, rebuilt when the projection changes
+    std::vector<glm::vec3> clusterMin, clusterMax;
+
+    std::vector<GLuint> ranges;  // (offset, count) pairs
+    std::vector<GLuint> indices;
+    std::vector<GLuint> counts;  // scratch: lights per cluster
+    std::vector<GLuint> pairs;   // scratch: (cluster, light) assignments
+
+    GLuint lightSSBO = 0, clusterSSBO = 0, indexSSBO = 0;
+    size_t lightCapacity = 0, indexCapacity = 0;
+};
+
+// Declarations for the fragment shader (#version 430 or newer)
+inline const GLchar* clusteredLightingGLSL = R"(
+struct PointLight {
+    vec3 position;
+    float radius;
+    vec3 color;
+    float intensity;
+};
+layout (std430, binding = 0) readonly buffer LightBuffer { PointLight pointLights[]; };
+layout (std430, binding = 1) readonly buffer ClusterBuffer { uvec2 clusterRanges[]; };
+layout (std430, binding = 2) readonly buffer LightIndexBuffer { uint lightIndices[]; };
+uniform uvec3 clusterDims;
+uniform vec2 clusterTileSize;
+uniform float clusterSliceScale;
+uniform float clusterSliceBias;
+
+// (offset, count) of the lights affecting this fragment; viewDepth is the
+// positive distance along the view direction
+uvec2 clusterLightRange(float viewDepth)
+{
+    float slice = clamp(log(viewDepth) * clusterSliceScale + clusterSliceBias, 0.0, float(clusterDims.z - 1u));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize), clusterDims.xy - 1u);
+    return clusterRanges[tile.x + clusterDims.x * (tile.y + clusterDims.y * uint(slice))];
+}
+
+// Smooth window that reaches zero at the light radius
+float lightFalloff(float dist, float radius)
+{
+    float x = clamp(1.0 - pow(dist / radius, 4.0), 0.0, 1.0);
+    return x * x;
+}
+)";
+
+inline float clusterSliceDepth(const ClusterGrid& grid, float slice)
+{
+    return grid.zNear * std::pow(grid.zFar / grid.zNear, slice / grid.dimZ);
+}
+
+// Precomputes the view-space bounds of every cluster for a perspective projection
+inline void initClusterGrid(ClusterGrid& grid, int width, int height, const glm::mat4& projection, float zNear, float zFar)
+{
+    grid.width = width;
+    grid.height = height;
+    grid.projection = projection;
+    grid.zNear = zNear;
+    grid.zFar = zFar;
+
+    size_t clusterCount = (size_t)grid.dimX * grid.dimY * grid.dimZ;
+    grid.clusterMin.resize(clusterCount);
+    grid.clusterMax.resize(clusterCount);
+    grid.ranges.assign(clusterCount * 2, 0);
+    grid.counts.assign(clusterCount, 0);
+
+    glm::mat4 invProjection = glm::inverse(projection);
+    // Direction (with z = -1) of the view ray through an NDC point
+    auto rayThrough = [&](float ndcX, float ndcY) {
+        glm::vec4 p = invProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+        glm::vec3 v = glm::vec3(p) / p.w;
+        return v / -v.z;
+    };
+
+    for (GLuint z = 0; z < grid.dimZ; ++z)
+    {
+        float dNear = clusterSliceDepth(grid, (float)z);
+        float dFar = clusterSliceDepth(grid, (float)(z + 1));
+        for (GLuint y = 0; y < grid.dimY; ++y)
+        {
+            for (GLuint x = 0; x < grid.dimX; ++x)
+            {
+                float x0 = 2.0f * x / grid.dimX - 1.0f, x1 = 2.0f * (x + 1) / grid.dimX - 1.0f;
+                float y0 = 2.0f * y / grid.dimY - 1.0f, y1 = 2.0f * (y + 1) / grid.dimY - 1.0f;
+                glm::vec3 rays[4] = { rayThrough(x0, y0), rayThrough(x1, y0), rayThrough(x0, y1), rayThrough(x1, y1) };
+                glm::vec3 bmin(1e30f), bmax(-1e30f);
+                for (const glm::vec3& r : rays)
+                {
+                    bmin = glm::min(bmin, glm::min(r * dNear, r * dFar));
+                    bmax = glm::max(bmax, glm::max(r * dNear, r * dFar));
+                }
+                size_t c = x + grid.dimX * (y + grid.dimY * z);
+                grid.clusterMin[c] = bmin;
+                grid.clusterMax[c] = bmax;
+            }
+        }
+    }
+
+    if (grid.lightSSBO == 0)
+    {
+        glGenBuffers(1, &grid.lightSSBO);
+        glGenBuffers(1, &grid.clusterSSBO);
+        glGenBuffers(1, &grid.indexSSBO);
+    }
+}
+
+inline void destroyClusterGrid(ClusterGrid& grid)
+{
+    if (grid.lightSSBO)
+    {
+        glDeleteBuffers(1, &grid.lightSSBO);
+        glDeleteBuffers(1, &grid.clusterSSBO);
+        glDeleteBuffers(1, &grid.indexSSBO);
+    }
+    grid = ClusterGrid();
+}
+
+inline bool sphereIntersectsBox(const glm::vec3& center, float radius, const glm::vec3& bmin, const glm::vec3& bmax)
+{
+    glm::vec3 closest = glm::clamp(center, bmin, bmax);
+    glm::vec3 d = center - closest;
+    return glm::dot(d, d) <= radius * radius;
+}
+
+// Cluster range [begin, end) covered by a light along one axis
+struct ClusterSpan { int begin, end; };
+
+// Assigns lights to clusters and uploads the three storage buffers
+inline void buildClusters(ClusterGrid& grid, const std::vector<PointLight>& lights, const glm::mat4& view)
+{
+    size_t clusterCount = grid.counts.size();
+    std::fill(grid.counts.begin(), grid.counts.end(), 0u);
+
+    // Pass 1: candidate clusters of each light from its view-space bounds,
+    // refined with a sphere/box test; the pairs are kept for pass 2
+    std::vector<GLuint>& pairs = grid.pairs;
+    pairs.clear();
+    float logRatio = std::log(grid.zFar / grid.zNear);
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+        float radius = lights[i].radius;
+        float dMin = -center.z - radius, dMax = -center.z + radius;
+        if (dMax < grid.zNear || dMin > grid.zFar) continue;
+
+        ClusterSpan zs;
+        zs.begin = dMin <= grid.zNear ? 0 : (int)(std::log(dMin / grid.zNear) / logRatio * grid.dimZ);
+        zs.end = dMax >= grid.zFar ? (int)grid.dimZ : (int)(std::log(dMax / grid.zNear) / logRatio * grid.dimZ) + 1;
+        zs.begin = std::max(0, zs.begin);
+        zs.end = std::min((int)grid.dimZ, zs.end);
+
+        // Screen footprint of the sphere's bounding box; anything reaching the
+        // camera plane covers the whole screen
+        ClusterSpan xs = { 0, (int)grid.dimX }, ys = { 0, (int)grid.dimY };
+        if (dMin > grid.zNear)
+        {
+            glm::vec2 ndcMin(1e30f), ndcMax(-1e30f);
+            for (int c = 0; c < 8; ++c)
+            {
+                glm::vec3 corner = center + glm::vec3((c & 1) ? radius : -radius, (c & 2) ? radius : -radius, (c & 4) ? radius : -radius);
+                glm::vec4 clip = grid.projection * glm::vec4(corner, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) continue;
+            xs = { std::max(0, (int)std::floor((ndcMin.x * 0.5f + 0.5f) * grid.dimX)), std::min((int)grid.dimX, (int)std::floor((ndcMax.x * 0.5f + 0.5f) * grid.dimX) + 1) };
+            ys = { std::max(0, (int)std::floor((ndcMin.y * 0.5f + 0.5f) * grid.dimY)), std::min((int)grid.dimY, (int)std::floor((ndcMax.y * 0.5f + 0.5f) * grid.dimY) + 1) };
+        }
+
+        for (int z = zs.begin; z < zs.end; ++z)
+            for (int y = ys.begin; y < ys.end; ++y)
+                for (int x = xs.begin; x < xs.end; ++x)
+                {
+                    GLuint c = x + grid.dimX * (y + grid.dimY * z);
+                    if (!sphereIntersectsBox(center, radius, grid.clusterMin[c], grid.clusterMax[c])) continue;
+                    grid.counts[c]++;
+                    pairs.push_back(c);
+                    pairs.push_back((GLuint)i);
+                }
+    }
+
+    // Pass 2: prefix sum of the counts, then scatter the light indices
+    GLuint offset = 0;
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        grid.ranges[2 * c] = offset;
+        grid.ranges[2 * c + 1] = 0;
+        offset += grid.counts[c];
+    }
+    grid.indices.resize(std::max<GLuint>(offset, 1));
+    for (size_t p = 0; p < pairs.size(); p += 2)
+    {
+        GLuint c = pairs[p];
+        grid.indices[grid.ranges[2 * c] + grid.ranges[2 * c + 1]++] = pairs[p + 1];
+    }
+
+    // Upload (orphaning the previous storage when it has to grow)
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, grid.lightSSBO);
+    size_t lightBytes = std::max<size_t>(lights.size(), 1) * sizeof(PointLight);
+    if (lightBytes > grid.lightCapacity)
+    {
+        glBufferData(GL_SHADER_STORAGE_BUFFER, lightBytes, NULL, GL_STREAM_DRAW);
+        grid.lightCapacity = lightBytes;
+    }
+    if (!lights.empty())
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, lights.size() * sizeof(PointLight), lights.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, grid.clusterSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, grid.ranges.size() * sizeof(GLuint), grid.ranges.data(), GL_STREAM_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, grid.indexSSBO);
+    size_t indexBytes = grid.indices.size() * sizeof(GLuint);
+    if (indexBytes > grid.indexCapacity)
+    {
+        glBufferData(GL_SHADER_STORAGE_BUFFER, indexBytes, NULL, GL_STREAM_DRAW);
+        grid.indexCapacity = indexBytes;
+    }
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, indexBytes, grid.indices.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+// Binds the storage buffers and sets the lookup uniforms on the current program
+inline void bindClusters(const ClusterGrid& grid, GLuint program)
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, grid.lightSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, grid.clusterSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, grid.indexSSBO);
+
+    float logRatio = std::log(grid.zFar / grid.zNear);
+    glUniform3ui(glGetUniformLocation(program, "clusterDims"), grid.dimX, grid.dimY, grid.dimZ);
+    glUniform2f(glGetUniformLocation(program, "clusterTileSize"), (float)grid.width / grid.dimX, (float)grid.height / grid.dimY);
+    glUniform1f(glGetUniformLocation(program, "clusterSliceScale"), grid.dimZ / logRatio);
+    glUniform1f(glGetUniformLocation(program, "clusterSliceBias"), -(float)grid.dimZ * std::log(grid.zNear) / logRatio);
+}
+
+} // namespace cgcc
+
+#endif // CGCC_CLUSTEREDLIGHTING_H
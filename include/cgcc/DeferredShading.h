@@ -0,0 +1,218 @@
+/* DeferredShading.h - thin G-buffer for a deferred lighting path
+ *
+ * Geometry pass: the scene is drawn once into
+ *   RT0  GL_RG16        octahedral-encoded world normal, remapped to [0,1]
+ *   RT1  GL_RGBA8       albedo (rgb) + specular coefficient ks (a)
+ *   RT2  GL_R8          specular exponent q / 255
+ *   depth GL_DEPTH_COMPONENT32F (world position is rebuilt from it)
+ * i.e. 9 bytes of attributes + 4 of depth per pixel. Overdrawn fragments only
+ * cost these writes. (SNORM targets would avoid the remap but are not required to
+ * be renderable, and some drivers clamp them to [0,1].)
+ *
+ * Lighting pass: a fullscreen triangle reads the G-buffer once per visible
+ * pixel and evaluates the lights, so shading cost is pixels x lights no matter
+ * how much the geometry overlaps. The pass also writes the stored depth back
+ * into the default framebuffer, so forward passes drawn afterwards still
+ * depth-test against the scene.
+ *
+ * The fragment shaders of both passes include the GLSL chunks below and are
+ * otherwise written by the application (material and light model are its own).
+ */
+
+#ifndef CGCC_DEFERREDSHADING_H
+#define CGCC_DEFERREDSHADING_H
+
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+#include "GLExt.h"
+
+namespace cgcc {
+
+struct GBuffer {
+    int width = 0, height = 0;
+    GLuint FBO = 0;
+    GLuint normalTex = 0, albedoTex = 0, materialTex = 0, depthTex = 0;
+    GLuint emptyVAO = 0; // the fullscreen triangle is generated from gl_VertexID
+};
+
+// Geometry pass: declare the outputs and call writeGBuffer() from main()
+inline const GLchar* gBufferOutputGLSL = R"(
+layout (location = 0) out vec2 gNormalOut;
+layout (location = 1) out vec4 gAlbedoOut;
+layout (location = 2) out float gMaterialOut;
+
+vec2 octWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Unit vector -> point of the [-1,1]^2 square (octahedral mapping)
+vec2 octEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+void writeGBuffer(vec3 normal, vec3 albedo, float ks, float q)
+{
+    gNormalOut = octEncode(normalize(normal)) * 0.5 + 0.5;
+    gAlbedoOut = vec4(albedo, ks);
+    gMaterialOut = q / 255.0;
+}
+)";
+
+// Lighting pass: readGBuffer() fetches this pixel's attributes; returns false
+// for background pixels (nothing was drawn there)
+inline const GLchar* gBufferInputGLSL = R"(
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+uniform sampler2D gMaterial;
+uniform sampler2D gDepth;
+uniform mat4 invViewProj;
+uniform vec2 gBufferSize;
+
+struct GBufferSample {
+    vec3 position; // world space
+    vec3 normal;
+    vec3 albedo;
+    float ks;
+    float q;
+    float depth;
+};
+
+vec3 octDecode(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+bool readGBuffer(out GBufferSample g)
+{
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    g.depth = texelFetch(gDepth, p, 0).r;
+    if (g.depth >= 1.0) return false;
+    vec4 ndc = vec4(gl_FragCoord.xy / gBufferSize * 2.0 - 1.0, g.depth * 2.0 - 1.0, 1.0);
+    vec4 world = invViewProj * ndc;
+    g.position = world.xyz / world.w;
+    g.normal = octDecode(texelFetch(gNormal, p, 0).rg * 2.0 - 1.0);
+    vec4 albedo = texelFetch(gAlbedo, p, 0);
+    g.albedo = albedo.rgb;
+    g.ks = albedo.a;
+    g.q = texelFetch(gMaterial, p, 0).r * 255.0;
+    return true;
+}
+)";
+
+// Fullscreen triangle for the lighting pass
+inline const GLchar* fullscreenVertexShaderSource = R"(
+#version 400
+void main()
+{
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+})";
+
+inline GLuint createGBufferTarget(GLenum internalFormat, GLenum format, GLenum type, int width, int height)
+{
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return tex;
+}
+
+inline void destroyGBuffer(GBuffer& gBuffer)
+{
+    if (gBuffer.FBO) glDeleteFramebuffers(1, &gBuffer.FBO);
+    GLuint textures[] = { gBuffer.normalTex, gBuffer.albedoTex, gBuffer.materialTex, gBuffer.depthTex };
+    glDeleteTextures(4, textures);
+    if (gBuffer.emptyVAO) glDeleteVertexArrays(1, &gBuffer.emptyVAO);
+    gBuffer = GBuffer();
+}
+
+// (Re)creates the render targets for a framebuffer size
+inline bool initGBuffer(GBuffer& gBuffer, int width, int height)
+{
+    destroyGBuffer(gBuffer);
+    gBuffer.width = width;
+    gBuffer.height = height;
+
+    gBuffer.normalTex = createGBufferTarget(GL_RG16, GL_RG, GL_UNSIGNED_SHORT, width, height);
+    gBuffer.albedoTex = createGBufferTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    gBuffer.materialTex = createGBufferTarget(GL_R8, GL_RED, GL_UNSIGNED_BYTE, width, height);
+    gBuffer.depthTex = createGBufferTarget(GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &gBuffer.FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gBuffer.normalTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gBuffer.albedoTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gBuffer.materialTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, gBuffer.depthTex, 0);
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, drawBuffers);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete)
+        std::cout << "ERROR::GBUFFER::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenVertexArrays(1, &gBuffer.emptyVAO);
+    return complete;
+}
+
+// Binds and clears the G-buffer; draw the scene with the geometry-pass program next
+inline void beginGeometryPass(const GBuffer& gBuffer)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.FBO);
+    glViewport(0, 0, gBuffer.width, gBuffer.height);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+// Resolves the G-buffer into the default framebuffer with the given lighting
+// program (already bound, with its own uniforms set)
+inline void drawLightingPass(const GBuffer& gBuffer, GLuint program, const glm::mat4& viewProj)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, gBuffer.width, gBuffer.height);
+
+    const GLuint textures[] = { gBuffer.normalTex, gBuffer.albedoTex, gBuffer.materialTex, gBuffer.depthTex };
+    const char* samplers[] = { "gNormal", "gAlbedo", "gMaterial", "gDepth" };
+    for (int i = 0; i < 4; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glUniform1i(glGetUniformLocation(program, samplers[i]), i);
+    }
+    glm::mat4 invViewProj = glm::inverse(viewProj);
+    glUniformMatrix4fv(glGetUniformLocation(program, "invViewProj"), 1, GL_FALSE, &invViewProj[0][0]);
+    glUniform2f(glGetUniformLocation(program, "gBufferSize"), (float)gBuffer.width, (float)gBuffer.height);
+
+    // The lighting shader writes gl_FragDepth: copy the scene depth unconditionally
+    glDepthFunc(GL_ALWAYS);
+    glBindVertexArray(gBuffer.emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+
+    for (int i = 3; i >= 0; --i)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+} // namespace cgcc
+
+#endif // CGCC_DEFERREDSHADING_H
@@ -0,0 +1,116 @@
+/* DepthPrepass.h - depth-only prepass and front-to-back ordering
+ *
+ * With an expensive fragment shader every rasterized fragment that is later
+ * overwritten is wasted work. The prepass draws the opaque scene once with
+ * color writes off, using a position-only vertex stream and an empty fragment
+ * shader, so the depth buffer ends up holding the nearest surface. The shading
+ * pass then runs with depth writes off and GL_EQUAL, so only the visible
+ * fragment of each pixel is shaded.
+ *
+ * Both passes must produce bit-identical depth: the prepass program reuses the
+ * application's vertex shader (which should declare "invariant gl_Position;")
+ * and only swaps the fragment stage. Vertex inputs other than the position are
+ * left disabled in the position-only VAO and read the constant attribute value.
+ *
+ * Sorting opaque draws front to back helps both passes reject occluded
+ * fragments early (and is worth doing on its own when the prepass is off).
+ */
+
+#ifndef CGCC_DEPTHPREPASS_H
+#define CGCC_DEPTHPREPASS_H
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Arena.h"
+
+namespace cgcc {
+
+inline const GLchar* depthOnlyFragmentShaderSource = R"(
+#version 400
+void main()
+{
+})";
+
+// Prepass program: the shading program's vertex shader with an empty fragment stage
+inline GLuint buildDepthPrepassProgram(const GLchar* vertexSource)
+{
+    return buildProgram(vertexSource, depthOnlyFragmentShaderSource);
+}
+
+// Packs the positions (3 floats at the start of each vertex) of an interleaved
+// vertex array, strideBytes apart, into their own VBO and returns a VAO with
+// only attribute 0 enabled
+inline GLuint createPositionStream(const void* interleaved, size_t vertexCount, size_t strideBytes, GLuint& outVBO)
+{
+    std::vector<GLfloat> positions(vertexCount * 3);
+    const uint8_t* vertex = (const uint8_t*)interleaved;
+    for (size_t i = 0; i < vertexCount; ++i, vertex += strideBytes)
+        std::memcpy(&positions[3 * i], vertex, 3 * sizeof(GLfloat));
+
+    GLuint VAO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &outVBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, outVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(GLfloat), positions.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return VAO;
+}
+
+// Depth-only pass: fills the depth buffer, leaves color untouched
+inline void beginDepthPrepass()
+{
+    glEnable(GL_DEPTH_TEST);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
+
+// Shading pass: only the fragments that won the prepass are shaded
+inline void beginEqualDepthPass()
+{
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_EQUAL);
+}
+
+// Back to the default state (depth writes on, GL_LESS)
+inline void endEqualDepthPass()
+{
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
+
+// Fills order with the indices of centers (world space) sorted nearest first;
+// equal depths keep their index order. The depths go to scratch when given
+inline void sortFrontToBack(std::vector<uint32_t>& order, const std::vector<glm::vec3>& centers, const glm::mat4& view, LinearArena* scratch = nullptr)
+{
+    // View-space depth of each center; the camera looks down -z
+    std::vector<float> heapDepth;
+    if (!scratch)
+        heapDepth.resize(centers.size());
+    float* depth = scratch ? scratch->allocate<float>(centers.size()) : heapDepth.data();
+    for (size_t i = 0; i < centers.size(); ++i)
+    {
+        const glm::vec3& c = centers[i];
+        depth[i] = -(view[0][2] * c.x + view[1][2] * c.y + view[2][2] * c.z + view[3][2]);
+    }
+    order.resize(centers.size());
+    std::iota(order.begin(), order.end(), 0u);
+    // Ties broken by index: the order of a stable sort, without its temporary buffer
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return depth[a] < depth[b] || (depth[a] == depth[b] && a < b); });
+}
+
+} // namespace cgcc
+
+#endif // CGCC_DEPTHPREPASS_H
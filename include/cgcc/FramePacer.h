@@ -0,0 +1,148 @@
+/* FramePacer.h - vsync, a frame rate cap and redrawing only when needed
+ *
+ * The examples loop on glfwPollEvents() and glfwSwapBuffers() with no swap
+ * interval, so they draw as fast as the GPU allows and keep a core busy even
+ * when nothing on screen changes. A FramePacer replaces those two calls:
+ *
+ *     cgcc::FramePacer pacer;                        // settings, then init
+ *     pacer.mode = cgcc::PacingMode::OnDemand;
+ *     cgcc::initFramePacer(pacer, window);
+ *     while (!glfwWindowShouldClose(window))
+ *     {
+ *         if (!cgcc::beginFrame(pacer))              // events; false: nothing to draw
+ *             continue;
+ *         ...draw...
+ *         cgcc::endFrame(pacer);                     // swap, then wait for the next frame
+ *     }
+ *
+ * swapInterval is given to glfwSwapInterval (1 = vsync, 0 = off). targetFps
+ * caps the frame rate on top of that: endFrame() sleeps until the next frame
+ * is due, waking spinMs early and spinning the rest, because a sleep can
+ * overshoot by a scheduler tick (the margin grows to the overshoots seen).
+ *
+ * In PacingMode::Continuous every iteration draws. In PacingMode::OnDemand
+ * beginFrame() blocks in glfwWaitEventsTimeout() until something marks the
+ * frame dirty with requestRedraw(): the application's input callbacks, an
+ * animation that is running, or assets still arriving (call it each frame
+ * while that lasts). The window's refresh callback (exposed, resized) marks
+ * it too; the pacer keeps itself in the window's user pointer for that.
+ * Another thread can call glfwPostEmptyEvent() to wake the wait early.
+ */
+
+#ifndef CGCC_FRAMEPACER_H
+#define CGCC_FRAMEPACER_H
+
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include <GLFW/glfw3.h>
+
+#include "Trace.h"
+
+namespace cgcc {
+
+enum class PacingMode { Continuous, OnDemand };
+
+struct FramePacer {
+    PacingMode mode = PacingMode::Continuous;
+    int swapInterval = 1;
+    double targetFps = 0.0;     // 0: no cap besides vsync
+    double spinMs = 1.0;        // end of the wait spent spinning
+    double idleTimeout = 0.5;   // longest blocking wait, seconds
+
+    GLFWwindow* window = nullptr;
+    bool dirty = true;
+    std::chrono::steady_clock::time_point nextFrame;
+    unsigned long long framesDrawn = 0;
+};
+
+inline void requestRedraw(FramePacer& pacer)
+{
+    pacer.dirty = true;
+}
+
+inline void initFramePacer(FramePacer& pacer, GLFWwindow* window)
+{
+    pacer.window = window;
+    pacer.dirty = true;
+    pacer.nextFrame = std::chrono::steady_clock::now();
+    glfwSwapInterval(pacer.swapInterval);
+    glfwSetWindowUserPointer(window, &pacer);
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) {
+        if (FramePacer* pacer = static_cast<FramePacer*>(glfwGetWindowUserPointer(w)))
+            requestRedraw(*pacer);
+    });
+}
+
+inline void setSwapInterval(FramePacer& pacer, int interval)
+{
+    pacer.swapInterval = interval;
+    glfwSwapInterval(interval);
+}
+
+// Processes the pending events; in on-demand mode waits for them while the
+// frame is clean. Returns whether this iteration should draw. The frame is
+// clean again from here on, so a requestRedraw() made while drawing it asks
+// for the next one
+inline bool beginFrame(FramePacer& pacer)
+{
+    if (pacer.mode == PacingMode::Continuous)
+    {
+        glfwPollEvents();
+        pacer.dirty = false;
+        return true;
+    }
+    if (pacer.dirty)
+        glfwPollEvents();
+    else
+    {
+        CGCC_TRACE_ZONE("wait for events");
+        glfwWaitEventsTimeout(pacer.idleTimeout);
+    }
+    bool draw = pacer.dirty;
+    pacer.dirty = false;
+    return draw;
+}
+
+// Sleeps, then spins, until the next frame of targetFps is due
+inline void waitForNextFrame(FramePacer& pacer)
+{
+    using clock = std::chrono::steady_clock;
+    if (pacer.targetFps <= 0.0)
+        return;
+    CGCC_TRACE_ZONE("frame pacing");
+    auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / pacer.targetFps));
+    auto now = clock::now();
+    pacer.nextFrame += period;
+    // More than a frame late (a hitch, or the first frame drawn after idling):
+    // start counting again from now instead of rushing to catch up
+    if (pacer.nextFrame < now)
+        pacer.nextFrame = now;
+    auto spin = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(pacer.spinMs));
+    auto wake = pacer.nextFrame - spin;
+    if (now < wake)
+    {
+        std::this_thread::sleep_until(wake);
+        double overshootMs = std::chrono::duration<double, std::milli>(clock::now() - wake).count();
+        double periodMs = 1000.0 / pacer.targetFps;
+        if (overshootMs > pacer.spinMs)
+            pacer.spinMs = std::min(overshootMs, periodMs * 0.5);
+    }
+    while (clock::now() < pacer.nextFrame)
+        std::this_thread::yield();
+}
+
+inline void endFrame(FramePacer& pacer)
+{
+    {
+        CGCC_TRACE_ZONE("swap buffers");
+        glfwSwapBuffers(pacer.window);
+    }
+    ++pacer.framesDrawn;
+    waitForNextFrame(pacer);
+}
+
+} // namespace cgcc
+
+#endif // CGCC_FRAMEPACER_H
@@ -0,0 +1,289 @@
+/* FrameTimer.h - where the frame time goes, on the CPU and on the GPU
+ *
+ * A FrameTimer keeps a short history of timings per named series and reports
+ * min / avg / p99 over it:
+ *
+ *     cgcc::FrameTimer timer;
+ *     cgcc::initFrameTimer(timer);
+ *     // each frame
+ *     cgcc::beginFrameTimer(timer);
+ *     cgcc::beginGpuPass(timer, "clear");   ...glClear...
+ *     cgcc::beginGpuPass(timer, "opaque");  ...draws...   // ends "clear"
+ *     cgcc::endGpuPass(timer);
+ *     cgcc::endFrameTimer(timer);                         // before the swap
+ *     // anywhere, e.g. an input callback
+ *     cgcc::beginCpuSection(timer, "picking"); ... cgcc::endCpuSection(timer, "picking");
+ *
+ * The series "cpu" is the CPU time from beginFrameTimer() to endFrameTimer().
+ * A GPU pass is a GL_TIME_ELAPSED query. Those queries cannot nest, so
+ * beginning a pass ends the previous one. Each pass has a ring of
+ * frameTimerLatency queries. A result is read when its query comes round
+ * again, that many frames later. If the GPU has still not finished it, the
+ * sample is dropped instead of waiting, so timing never stalls the pipeline.
+ *
+ * drawFrameTimerOverlay() draws one bar per series in a corner of the
+ * framebuffer that is bound. A bar's length is the average and its tick
+ * marks p99; the white line is 1/60 s. Only glScissor and glClear are used,
+ * so no shader is involved. The numbers go in frameTimerSummary() (the
+ * examples show it in the window title) and in writeFrameTimerCSV().
+ */
+
+#ifndef CGCC_FRAMETIMER_H
+#define CGCC_FRAMETIMER_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+#include <glad/glad.h>
+
+namespace cgcc {
+
+const int frameTimerLatency = 4;   // frames between a GPU query and its readback
+const int frameTimerHistory = 300; // samples kept per series
+
+struct TimingSeries {
+    std::string name;
+    bool gpu = false;
+    std::vector<double> samples; // milliseconds, ring of frameTimerHistory
+    size_t next = 0;
+    unsigned long long total = 0;
+
+    // GPU pass: one query per frame in flight
+    GLuint queries[frameTimerLatency] = {};
+    bool issued[frameTimerLatency] = {};
+    // CPU section
+    std::chrono::steady_clock::time_point start;
+};
+
+struct TimingStats {
+    double min = 0.0, avg = 0.0, p99 = 0.0;
+    size_t count = 0;
+};
+
+struct FrameTimer {
+    std::vector<TimingSeries> series; // [0] is "cpu"
+    unsigned long long frame = 0;
+    int slot = 0;
+    int activePass = -1;
+    unsigned long long droppedSamples = 0;
+    std::chrono::steady_clock::time_point frameStart;
+    bool overlay = false;
+};
+
+inline void addTimingSample(TimingSeries& series, double ms)
+{
+    if (series.samples.size() < (size_t)frameTimerHistory)
+        series.samples.push_back(ms);
+    else
+        series.samples[series.next] = ms;
+    series.next = (series.next + 1) % frameTimerHistory;
+    ++series.total;
+}
+
+// The series with this name, added on first use
+inline TimingSeries& timingSeries(FrameTimer& timer, const std::string& name, bool gpu)
+{
+    for (auto& series : timer.series)
+    {
+        if (series.name == name && series.gpu == gpu)
+            return series;
+    }
+    timer.series.emplace_back();
+    timer.series.back().name = name;
+    timer.series.back().gpu = gpu;
+    return timer.series.back();
+}
+
+inline void initFrameTimer(FrameTimer& timer)
+{
+    timer.series.clear();
+    timingSeries(timer, "cpu", false);
+    timer.frameStart = std::chrono::steady_clock::now();
+}
+
+inline TimingStats timingStats(const TimingSeries& series)
+{
+    TimingStats stats;
+    stats.count = series.samples.size();
+    if (stats.count == 0)
+        return stats;
+    std::vector<double> sorted = series.samples;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (double ms : sorted)
+        sum += ms;
+    stats.min = sorted.front();
+    stats.avg = sum / stats.count;
+    stats.p99 = sorted[(size_t)std::ceil(0.99 * stats.count) - 1];
+    return stats;
+}
+
+// Reads the GPU results of the slot this frame reuses, then starts the CPU clock
+inline void beginFrameTimer(FrameTimer& timer)
+{
+    timer.slot = (int)(timer.frame % frameTimerLatency);
+    for (auto& series : timer.series)
+    {
+        if (!series.gpu || !series.issued[timer.slot])
+            continue;
+        series.issued[timer.slot] = false;
+        GLuint available = 0;
+        glGetQueryObjectuiv(series.queries[timer.slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            ++timer.droppedSamples;
+            continue;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(series.queries[timer.slot], GL_QUERY_RESULT, &nanoseconds);
+        addTimingSample(series, nanoseconds * 1e-6);
+    }
+    timer.frameStart = std::chrono::steady_clock::now();
+}
+
+inline void endGpuPass(FrameTimer& timer)
+{
+    if (timer.activePass < 0)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    timer.activePass = -1;
+}
+
+// Times the GPU work issued until the next pass begins or endGpuPass(); a pass
+// begun twice in a frame keeps its first timing
+inline void beginGpuPass(FrameTimer& timer, const std::string& name)
+{
+    endGpuPass(timer);
+    TimingSeries& series = timingSeries(timer, name, true);
+    if (series.issued[timer.slot])
+        return;
+    if (series.queries[0] == 0)
+        glGenQueries(frameTimerLatency, series.queries);
+    glBeginQuery(GL_TIME_ELAPSED, series.queries[timer.slot]);
+    series.issued[timer.slot] = true;
+    timer.activePass = (int)(&series - timer.series.data());
+}
+
+inline void beginCpuSection(FrameTimer& timer, const std::string& name)
+{
+    timingSeries(timer, name, false).start = std::chrono::steady_clock::now();
+}
+
+inline void endCpuSection(FrameTimer& timer, const std::string& name)
+{
+    TimingSeries& series = timingSeries(timer, name, false);
+    addTimingSample(series, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - series.start).count());
+}
+
+inline void endFrameTimer(FrameTimer& timer)
+{
+    endGpuPass(timer);
+    addTimingSample(timer.series[0], std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - timer.frameStart).count());
+    ++timer.frame;
+}
+
+// "cpu 1.20/1.35/2.10 | opaque 0.80/..." : min/avg/p99 in ms
+inline std::string frameTimerSummary(const FrameTimer& timer)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    bool first = true;
+    for (const auto& series : timer.series)
+    {
+        TimingStats stats = timingStats(series);
+        if (stats.count == 0)
+            continue;
+        out << (first ? "" : " | ") << series.name << " " << stats.min << "/" << stats.avg << "/" << stats.p99;
+        first = false;
+    }
+    out << " ms (min/avg/p99)";
+    return out.str();
+}
+
+inline bool writeFrameTimerCSV(const FrameTimer& timer, const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::FRAMETIMER::CSV_NOT_WRITTEN\n" << path << std::endl;
+        return false;
+    }
+    file << "series,source,samples,min_ms,avg_ms,p99_ms\n";
+    file << std::fixed << std::setprecision(4);
+    for (const auto& series : timer.series)
+    {
+        TimingStats stats = timingStats(series);
+        file << series.name << "," << (series.gpu ? "gpu" : "cpu") << "," << stats.count << ","
+             << stats.min << "," << stats.avg << "," << stats.p99 << "\n";
+    }
+    return true;
+}
+
+// Bars in the top-left corner of the bound framebuffer, width x height pixels
+inline void drawFrameTimerOverlay(const FrameTimer& timer, int width, int height)
+{
+    static const float colors[][3] = {
+        { 0.9f, 0.9f, 0.2f }, { 0.3f, 0.8f, 0.3f }, { 0.3f, 0.6f, 1.0f },
+        { 1.0f, 0.5f, 0.2f }, { 0.8f, 0.4f, 0.9f }, { 0.2f, 0.9f, 0.9f },
+    };
+    const int barHeight = 8, gap = 3, margin = 10;
+    const double budgetMs = 1000.0 / 60.0;
+    const int budgetPixels = std::max(1, width / 3);
+
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    GLint scissorBox[4];
+    glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+    glEnable(GL_SCISSOR_TEST);
+
+    auto fill = [&](int x, int y, int w, int h, float r, float g, float b) {
+        if (w <= 0 || h <= 0)
+            return;
+        glScissor(x, y, w, h);
+        glClearColor(r, g, b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    };
+
+    int rows = (int)timer.series.size();
+    int top = height - margin;
+    fill(margin - 2, top - rows * (barHeight + gap) - 2, budgetPixels * 2 + 4, rows * (barHeight + gap) + 4, 0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < rows; ++i)
+    {
+        TimingStats stats = timingStats(timer.series[i]);
+        const float* c = colors[i % 6];
+        int y = top - (i + 1) * (barHeight + gap);
+        int avg = std::min(budgetPixels * 2, (int)std::lround(stats.avg / budgetMs * budgetPixels));
+        int p99 = std::min(budgetPixels * 2 - 2, (int)std::lround(stats.p99 / budgetMs * budgetPixels));
+        fill(margin, y, avg, barHeight, c[0], c[1], c[2]);
+        fill(margin + p99, y, 2, barHeight, c[0] * 0.5f, c[1] * 0.5f, c[2] * 0.5f);
+    }
+    fill(margin + budgetPixels, top - rows * (barHeight + gap), 1, rows * (barHeight + gap), 1.0f, 1.0f, 1.0f);
+
+    glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+    if (!scissor)
+        glDisable(GL_SCISSOR_TEST);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+inline void destroyFrameTimer(FrameTimer& timer)
+{
+    endGpuPass(timer);
+    for (auto& series : timer.series)
+    {
+        if (series.gpu && series.queries[0])
+            glDeleteQueries(frameTimerLatency, series.queries);
+    }
+    timer.series.clear();
+}
+
+} // namespace cgcc
+
+#endif // CGCC_FRAMETIMER_H
@@ -0,0 +1,433 @@
+/* GLCallCounters.h - what a frame asks of OpenGL, counted call by call
+ *
+ * glad keeps every entry point in a global function pointer (glDrawArrays is
+ * a macro for glad_glDrawArrays, and the GLExt.h ones for cgcc_gl...).
+ * installGLCallCounters() swaps the pointers it knows for wrappers that count
+ * and then call the driver, so nothing in the examples or in glad.c changes:
+ *
+ *     gladLoadGLLoader(...);
+ *     cgcc::loadGLExtensions(...);
+ *     cgcc::installGLCallCounters();          // after every loader
+ *     // each frame
+ *     cgcc::beginGLCallFrame();
+ *     ...
+ *     cgcc::endGLCallFrame();                  // last frame in lastGLCallFrame()
+ *
+ * Per frame it counts:
+ * - draws and the triangles they produce. Indirect draws are counted, but
+ *   their triangles are not, because the count stays on the GPU.
+ * - compute dispatches.
+ * - program, VAO and texture binds, plus the redundant ones that rebind what
+ *   is already bound. Textures are tracked per unit and target.
+ * - uniform uploads (the glUniform* calls).
+ * - other state changes: enable/disable, depth/blend/color state,
+ *   framebuffer binds.
+ * - bytes given to glBufferData/glBufferSubData or written through
+ *   glMapBufferRange.
+ * openGLCallLog() makes endGLCallFrame() append every frame to a CSV file.
+ *
+ * The bind tracking assumes every GL call goes through glad after installing,
+ * from one context on one thread.
+ */
+
+#ifndef CGCC_GLCALLCOUNTERS_H
+#define CGCC_GLCALLCOUNTERS_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <cstdint>
+
+#include "GLExt.h"
+
+namespace cgcc {
+
+struct GLCallCounts {
+    uint64_t draws = 0;
+    uint64_t indirectDraws = 0;
+    uint64_t triangles = 0;
+    uint64_t dispatches = 0;
+    uint64_t programBinds = 0, redundantProgramBinds = 0;
+    uint64_t vaoBinds = 0, redundantVAOBinds = 0;
+    uint64_t textureBinds = 0, redundantTextureBinds = 0;
+    uint64_t uniformUploads = 0;
+    uint64_t stateChanges = 0;
+    uint64_t bufferBytes = 0;
+};
+
+const int glCallTextureUnits = 32;
+const int glCallTextureTargets = 5; // 2D, 2D array, 3D, cube map, buffer
+
+struct GLCallState {
+    GLCallCounts frame;      // being counted
+    GLCallCounts lastFrame;  // the last complete frame
+    uint64_t frameIndex = 0;
+    bool installed = false;
+    std::vector<void (*)()> restore;
+    std::ofstream log;
+
+    // What is bound, to spot redundant binds
+    GLuint program = 0, vao = 0;
+    GLuint activeUnit = 0;
+    GLuint textures[glCallTextureUnits][glCallTextureTargets] = {};
+};
+
+inline GLCallState& glCallState()
+{
+    static GLCallState state;
+    return state;
+}
+
+inline const GLCallCounts& lastGLCallFrame()
+{
+    return glCallState().lastFrame;
+}
+
+// Wrapper for the function pointer at Slot: Counter::count(args...), then the driver
+template <auto* Slot, typename Counter, typename Pfn = std::remove_pointer_t<decltype(Slot)>>
+struct GLCallHook;
+
+template <auto* Slot, typename Counter, typename R, typename... Args>
+struct GLCallHook<Slot, Counter, R (APIENTRY*)(Args...)> {
+    static inline R (APIENTRY* original)(Args...) = nullptr;
+
+    static R APIENTRY call(Args... args)
+    {
+        Counter::count(args...);
+        return original(args...);
+    }
+
+    static void install()
+    {
+        if (*Slot == nullptr || original != nullptr)
+            return;
+        original = *Slot;
+        *Slot = &call;
+        glCallState().restore.push_back([] {
+            *Slot = original;
+            original = nullptr;
+        });
+    }
+};
+
+inline uint64_t trianglesOf(GLenum mode, GLsizei count)
+{
+    switch (mode)
+    {
+    case GL_TRIANGLES: return count / 3;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN: return count > 2 ? count - 2 : 0;
+    case GL_TRIANGLES_ADJACENCY: return count / 6;
+    case GL_TRIANGLE_STRIP_ADJACENCY: return count > 4 ? (count - 4) / 2 : 0;
+    default: return 0;
+    }
+}
+
+inline int glCallTextureTarget(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D: return 0;
+    case GL_TEXTURE_2D_ARRAY: return 1;
+    case GL_TEXTURE_3D: return 2;
+    case GL_TEXTURE_CUBE_MAP: return 3;
+    case GL_TEXTURE_BUFFER: return 4;
+    default: return -1;
+    }
+}
+
+struct CountUniform {
+    template <typename... Args>
+    static void count(Args...) { ++glCallState().frame.uniformUploads; }
+};
+
+struct CountStateChange {
+    template <typename... Args>
+    static void count(Args...) { ++glCallState().frame.stateChanges; }
+};
+
+struct CountDispatch {
+    template <typename... Args>
+    static void count(Args...) { ++glCallState().frame.dispatches; }
+};
+
+struct CountIndirectDraw {
+    template <typename... Args>
+    static void count(Args...)
+    {
+        ++glCallState().frame.draws;
+        ++glCallState().frame.indirectDraws;
+    }
+};
+
+struct CountDrawArrays {
+    static void count(GLenum mode, GLint, GLsizei count)
+    {
+        ++glCallState().frame.draws;
+        glCallState().frame.triangles += trianglesOf(mode, count);
+    }
+    static void count(GLenum mode, GLint, GLsizei count, GLsizei instances)
+    {
+        ++glCallState().frame.draws;
+        glCallState().frame.triangles += trianglesOf(mode, count) * instances;
+    }
+};
+
+struct CountDrawElements {
+    static void count(GLenum mode, GLsizei count, GLenum, const void*)
+    {
+        ++glCallState().frame.draws;
+        glCallState().frame.triangles += trianglesOf(mode, count);
+    }
+    static void count(GLenum mode, GLsizei count, GLenum, const void*, GLsizei instances)
+    {
+        ++glCallState().frame.draws;
+        glCallState().frame.triangles += trianglesOf(mode, count) * instances;
+    }
+};
+
+struct CountDrawElementsBaseVertex {
+    static void count(GLenum mode, GLsizei count, GLenum, const void*, GLint)
+    {
+        ++glCallState().frame.draws;
+        glCallState().frame.triangles += trianglesOf(mode, count);
+    }
+};
+
+struct CountUseProgram {
+    static void count(GLuint program)
+    {
+        GLCallState& state = glCallState();
+        ++state.frame.programBinds;
+        if (program == state.program)
+            ++state.frame.redundantProgramBinds;
+        state.program = program;
+    }
+};
+
+// A deleted name can come back from glCreateProgram (e.g. after a shader
+// reload), and binding it then is not redundant
+struct CountDeleteProgram {
+    static void count(GLuint program)
+    {
+        GLCallState& state = glCallState();
+        if (program != 0 && program == state.program)
+            state.program = 0;
+    }
+};
+
+struct CountBindVertexArray {
+    static void count(GLuint vao)
+    {
+        GLCallState& state = glCallState();
+        ++state.frame.vaoBinds;
+        if (vao == state.vao)
+            ++state.frame.redundantVAOBinds;
+        state.vao = vao;
+    }
+};
+
+struct CountDeleteVertexArrays {
+    static void count(GLsizei n, const GLuint* arrays)
+    {
+        GLCallState& state = glCallState();
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            if (arrays[i] == state.vao)
+                state.vao = 0;
+        }
+    }
+};
+
+struct CountActiveTexture {
+    static void count(GLenum unit)
+    {
+        ++glCallState().frame.stateChanges;
+        glCallState().activeUnit = unit - GL_TEXTURE0;
+    }
+};
+
+struct CountBindTexture {
+    static void count(GLenum target, GLuint texture)
+    {
+        GLCallState& state = glCallState();
+        ++state.frame.textureBinds;
+        int t = glCallTextureTarget(target);
+        if (t < 0 || state.activeUnit >= (GLuint)glCallTextureUnits)
+            return;
+        GLuint& bound = state.textures[state.activeUnit][t];
+        if (bound == texture)
+            ++state.frame.redundantTextureBinds;
+        bound = texture;
+    }
+};
+
+struct CountDeleteTextures {
+    static void count(GLsizei n, const GLuint* textures)
+    {
+        GLCallState& state = glCallState();
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            for (auto& unit : state.textures)
+            {
+                for (GLuint& bound : unit)
+                {
+                    if (bound == textures[i])
+                        bound = 0;
+                }
+            }
+        }
+    }
+};
+
+struct CountBufferData {
+    static void count(GLenum, GLsizeiptr size, const void* data, GLenum)
+    {
+        if (data)
+            glCallState().frame.bufferBytes += (uint64_t)size;
+    }
+    static void count(GLenum, GLintptr, GLsizeiptr size, const void*)
+    {
+        glCallState().frame.bufferBytes += (uint64_t)size;
+    }
+};
+
+struct CountMapBufferRange {
+    static void count(GLenum, GLintptr, GLsizeiptr length, GLbitfield access)
+    {
+        if (access & GL_MAP_WRITE_BIT)
+            glCallState().frame.bufferBytes += (uint64_t)length;
+    }
+};
+
+inline void installGLCallCounters()
+{
+    GLCallState& state = glCallState();
+    if (state.installed)
+        return;
+    state.installed = true;
+
+    GLCallHook<&glDrawArrays, CountDrawArrays>::install();
+    GLCallHook<&glDrawArraysInstanced, CountDrawArrays>::install();
+    GLCallHook<&glDrawElements, CountDrawElements>::install();
+    GLCallHook<&glDrawElementsInstanced, CountDrawElements>::install();
+    GLCallHook<&glDrawElementsBaseVertex, CountDrawElementsBaseVertex>::install();
+    GLCallHook<&glDrawArraysIndirect, CountIndirectDraw>::install();
+    GLCallHook<&glDrawElementsIndirect, CountIndirectDraw>::install();
+    GLCallHook<&glDispatchCompute, CountDispatch>::install();
+
+    GLCallHook<&glUseProgram, CountUseProgram>::install();
+    GLCallHook<&glDeleteProgram, CountDeleteProgram>::install();
+    GLCallHook<&glBindVertexArray, CountBindVertexArray>::install();
+    GLCallHook<&glDeleteVertexArrays, CountDeleteVertexArrays>::install();
+    GLCallHook<&glActiveTexture, CountActiveTexture>::install();
+    GLCallHook<&glBindTexture, CountBindTexture>::install();
+    GLCallHook<&glDeleteTextures, CountDeleteTextures>::install();
+
+    GLCallHook<&glUniform1f, CountUniform>::install();
+    GLCallHook<&glUniform2f, CountUniform>::install();
+    GLCallHook<&glUniform3f, CountUniform>::install();
+    GLCallHook<&glUniform4f, CountUniform>::install();
+    GLCallHook<&glUniform1i, CountUniform>::install();
+    GLCallHook<&glUniform2i, CountUniform>::install();
+    GLCallHook<&glUniform3i, CountUniform>::install();
+    GLCallHook<&glUniform4i, CountUniform>::install();
+    GLCallHook<&glUniform1ui, CountUniform>::install();
+    GLCallHook<&glUniform2ui, CountUniform>::install();
+    GLCallHook<&glUniform3ui, CountUniform>::install();
+    GLCallHook<&glUniform4ui, CountUniform>::install();
+    GLCallHook<&glUniform1fv, CountUniform>::install();
+    GLCallHook<&glUniform2fv, CountUniform>::install();
+    GLCallHook<&glUniform3fv, CountUniform>::install();
+    GLCallHook<&glUniform4fv, CountUniform>::install();
+    GLCallHook<&glUniform1iv, CountUniform>::install();
+    GLCallHook<&glUniform1uiv, CountUniform>::install();
+    GLCallHook<&glUniformMatrix3fv, CountUniform>::install();
+    GLCallHook<&glUniformMatrix4fv, CountUniform>::install();
+
+    GLCallHook<&glEnable, CountStateChange>::install();
+    GLCallHook<&glDisable, CountStateChange>::install();
+    GLCallHook<&glDepthFunc, CountStateChange>::install();
+    GLCallHook<&glDepthMask, CountStateChange>::install();
+    GLCallHook<&glColorMask, CountStateChange>::install();
+    GLCallHook<&glBlendFunc, CountStateChange>::install();
+    GLCallHook<&glCullFace, CountStateChange>::install();
+    GLCallHook<&glViewport, CountStateChange>::install();
+    GLCallHook<&glBindFramebuffer, CountStateChange>::install();
+
+    GLCallHook<&glBufferData, CountBufferData>::install();
+    GLCallHook<&glBufferSubData, CountBufferData>::install();
+    GLCallHook<&glMapBufferRange, CountMapBufferRange>::install();
+}
+
+// Puts the driver's pointers back
+inline void removeGLCallCounters()
+{
+    GLCallState& state = glCallState();
+    for (auto restore : state.restore)
+        restore();
+    state.restore.clear();
+    state.installed = false;
+    if (state.log.is_open())
+        state.log.close();
+}
+
+inline bool openGLCallLog(const std::string& path)
+{
+    GLCallState& state = glCallState();
+    state.log.open(path);
+    if (!state.log)
+    {
+        std::cout << "ERROR::GLCALLS::LOG_NOT_OPENED\n" << path << std::endl;
+        return false;
+    }
+    state.log << "frame,draws,indirect_draws,triangles,dispatches,program_binds,redundant_program_binds,"
+                 "vao_binds,redundant_vao_binds,texture_binds,redundant_texture_binds,uniform_uploads,"
+                 "state_changes,buffer_bytes\n";
+    return true;
+}
+
+inline void closeGLCallLog()
+{
+    glCallState().log.close();
+}
+
+inline void beginGLCallFrame()
+{
+    glCallState().frame = GLCallCounts();
+}
+
+inline void endGLCallFrame()
+{
+    GLCallState& state = glCallState();
+    state.lastFrame = state.frame;
+    const GLCallCounts& c = state.lastFrame;
+    if (state.log.is_open())
+    {
+        state.log << state.frameIndex << "," << c.draws << "," << c.indirectDraws << "," << c.triangles << "," << c.dispatches << ","
+                  << c.programBinds << "," << c.redundantProgramBinds << "," << c.vaoBinds << "," << c.redundantVAOBinds << ","
+                  << c.textureBinds << "," << c.redundantTextureBinds << "," << c.uniformUploads << ","
+                  << c.stateChanges << "," << c.bufferBytes << "\n";
+    }
+    ++state.frameIndex;
+}
+
+// One line for a title bar or the console
+inline std::string glCallSummary(const GLCallCounts& c)
+{
+    std::ostringstream out;
+    out << c.draws << " draws, " << c.triangles << " tris, "
+        << c.programBinds << " programs (" << c.redundantProgramBinds << " redundant), "
+        << c.vaoBinds << " VAOs (" << c.redundantVAOBinds << "), "
+        << c.textureBinds << " textures (" << c.redundantTextureBinds << "), "
+        << c.uniformUploads << " uniforms, " << c.stateChanges << " state, "
+        << c.bufferBytes << " buffer bytes";
+    return out.str();
+}
+
+} // namespace cgcc
+
+#endif // CGCC_GLCALLCOUNTERS_H
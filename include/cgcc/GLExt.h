@@ -0,0 +1,180 @@
+/* GLExt.h - OpenGL entry points newer than the profile generated into glad
+ *
+ * include/glad was generated with --api="gl=4.0", so everything from 4.1 on is
+ * missing from it. The functions declared here are loaded at runtime with the
+ * same loader passed to gladLoadGLLoader and stay null when the driver does not
+ * expose them; check glCaps before using a feature.
+ *
+ * If glad is ever regenerated with a newer API version the guarded blocks below
+ * become no-ops and the glad declarations are used instead.
+ */
+
+#ifndef CGCC_GLEXT_H
+#define CGCC_GLEXT_H
+
+#include <cstring>
+
+#include <glad/glad.h>
+
+// ---------------------------------------------------------------------------
+// OpenGL 4.1: program binaries
+// ---------------------------------------------------------------------------
+#ifndef GL_VERSION_4_1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+inline PFNGLGETPROGRAMBINARYPROC cgcc_glGetProgramBinary = nullptr;
+inline PFNGLPROGRAMBINARYPROC cgcc_glProgramBinary = nullptr;
+inline PFNGLPROGRAMPARAMETERIPROC cgcc_glProgramParameteri = nullptr;
+#define glGetProgramBinary cgcc_glGetProgramBinary
+#define glProgramBinary cgcc_glProgramBinary
+#define glProgramParameteri cgcc_glProgramParameteri
+#endif
+
+// ---------------------------------------------------------------------------
+// OpenGL 4.2 / 4.3: image load/store, BPTC (BC7) textures, immutable texture
+// storage and compute shaders
+// ---------------------------------------------------------------------------
+#ifndef GL_VERSION_4_2
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXSTORAGE3DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+inline PFNGLBINDIMAGETEXTUREPROC cgcc_glBindImageTexture = nullptr;
+inline PFNGLMEMORYBARRIERPROC cgcc_glMemoryBarrier = nullptr;
+inline PFNGLTEXSTORAGE2DPROC cgcc_glTexStorage2D = nullptr;
+inline PFNGLTEXSTORAGE3DPROC cgcc_glTexStorage3D = nullptr;
+#define glBindImageTexture cgcc_glBindImageTexture
+#define glMemoryBarrier cgcc_glMemoryBarrier
+#define glTexStorage2D cgcc_glTexStorage2D
+#define glTexStorage3D cgcc_glTexStorage3D
+#endif
+
+#ifndef GL_VERSION_4_3
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+inline PFNGLDISPATCHCOMPUTEPROC cgcc_glDispatchCompute = nullptr;
+#define glDispatchCompute cgcc_glDispatchCompute
+#endif
+
+// ---------------------------------------------------------------------------
+// GL_EXT_texture_compression_s3tc (BC1/BC3) and its sRGB formats (GL_EXT_texture_sRGB)
+// ---------------------------------------------------------------------------
+#ifndef GL_EXT_texture_compression_s3tc
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// ---------------------------------------------------------------------------
+// GL_KHR_parallel_shader_compile (same enums as the ARB version)
+// ---------------------------------------------------------------------------
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+inline PFNGLMAXSHADERCOMPILERTHREADSKHRPROC cgcc_glMaxShaderCompilerThreadsKHR = nullptr;
+#define glMaxShaderCompilerThreadsKHR cgcc_glMaxShaderCompilerThreadsKHR
+#endif
+
+namespace cgcc {
+
+// Features the optional fast paths check before touching the entry points above
+struct GLCaps {
+    int major = 0, minor = 0;
+    bool compute = false;        // compute shaders + image load/store (4.3)
+    bool storageBuffers = false; // shader storage buffer objects (4.3)
+    bool programBinary = false;  // glGetProgramBinary/glProgramBinary with at least one format (4.1)
+    bool parallelShaderCompile = false; // GL_COMPLETION_STATUS_KHR can be polled (KHR/ARB_parallel_shader_compile)
+    bool s3tc = false;           // BC1/BC3 textures (EXT_texture_compression_s3tc)
+    bool s3tcSRGB = false;       // ... in sRGB (EXT_texture_sRGB)
+    bool bptc = false;           // BC7 textures (4.2 / ARB_texture_compression_bptc)
+    bool textureStorage = false; // glTexStorage2D/3D (4.2 / ARB_texture_storage)
+};
+
+inline GLCaps glCaps;
+
+inline bool glVersionAtLeast(int major, int minor)
+{
+    return glCaps.major > major || (glCaps.major == major && glCaps.minor >= minor);
+}
+
+inline bool hasGLExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Must be called after gladLoadGLLoader, with the same loader
+inline void loadGLExtensions(GLADloadproc load)
+{
+    glCaps.major = GLVersion.major;
+    glCaps.minor = GLVersion.minor;
+
+#ifndef GL_VERSION_4_1
+    cgcc_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+    cgcc_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+    cgcc_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+#endif
+#ifndef GL_VERSION_4_2
+    cgcc_glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)load("glBindImageTexture");
+    cgcc_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+    cgcc_glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)load("glTexStorage2D");
+    cgcc_glTexStorage3D = (PFNGLTEXSTORAGE3DPROC)load("glTexStorage3D");
+#endif
+#ifndef GL_VERSION_4_3
+    cgcc_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+#endif
+
+    glCaps.compute = glVersionAtLeast(4, 3) && glDispatchCompute && glMemoryBarrier && glBindImageTexture;
+    glCaps.storageBuffers = glVersionAtLeast(4, 3);
+
+    GLint binaryFormats = 0;
+    if (glVersionAtLeast(4, 1))
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    glCaps.programBinary = binaryFormats > 0 && glGetProgramBinary && glProgramBinary && glProgramParameteri;
+
+    glCaps.s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+    glCaps.s3tcSRGB = glCaps.s3tc && (hasGLExtension("GL_EXT_texture_sRGB") || hasGLExtension("GL_EXT_texture_compression_s3tc_srgb"));
+    glCaps.bptc = glVersionAtLeast(4, 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+    glCaps.textureStorage = (glVersionAtLeast(4, 2) || hasGLExtension("GL_ARB_texture_storage")) && glTexStorage2D && glTexStorage3D;
+
+#ifndef GL_KHR_parallel_shader_compile
+    if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+        cgcc_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+        cgcc_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+#endif
+    glCaps.parallelShaderCompile = glMaxShaderCompilerThreadsKHR != nullptr;
+    // Let the driver use as many compiler threads as it wants
+    if (glCaps.parallelShaderCompile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+}
+
+} // namespace cgcc
+
+#endif // CGCC_GLEXT_H
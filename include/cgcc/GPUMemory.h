@@ -0,0 +1,668 @@
+/* GPUMemory.h - what the examples keep in video memory, and what they forget to free
+ *
+ * Like GLCallCounters.h, installGPUMemoryTracker() swaps glad's function
+ * pointers for wrappers, here the ones that create, size and delete buffers,
+ * textures and renderbuffers. Every resource is recorded with its size,
+ * format, dimensions, owner tag and lifetime:
+ *
+ *     cgcc::installGPUMemoryTracker();             // after the GL loaders
+ *     {
+ *         cgcc::GPUMemoryTag tag("Suzanne.obj");   // owner of what is created here
+ *         glGenBuffers(1, &VBO); ...glBufferData...
+ *     }
+ *     ...
+ *     // at shutdown, after deleting what the program owns
+ *     cgcc::reportGPUMemory(std::cout);            // per category, then the leaks
+ *     cgcc::removeGPUMemoryTracker();
+ *
+ * Sizes are what was asked for: a buffer is its glBufferData size, and a
+ * texture is the sum of its levels (and cube faces / array layers) at the
+ * bytes per texel of its internal format, or the block size of a compressed
+ * one. Drivers pad and align, so the real use is somewhat higher.
+ *
+ * Live and peak bytes are kept per category (vertex buffers, storage buffers,
+ * 2D textures, ...). Whatever is still alive when reportGPUMemory() runs is
+ * listed as a leak; writeGPUMemoryCSV() lists every resource ever created,
+ * with the seconds it was created and deleted at.
+ *
+ * Only calls made through glad after installing are seen, from one context
+ * on one thread. When GLCallCounters.h is installed too, remove the two in
+ * the reverse order of installing.
+ */
+
+#ifndef CGCC_GPUMEMORY_H
+#define CGCC_GPUMEMORY_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+
+#include "GLExt.h"
+
+namespace cgcc {
+
+enum class GPUResourceKind { Buffer, Texture, Renderbuffer };
+
+struct GPUResource {
+    GPUResourceKind kind = GPUResourceKind::Buffer;
+    GLuint name = 0;
+    GLenum target = 0;   // first target it was bound to
+    GLenum format = 0;   // internal format of textures and renderbuffers
+    GLsizei width = 0, height = 0, depth = 0, levels = 0;
+    uint64_t bytes = 0;
+    std::string tag;
+    double created = 0.0, deleted = -1.0; // seconds since installing
+    std::map<std::pair<GLenum, GLint>, uint64_t> images; // (face, level) -> bytes, textures only
+};
+
+struct GPUMemoryCategory {
+    uint64_t live = 0, peak = 0;
+    int count = 0;
+};
+
+struct GPUMemoryState {
+    bool installed = false;
+    std::vector<void (*)()> restore;
+    std::chrono::steady_clock::time_point start;
+
+    std::map<GLuint, GPUResource> buffers, textures, renderbuffers; // alive
+    std::vector<GPUResource> released;                                // deleted
+    std::map<std::string, GPUMemoryCategory> categories;
+    uint64_t live = 0, peak = 0;
+    std::vector<std::string> tags;
+
+    // What is bound, to know which resource a call sizes
+    std::map<GLenum, GLuint> boundBuffers;
+    std::map<std::pair<GLuint, GLenum>, GLuint> boundTextures; // (unit, target)
+    GLuint activeUnit = 0;
+    GLuint boundRenderbuffer = 0;
+};
+
+inline GPUMemoryState& gpuMemoryState()
+{
+    static GPUMemoryState state;
+    return state;
+}
+
+// Names the owner of the resources created while it is in scope
+struct GPUMemoryTag {
+    explicit GPUMemoryTag(const std::string& tag) { gpuMemoryState().tags.push_back(tag); }
+    ~GPUMemoryTag() { gpuMemoryState().tags.pop_back(); }
+    GPUMemoryTag(const GPUMemoryTag&) = delete;
+    GPUMemoryTag& operator=(const GPUMemoryTag&) = delete;
+};
+
+inline double gpuMemorySeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - gpuMemoryState().start).count();
+}
+
+inline std::string gpuTargetName(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER: return "vertex buffers";
+    case GL_ELEMENT_ARRAY_BUFFER: return "index buffers";
+    case GL_UNIFORM_BUFFER: return "uniform buffers";
+    case GL_SHADER_STORAGE_BUFFER: return "storage buffers";
+    case GL_DRAW_INDIRECT_BUFFER: return "indirect buffers";
+    case GL_PIXEL_UNPACK_BUFFER:
+    case GL_PIXEL_PACK_BUFFER: return "pixel buffers";
+    case GL_TEXTURE_2D: return "2D textures";
+    case GL_TEXTURE_2D_ARRAY: return "array textures";
+    case GL_TEXTURE_3D: return "3D textures";
+    case GL_TEXTURE_CUBE_MAP: return "cube maps";
+    case GL_RENDERBUFFER: return "renderbuffers";
+    default: return "other";
+    }
+}
+
+inline std::string gpuResourceCategory(const GPUResource& resource)
+{
+    if (resource.kind == GPUResourceKind::Buffer && gpuTargetName(resource.target) == "other")
+        return "other buffers";
+    if (resource.kind == GPUResourceKind::Texture && gpuTargetName(resource.target) == "other")
+        return "other textures";
+    return gpuTargetName(resource.kind == GPUResourceKind::Renderbuffer ? GL_RENDERBUFFER : resource.target);
+}
+
+inline std::string gpuFormatName(GLenum format)
+{
+    switch (format)
+    {
+    case 0: return "-";
+    case GL_RGBA8: return "RGBA8";
+    case GL_RGB8: return "RGB8";
+    case GL_SRGB8_ALPHA8: return "SRGB8_A8";
+    case GL_R8: return "R8";
+    case GL_R8UI: return "R8UI";
+    case GL_RG8: return "RG8";
+    case GL_R32F: return "R32F";
+    case GL_RGBA16F: return "RGBA16F";
+    case GL_RGB16F: return "RGB16F";
+    case GL_RGBA32F: return "RGBA32F";
+    case GL_RGB10_A2: return "RGB10_A2";
+    case GL_DEPTH_COMPONENT24: return "D24";
+    case GL_DEPTH_COMPONENT32F: return "D32F";
+    case GL_DEPTH24_STENCIL8: return "D24S8";
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT: return "BC1";
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: return "BC3";
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM: return "BC7";
+    default:
+    {
+        std::ostringstream out;
+        out << "0x" << std::hex << format;
+        return out.str();
+    }
+    }
+}
+
+// Bytes of one width x height x depth image, 0 for a format not listed
+inline uint64_t gpuImageBytes(GLenum format, GLsizei width, GLsizei height, GLsizei depth)
+{
+    uint64_t blocks = (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * depth;
+    uint64_t texels = (uint64_t)width * height * depth;
+    switch (format)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1: return blocks * 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case GL_COMPRESSED_RG_RGTC2: return blocks * 16;
+    case GL_R8: case GL_R8UI: case GL_R8I: case GL_RED: case GL_STENCIL_INDEX8: return texels;
+    case GL_RG8: case GL_R16F: case GL_R16UI: case GL_R16I: case GL_RG: case GL_DEPTH_COMPONENT16: return texels * 2;
+    case GL_RGB8: case GL_SRGB8: case GL_RGB: return texels * 3;
+    case GL_RGB16F: return texels * 6;
+    case GL_RGBA16F: case GL_RG32F: case GL_RG32UI: case GL_RGBA16: return texels * 8;
+    case GL_RGB32F: return texels * 12;
+    case GL_RGBA32F: case GL_RGBA32UI: return texels * 16;
+    case GL_RGBA8: case GL_SRGB8_ALPHA8: case GL_RGBA: case GL_RGB10_A2: case GL_R11F_G11F_B10F:
+    case GL_R32F: case GL_R32UI: case GL_R32I: case GL_RG16F:
+    case GL_DEPTH_COMPONENT: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8: case GL_DEPTH_STENCIL: return texels * 4;
+    case GL_DEPTH32F_STENCIL8: return texels * 8;
+    default: return 0;
+    }
+}
+
+// A new size for a resource: category and total live/peak follow
+inline void resizeGPUResource(GPUResource& resource, uint64_t bytes)
+{
+    GPUMemoryState& state = gpuMemoryState();
+    GPUMemoryCategory& category = state.categories[gpuResourceCategory(resource)];
+    category.live = category.live - resource.bytes + bytes;
+    category.peak = std::max(category.peak, category.live);
+    state.live = state.live - resource.bytes + bytes;
+    state.peak = std::max(state.peak, state.live);
+    resource.bytes = bytes;
+    if (resource.tag.empty() && !state.tags.empty())
+        resource.tag = state.tags.back();
+}
+
+inline void createGPUResources(std::map<GLuint, GPUResource>& live, GPUResourceKind kind, GLsizei n, const GLuint* names)
+{
+    GPUMemoryState& state = gpuMemoryState();
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        GPUResource resource;
+        resource.kind = kind;
+        resource.name = names[i];
+        resource.tag = state.tags.empty() ? std::string() : state.tags.back();
+        resource.created = gpuMemorySeconds();
+        live[names[i]] = resource;
+    }
+}
+
+inline void deleteGPUResources(std::map<GLuint, GPUResource>& live, GLsizei n, const GLuint* names)
+{
+    GPUMemoryState& state = gpuMemoryState();
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        auto it = live.find(names[i]);
+        if (it == live.end())
+            continue; // 0, or created before installing
+        GPUResource& resource = it->second;
+        if (resource.target != 0) // counted since its first bind
+        {
+            GPUMemoryCategory& category = state.categories[gpuResourceCategory(resource)];
+            category.live -= resource.bytes;
+            --category.count;
+        }
+        state.live -= resource.bytes;
+        resource.deleted = gpuMemorySeconds();
+        resource.images.clear();
+        state.released.push_back(resource);
+        live.erase(it);
+    }
+}
+
+// The category of a resource is known when it is first bound
+inline void bindGPUResource(GPUResource& resource, GLenum target)
+{
+    if (resource.target != 0)
+        return;
+    resource.target = target;
+    ++gpuMemoryState().categories[gpuResourceCategory(resource)].count;
+}
+
+inline GPUResource* boundBufferResource(GLenum target)
+{
+    GPUMemoryState& state = gpuMemoryState();
+    auto bound = state.boundBuffers.find(target);
+    if (bound == state.boundBuffers.end())
+        return nullptr;
+    auto it = state.buffers.find(bound->second);
+    return it == state.buffers.end() ? nullptr : &it->second;
+}
+
+// Cube map faces are bound as the cube map
+inline GLenum gpuTextureBinding(GLenum target)
+{
+    if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z)
+        return GL_TEXTURE_CUBE_MAP;
+    return target;
+}
+
+inline GPUResource* boundTextureResource(GLenum target)
+{
+    GPUMemoryState& state = gpuMemoryState();
+    auto bound = state.boundTextures.find({ state.activeUnit, gpuTextureBinding(target) });
+    if (bound == state.boundTextures.end())
+        return nullptr;
+    auto it = state.textures.find(bound->second);
+    return it == state.textures.end() ? nullptr : &it->second;
+}
+
+// One image (face, level) of a texture was (re)specified
+inline void setTextureImage(GLenum target, GLint level, GLenum format, GLsizei width, GLsizei height, GLsizei depth, uint64_t bytes)
+{
+    GPUResource* texture = boundTextureResource(target);
+    if (!texture)
+        return;
+    if (level == 0)
+    {
+        texture->format = format;
+        texture->width = width;
+        texture->height = height;
+        texture->depth = depth;
+    }
+    texture->images[{ target, level }] = bytes;
+    texture->levels = std::max(texture->levels, (GLsizei)level + 1);
+    uint64_t total = 0;
+    for (const auto& image : texture->images)
+        total += image.second;
+    resizeGPUResource(*texture, total);
+}
+
+// Levels 0..levels-1 of an immutable texture; 2D arrays keep their layers
+inline void setTextureStorage(GLenum target, GLsizei levels, GLenum format, GLsizei width, GLsizei height, GLsizei depth)
+{
+    int faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    for (GLsizei level = 0; level < levels; ++level)
+    {
+        GLsizei w = std::max(1, width >> level), h = std::max(1, height >> level);
+        GLsizei d = target == GL_TEXTURE_3D ? std::max(1, depth >> level) : depth;
+        for (int face = 0; face < faces; ++face)
+        {
+            GLenum image = faces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+            setTextureImage(image, level, format, w, h, d, gpuImageBytes(format, w, h, d));
+        }
+    }
+}
+
+// Wrapper for the function pointer at Slot: the driver, then Tracker::track(args...)
+template <auto* Slot, typename Tracker, typename Pfn = std::remove_pointer_t<decltype(Slot)>>
+struct GPUMemoryHook;
+
+template <auto* Slot, typename Tracker, typename... Args>
+struct GPUMemoryHook<Slot, Tracker, void (APIENTRY*)(Args...)> {
+    static inline void (APIENTRY* original)(Args...) = nullptr;
+
+    static void APIENTRY call(Args... args)
+    {
+        original(args...);
+        Tracker::track(args...);
+    }
+
+    static void install()
+    {
+        if (*Slot == nullptr || original != nullptr)
+            return;
+        original = *Slot;
+        *Slot = &call;
+        gpuMemoryState().restore.push_back([] {
+            *Slot = original;
+            original = nullptr;
+        });
+    }
+};
+
+struct TrackGenBuffers {
+    static void track(GLsizei n, GLuint* names) { createGPUResources(gpuMemoryState().buffers, GPUResourceKind::Buffer, n, names); }
+};
+
+struct TrackDeleteBuffers {
+    static void track(GLsizei n, const GLuint* names)
+    {
+        GPUMemoryState& state = gpuMemoryState();
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            for (auto& bound : state.boundBuffers)
+            {
+                if (bound.second == names[i])
+                    bound.second = 0;
+            }
+        }
+        deleteGPUResources(state.buffers, n, names);
+    }
+};
+
+struct TrackBindBuffer {
+    static void track(GLenum target, GLuint buffer)
+    {
+        GPUMemoryState& state = gpuMemoryState();
+        state.boundBuffers[target] = buffer;
+        auto it = state.buffers.find(buffer);
+        if (it != state.buffers.end())
+            bindGPUResource(it->second, target);
+    }
+    // glBindBufferBase / glBindBufferRange also bind the generic target
+    static void track(GLenum target, GLuint, GLuint buffer) { track(target, buffer); }
+    static void track(GLenum target, GLuint, GLuint buffer, GLintptr, GLsizeiptr) { track(target, buffer); }
+};
+
+struct TrackBufferData {
+    static void track(GLenum target, GLsizeiptr size, const void*, GLenum)
+    {
+        if (GPUResource* buffer = boundBufferResource(target))
+            resizeGPUResource(*buffer, (uint64_t)size);
+    }
+};
+
+struct TrackGenTextures {
+    static void track(GLsizei n, GLuint* names) { createGPUResources(gpuMemoryState().textures, GPUResourceKind::Texture, n, names); }
+};
+
+struct TrackDeleteTextures {
+    static void track(GLsizei n, const GLuint* names)
+    {
+        GPUMemoryState& state = gpuMemoryState();
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            for (auto& bound : state.boundTextures)
+            {
+                if (bound.second == names[i])
+                    bound.second = 0;
+            }
+        }
+        deleteGPUResources(state.textures, n, names);
+    }
+};
+
+struct TrackActiveTexture {
+    static void track(GLenum unit) { gpuMemoryState().activeUnit = unit - GL_TEXTURE0; }
+};
+
+struct TrackBindTexture {
+    static void track(GLenum target, GLuint texture)
+    {
+        GPUMemoryState& state = gpuMemoryState();
+        state.boundTextures[{ state.activeUnit, target }] = texture;
+        auto it = state.textures.find(texture);
+        if (it != state.textures.end())
+            bindGPUResource(it->second, target);
+    }
+};
+
+struct TrackTexImage {
+    static void track(GLenum target, GLint level, GLint format, GLsizei width, GLsizei height, GLint, GLenum, GLenum, const void*)
+    {
+        setTextureImage(target, level, (GLenum)format, width, height, 1, gpuImageBytes((GLenum)format, width, height, 1));
+    }
+    static void track(GLenum target, GLint level, GLint format, GLsizei width, GLsizei height, GLsizei depth, GLint, GLenum, GLenum, const void*)
+    {
+        setTextureImage(target, level, (GLenum)format, width, height, depth, gpuImageBytes((GLenum)format, width, height, depth));
+    }
+};
+
+struct TrackCompressedTexImage {
+    static void track(GLenum target, GLint level, GLenum format, GLsizei width, GLsizei height, GLint, GLsizei imageSize, const void*)
+    {
+        setTextureImage(target, level, format, width, height, 1, (uint64_t)imageSize);
+    }
+};
+
+struct TrackTexStorage {
+    static void track(GLenum target, GLsizei levels, GLenum format, GLsizei width, GLsizei height)
+    {
+        setTextureStorage(target, levels, format, width, height, 1);
+    }
+    static void track(GLenum target, GLsizei levels, GLenum format, GLsizei width, GLsizei height, GLsizei depth)
+    {
+        setTextureStorage(target, levels, format, width, height, depth);
+    }
+};
+
+// The levels below the base one, down to 1x1, in the base level's format
+struct TrackGenerateMipmap {
+    static void track(GLenum target)
+    {
+        GPUResource* texture = boundTextureResource(target);
+        if (!texture || texture->width == 0)
+            return;
+        GLsizei levels = 1;
+        while ((std::max(texture->width, texture->height) >> levels) > 0)
+            ++levels;
+        setTextureStorage(target, levels, texture->format, texture->width, texture->height, texture->depth);
+    }
+};
+
+struct TrackGenRenderbuffers {
+    static void track(GLsizei n, GLuint* names) { createGPUResources(gpuMemoryState().renderbuffers, GPUResourceKind::Renderbuffer, n, names); }
+};
+
+struct TrackDeleteRenderbuffers {
+    static void track(GLsizei n, const GLuint* names)
+    {
+        GPUMemoryState& state = gpuMemoryState();
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            if (state.boundRenderbuffer == names[i])
+                state.boundRenderbuffer = 0;
+        }
+        deleteGPUResources(state.renderbuffers, n, names);
+    }
+};
+
+struct TrackBindRenderbuffer {
+    static void track(GLenum target, GLuint renderbuffer)
+    {
+        GPUMemoryState& state = gpuMemoryState();
+        state.boundRenderbuffer = renderbuffer;
+        auto it = state.renderbuffers.find(renderbuffer);
+        if (it != state.renderbuffers.end())
+            bindGPUResource(it->second, target);
+    }
+};
+
+struct TrackRenderbufferStorage {
+    static void track(GLenum target, GLenum format, GLsizei width, GLsizei height)
+    {
+        track(target, 1, format, width, height);
+    }
+    static void track(GLenum, GLsizei samples, GLenum format, GLsizei width, GLsizei height)
+    {
+        GPUMemoryState& state = gpuMemoryState();
+        auto it = state.renderbuffers.find(state.boundRenderbuffer);
+        if (it == state.renderbuffers.end())
+            return;
+        GPUResource& renderbuffer = it->second;
+        renderbuffer.format = format;
+        renderbuffer.width = width;
+        renderbuffer.height = height;
+        renderbuffer.depth = 1;
+        resizeGPUResource(renderbuffer, gpuImageBytes(format, width, height, 1) * std::max(1, (int)samples));
+    }
+};
+
+inline void installGPUMemoryTracker()
+{
+    GPUMemoryState& state = gpuMemoryState();
+    if (state.installed)
+        return;
+    state.installed = true;
+    state.start = std::chrono::steady_clock::now();
+
+    GPUMemoryHook<&glGenBuffers, TrackGenBuffers>::install();
+    GPUMemoryHook<&glDeleteBuffers, TrackDeleteBuffers>::install();
+    GPUMemoryHook<&glBindBuffer, TrackBindBuffer>::install();
+    GPUMemoryHook<&glBindBufferBase, TrackBindBuffer>::install();
+    GPUMemoryHook<&glBindBufferRange, TrackBindBuffer>::install();
+    GPUMemoryHook<&glBufferData, TrackBufferData>::install();
+
+    GPUMemoryHook<&glGenTextures, TrackGenTextures>::install();
+    GPUMemoryHook<&glDeleteTextures, TrackDeleteTextures>::install();
+    GPUMemoryHook<&glActiveTexture, TrackActiveTexture>::install();
+    GPUMemoryHook<&glBindTexture, TrackBindTexture>::install();
+    GPUMemoryHook<&glTexImage2D, TrackTexImage>::install();
+    GPUMemoryHook<&glTexImage3D, TrackTexImage>::install();
+    GPUMemoryHook<&glCompressedTexImage2D, TrackCompressedTexImage>::install();
+    GPUMemoryHook<&glTexStorage2D, TrackTexStorage>::install();
+    GPUMemoryHook<&glTexStorage3D, TrackTexStorage>::install();
+    GPUMemoryHook<&glGenerateMipmap, TrackGenerateMipmap>::install();
+
+    GPUMemoryHook<&glGenRenderbuffers, TrackGenRenderbuffers>::install();
+    GPUMemoryHook<&glDeleteRenderbuffers, TrackDeleteRenderbuffers>::install();
+    GPUMemoryHook<&glBindRenderbuffer, TrackBindRenderbuffer>::install();
+    GPUMemoryHook<&glRenderbufferStorage, TrackRenderbufferStorage>::install();
+    GPUMemoryHook<&glRenderbufferStorageMultisample, TrackRenderbufferStorage>::install();
+}
+
+// Puts the driver's pointers back; the records stay for reporting
+inline void removeGPUMemoryTracker()
+{
+    GPUMemoryState& state = gpuMemoryState();
+    for (auto it = state.restore.rbegin(); it != state.restore.rend(); ++it)
+        (*it)();
+    state.restore.clear();
+    state.installed = false;
+}
+
+inline std::string gpuBytesText(uint64_t bytes)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(bytes >= 1024 * 1024 ? 1 : 0);
+    if (bytes >= 1024 * 1024)
+        out << bytes / (1024.0 * 1024.0) << " MB";
+    else if (bytes >= 1024)
+        out << bytes / 1024.0 << " KB";
+    else
+        out << bytes << " B";
+    return out.str();
+}
+
+// One line for a title bar or the console
+inline std::string gpuMemorySummary()
+{
+    GPUMemoryState& state = gpuMemoryState();
+    std::ostringstream out;
+    out << gpuBytesText(state.live) << " in GPU memory (peak " << gpuBytesText(state.peak) << "), "
+        << state.buffers.size() << " buffers, " << state.textures.size() << " textures, "
+        << state.renderbuffers.size() << " renderbuffers";
+    return out.str();
+}
+
+inline std::string gpuResourceText(const GPUResource& resource)
+{
+    std::ostringstream out;
+    const char* kinds[] = { "buffer", "texture", "renderbuffer" };
+    out << kinds[(int)resource.kind] << " " << resource.name << " (" << gpuResourceCategory(resource) << ") "
+        << gpuBytesText(resource.bytes);
+    if (resource.kind != GPUResourceKind::Buffer)
+    {
+        out << " " << gpuFormatName(resource.format) << " " << resource.width << "x" << resource.height;
+        if (resource.depth > 1)
+            out << "x" << resource.depth;
+        if (resource.levels > 1)
+            out << ", " << resource.levels << " levels";
+    }
+    out << ", " << (resource.tag.empty() ? "untagged" : resource.tag) << ", created at " << std::fixed
+        << std::setprecision(2) << resource.created << " s";
+    return out.str();
+}
+
+// Live and peak per category and live per tag, then everything not deleted
+inline void reportGPUMemory(std::ostream& out)
+{
+    GPUMemoryState& state = gpuMemoryState();
+    out << "GPU memory: " << gpuBytesText(state.live) << " live, " << gpuBytesText(state.peak) << " peak" << std::endl;
+    for (const auto& category : state.categories)
+    {
+        out << "  " << std::left << std::setw(18) << category.first << std::right << std::setw(10) << gpuBytesText(category.second.live)
+            << " live " << std::setw(10) << gpuBytesText(category.second.peak) << " peak, " << category.second.count << " alive" << std::endl;
+    }
+
+    std::vector<const GPUResource*> leaks;
+    for (const auto* live : { &state.buffers, &state.textures, &state.renderbuffers })
+    {
+        for (const auto& resource : *live)
+            leaks.push_back(&resource.second);
+    }
+    if (leaks.empty())
+    {
+        out << "No GPU resources leaked" << std::endl;
+        return;
+    }
+    std::map<std::string, uint64_t> perTag;
+    for (const GPUResource* resource : leaks)
+        perTag[resource->tag.empty() ? "untagged" : resource->tag] += resource->bytes;
+    out << "WARNING::GPUMEMORY::LEAKS " << leaks.size() << " resources still allocated:" << std::endl;
+    for (const auto& tag : perTag)
+        out << "  " << tag.first << ": " << gpuBytesText(tag.second) << std::endl;
+    for (const GPUResource* resource : leaks)
+        out << "    " << gpuResourceText(*resource) << std::endl;
+}
+
+inline bool writeGPUMemoryCSV(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::GPUMEMORY::FILE_NOT_WRITTEN\n" << path << std::endl;
+        return false;
+    }
+    GPUMemoryState& state = gpuMemoryState();
+    file << "kind,name,category,format,width,height,depth,levels,bytes,tag,created_s,deleted_s\n";
+    const char* kinds[] = { "buffer", "texture", "renderbuffer" };
+    auto write = [&](const GPUResource& r) {
+        file << kinds[(int)r.kind] << "," << r.name << "," << gpuResourceCategory(r) << "," << gpuFormatName(r.format) << ","
+             << r.width << "," << r.height << "," << r.depth << "," << r.levels << "," << r.bytes << ",\"" << r.tag << "\","
+             << r.created << "," << (r.deleted < 0.0 ? std::string() : std::to_string(r.deleted)) << "\n";
+    };
+    for (const GPUResource& resource : state.released)
+        write(resource);
+    for (const auto* live : { &state.buffers, &state.textures, &state.renderbuffers })
+    {
+        for (const auto& resource : *live)
+            write(resource.second);
+    }
+    return true;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_GPUMEMORY_H
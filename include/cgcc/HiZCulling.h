@@ -0,0 +1,558 @@
+/* HiZCulling.h - GPU occlusion culling with a hierarchical depth buffer (Hi-Z)
+ *
+ * Per frame:
+ *  1. Depth prepass of the instances that survived culling in the previous frame,
+ *     into an offscreen depth texture, using the current transforms.
+ *  2. A compute pass copies that depth into an R32F texture and reduces it into a
+ *     mip chain where every texel keeps the farthest depth of the texels below it.
+ *  3. A compute pass projects each instance's bounding box, picks the mip level
+ *     where the box covers at most 2x2 texels and compares its nearest depth with
+ *     the farthest occluder depth there. The result is written as the
+ *     instanceCount of a DrawArraysIndirectCommand per instance, which is also the
+ *     visible set used by the next frame's prepass (no CPU readback).
+ *
+ * Without compute shaders (GL < 4.3) the same prepass is followed by one
+ * GL_ANY_SAMPLES_PASSED query per bounding box and the draws are wrapped in
+ * glBeginConditionalRender. Both paths run on Mesa's llvmpipe.
+ *
+ * Culling is conservative: occluders are real geometry, so an instance is only
+ * skipped when something already drawn this frame is in front of all of it.
+ */
+
+#ifndef CGCC_HIZCULLING_H
+#define CGCC_HIZCULLING_H
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GLExt.h"
+#include "Shader.h"
+
+namespace cgcc {
+
+// One drawable: a non-indexed GL_TRIANGLES range with position at location 0
+struct HiZInstance {
+    GLuint VAO;
+    GLint first;
+    GLsizei count;
+    glm::mat4 model;
+    glm::vec3 boundsMin; // local-space bounding box
+    glm::vec3 boundsMax;
+};
+
+// Layout of the per-instance SSBO entry (std430)
+struct HiZGPUInstance {
+    glm::mat4 model;
+    glm::vec4 boundsMin;
+    glm::vec4 boundsMax;
+    GLuint count, first, pad0, pad1;
+};
+
+struct HiZCuller {
+    int width = 0, height = 0, levels = 0;
+    bool useCompute = false;
+
+    GLuint depthFBO = 0, depthTex = 0, pyramidTex = 0;
+    GLuint prepassProgram = 0, copyProgram = 0, downsampleProgram = 0, cullProgram = 0;
+    GLint prepassModelLoc = -1, prepassViewProjLoc = -1;
+    GLint cullViewProjLoc = -1, cullViewportLoc = -1, cullLevelsLoc = -1, cullCountLoc = -1;
+
+    GLuint instanceSSBO = 0, commandBuffer = 0;
+    size_t capacity = 0;
+    std::vector<HiZGPUInstance> gpuInstances; // scratch: the SSBO contents of this frame
+
+    // Fallback path: bounding boxes + occlusion queries + conditional rendering
+    GLuint boxVAO = 0, boxVBO = 0, boxProgram = 0;
+    GLint boxModelLoc = -1, boxViewProjLoc = -1, boxMinLoc = -1, boxMaxLoc = -1;
+    std::vector<GLuint> queries;
+    std::vector<bool> queryIssued;
+    std::vector<bool> lastVisible;
+    std::vector<bool> straddlesNear;
+};
+
+// Matches the DrawArraysIndirectCommand layout expected by glDrawArraysIndirect
+struct HiZDrawCommand {
+    GLuint count, instanceCount, first, baseInstance;
+};
+
+inline const GLchar* hiZPrepassVS = R"(
+#version 400
+layout (location = 0) in vec3 position;
+uniform mat4 viewProj;
+uniform mat4 model;
+void main()
+{
+    gl_Position = viewProj * model * vec4(position, 1.0);
+})";
+
+inline const GLchar* hiZPrepassFS = R"(
+#version 400
+void main()
+{
+})";
+
+inline const GLchar* hiZBoxVS = R"(
+#version 400
+layout (location = 0) in vec3 position;
+uniform mat4 viewProj;
+uniform mat4 model;
+uniform vec3 boundsMin;
+uniform vec3 boundsMax;
+void main()
+{
+    gl_Position = viewProj * model * vec4(mix(boundsMin, boundsMax, position), 1.0);
+})";
+
+inline const GLchar* hiZCopyCS = R"(
+#version 430
+layout (local_size_x = 8, local_size_y = 8) in;
+uniform sampler2D depthTex;
+layout (r32f, binding = 0) uniform writeonly image2D dst;
+void main()
+{
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, imageSize(dst)))) return;
+    imageStore(dst, p, vec4(texelFetch(depthTex, p, 0).r));
+})";
+
+// Farthest depth of each 2x2 block. When the source has an odd size the last
+// row/column of the destination also folds in the extra source texels, so texel
+// j of level L always covers pixels [j << L, (j + 1) << L) plus the remainder.
+inline const GLchar* hiZDownsampleCS = R"(
+#version 430
+layout (local_size_x = 8, local_size_y = 8) in;
+layout (r32f, binding = 0) uniform readonly image2D src;
+layout (r32f, binding = 1) uniform writeonly image2D dst;
+float load(ivec2 p)
+{
+    return imageLoad(src, min(p, imageSize(src) - 1)).r;
+}
+void main()
+{
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 dstSize = imageSize(dst);
+    if (any(greaterThanEqual(p, dstSize))) return;
+    ivec2 srcSize = imageSize(src);
+    ivec2 s = p * 2;
+    float d = max(max(load(s), load(s + ivec2(1, 0))), max(load(s + ivec2(0, 1)), load(s + ivec2(1, 1))));
+    bool extraX = (srcSize.x & 1) != 0 && p.x == dstSize.x - 1;
+    bool extraY = (srcSize.y & 1) != 0 && p.y == dstSize.y - 1;
+    if (extraX) d = max(d, max(load(s + ivec2(2, 0)), load(s + ivec2(2, 1))));
+    if (extraY) d = max(d, max(load(s + ivec2(0, 2)), load(s + ivec2(1, 2))));
+    if (extraX && extraY) d = max(d, load(s + ivec2(2, 2)));
+    imageStore(dst, p, vec4(d));
+})";
+
+inline const GLchar* hiZCullCS = R"(
+#version 430
+layout (local_size_x = 64) in;
+struct Instance {
+    mat4 model;
+    vec4 boundsMin;
+    vec4 boundsMax;
+    uint count, first, pad0, pad1;
+};
+struct DrawCommand {
+    uint count, instanceCount, first, baseInstance;
+};
+layout (std430, binding = 0) readonly buffer Instances { Instance instances[]; };
+layout (std430, binding = 1) writeonly buffer Commands { DrawCommand commands[]; };
+uniform sampler2D hiZ;
+uniform mat4 viewProj;
+uniform ivec2 viewport;
+uniform int levels;
+uniform uint instanceCount;
+
+bool isVisible(Instance inst)
+{
+    mat4 mvp = viewProj * inst.model;
+    vec3 ndcMin = vec3(1e30), ndcMax = vec3(-1e30);
+    for (int c = 0; c < 8; ++c) {
+        vec3 corner = vec3((c & 1) != 0 ? inst.boundsMax.x : inst.boundsMin.x,
+                           (c & 2) != 0 ? inst.boundsMax.y : inst.boundsMin.y,
+                           (c & 4) != 0 ? inst.boundsMax.z : inst.boundsMin.z);
+        vec4 clip = mvp * vec4(corner, 1.0);
+        if (clip.w <= 0.0) return true; // crosses the camera plane: keep it
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+    // Frustum test
+    if (any(greaterThan(ndcMin, vec3(1.0))) || any(lessThan(ndcMax.xy, vec2(-1.0))))
+        return false;
+
+    // Occlusion test against the farthest occluder depth over the box footprint
+    ivec2 p0 = clamp(ivec2((ndcMin.xy * 0.5 + 0.5) * vec2(viewport)), ivec2(0), viewport - 1);
+    ivec2 p1 = clamp(ivec2((ndcMax.xy * 0.5 + 0.5) * vec2(viewport)), ivec2(0), viewport - 1);
+    int extent = max(p1.x - p0.x, p1.y - p0.y);
+    int level = clamp(int(ceil(log2(float(max(extent, 1))))) - 1, 0, levels - 1);
+    ivec2 t0, t1;
+    for (;;) {
+        ivec2 size = max(viewport >> ivec2(level), ivec2(1)); // same as the allocated mip size
+        t0 = min(p0 >> ivec2(level), size - 1);
+        t1 = min(p1 >> ivec2(level), size - 1);
+        if ((t1.x - t0.x <= 1 && t1.y - t0.y <= 1) || level == levels - 1) break;
+        ++level;
+    }
+    float occluderDepth = max(max(texelFetch(hiZ, t0, level).r, texelFetch(hiZ, ivec2(t1.x, t0.y), level).r),
+                              max(texelFetch(hiZ, ivec2(t0.x, t1.y), level).r, texelFetch(hiZ, t1, level).r));
+    float nearestDepth = ndcMin.z * 0.5 + 0.5;
+    return nearestDepth <= occluderDepth;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= instanceCount) return;
+    Instance inst = instances[i];
+    commands[i] = DrawCommand(inst.count, isVisible(inst) ? 1u : 0u, inst.first, 0u);
+})";
+
+inline void destroyHiZTargets(HiZCuller& culler)
+{
+    if (culler.depthFBO) glDeleteFramebuffers(1, &culler.depthFBO);
+    if (culler.depthTex) glDeleteTextures(1, &culler.depthTex);
+    if (culler.pyramidTex) glDeleteTextures(1, &culler.pyramidTex);
+    culler.depthFBO = culler.depthTex = culler.pyramidTex = 0;
+}
+
+// (Re)creates the offscreen depth target and the pyramid for a framebuffer size
+inline void resizeHiZCuller(HiZCuller& culler, int width, int height)
+{
+    destroyHiZTargets(culler);
+    culler.width = width;
+    culler.height = height;
+
+    glGenTextures(1, &culler.depthTex);
+    glBindTexture(GL_TEXTURE_2D, culler.depthTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+    glGenFramebuffers(1, &culler.depthFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, culler.depthFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, culler.depthTex, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::HIZ::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    culler.levels = 1;
+    if (culler.useCompute)
+    {
+        int w = width, h = height;
+        glGenTextures(1, &culler.pyramidTex);
+        glBindTexture(GL_TEXTURE_2D, culler.pyramidTex);
+        for (int level = 0;; ++level)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, w, h, 0, GL_RED, GL_FLOAT, NULL);
+            culler.levels = level + 1;
+            if (w == 1 && h == 1) break;
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, culler.levels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Returns false if neither path could be set up
+inline bool initHiZCuller(HiZCuller& culler, int width, int height)
+{
+    culler.prepassProgram = buildProgram(hiZPrepassVS, hiZPrepassFS);
+    culler.prepassModelLoc = glGetUniformLocation(culler.prepassProgram, "model");
+    culler.prepassViewProjLoc = glGetUniformLocation(culler.prepassProgram, "viewProj");
+
+    if (glCaps.compute)
+    {
+        culler.copyProgram = buildComputeProgram(hiZCopyCS);
+        culler.downsampleProgram = buildComputeProgram(hiZDownsampleCS);
+        culler.cullProgram = buildComputeProgram(hiZCullCS);
+        culler.useCompute = culler.copyProgram && culler.downsampleProgram && culler.cullProgram;
+    }
+
+    if (culler.useCompute)
+    {
+        culler.cullViewProjLoc = glGetUniformLocation(culler.cullProgram, "viewProj");
+        culler.cullViewportLoc = glGetUniformLocation(culler.cullProgram, "viewport");
+        culler.cullLevelsLoc = glGetUniformLocation(culler.cullProgram, "levels");
+        culler.cullCountLoc = glGetUniformLocation(culler.cullProgram, "instanceCount");
+        glGenBuffers(1, &culler.instanceSSBO);
+        glGenBuffers(1, &culler.commandBuffer);
+    }
+    else
+    {
+        // Unit cube [0,1]^3, stretched to each bounding box in the vertex shader
+        static const GLfloat box[] = {
+            0,0,0, 1,0,0, 1,1,0,  0,0,0, 1,1,0, 0,1,0,
+            0,0,1, 1,1,1, 1,0,1,  0,0,1, 0,1,1, 1,1,1,
+            0,0,0, 0,1,1, 0,0,1,  0,0,0, 0,1,0, 0,1,1,
+            1,0,0, 1,0,1, 1,1,1,  1,0,0, 1,1,1, 1,1,0,
+            0,0,0, 0,0,1, 1,0,1,  0,0,0, 1,0,1, 1,0,0,
+            0,1,0, 1,1,1, 0,1,1,  0,1,0, 1,1,0, 1,1,1,
+        };
+        culler.boxProgram = buildProgram(hiZBoxVS, hiZPrepassFS);
+        culler.boxModelLoc = glGetUniformLocation(culler.boxProgram, "model");
+        culler.boxViewProjLoc = glGetUniformLocation(culler.boxProgram, "viewProj");
+        culler.boxMinLoc = glGetUniformLocation(culler.boxProgram, "boundsMin");
+        culler.boxMaxLoc = glGetUniformLocation(culler.boxProgram, "boundsMax");
+
+        glGenVertexArrays(1, &culler.boxVAO);
+        glGenBuffers(1, &culler.boxVBO);
+        glBindVertexArray(culler.boxVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, culler.boxVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(box), box, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    resizeHiZCuller(culler, width, height);
+    return culler.prepassProgram != 0 && (culler.useCompute || culler.boxProgram != 0);
+}
+
+inline void destroyHiZCuller(HiZCuller& culler)
+{
+    destroyHiZTargets(culler);
+    glDeleteProgram(culler.prepassProgram);
+    glDeleteProgram(culler.copyProgram);
+    glDeleteProgram(culler.downsampleProgram);
+    glDeleteProgram(culler.cullProgram);
+    glDeleteProgram(culler.boxProgram);
+    if (culler.instanceSSBO) glDeleteBuffers(1, &culler.instanceSSBO);
+    if (culler.commandBuffer) glDeleteBuffers(1, &culler.commandBuffer);
+    if (culler.boxVAO) glDeleteVertexArrays(1, &culler.boxVAO);
+    if (culler.boxVBO) glDeleteBuffers(1, &culler.boxVBO);
+    if (!culler.queries.empty()) glDeleteQueries((GLsizei)culler.queries.size(), culler.queries.data());
+    culler = HiZCuller();
+}
+
+// Grows the per-instance storage; everything starts out visible
+inline void reserveHiZInstances(HiZCuller& culler, const std::vector<HiZInstance>& instances)
+{
+    if (instances.size() <= culler.capacity) return;
+    culler.capacity = instances.size();
+
+    if (culler.useCompute)
+    {
+        std::vector<HiZDrawCommand> commands(culler.capacity);
+        for (size_t i = 0; i < instances.size(); ++i)
+            commands[i] = { (GLuint)instances[i].count, 1u, (GLuint)instances[i].first, 0u };
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(HiZDrawCommand), commands.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.instanceSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, culler.capacity * sizeof(HiZGPUInstance), NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    else
+    {
+        size_t old = culler.queries.size();
+        culler.queries.resize(culler.capacity);
+        glGenQueries((GLsizei)(culler.capacity - old), culler.queries.data() + old);
+        culler.queryIssued.resize(culler.capacity, false);
+        culler.lastVisible.resize(culler.capacity, true);
+        culler.straddlesNear.resize(culler.capacity, false);
+    }
+}
+
+// Step 1: depth of last frame's visible set, rendered with this frame's transforms
+inline void hiZDepthPrepass(HiZCuller& culler, const std::vector<HiZInstance>& instances, const glm::mat4& viewProj)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, culler.depthFBO);
+    glViewport(0, 0, culler.width, culler.height);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(culler.prepassProgram);
+    glUniformMatrix4fv(culler.prepassViewProjLoc, 1, GL_FALSE, glm::value_ptr(viewProj));
+    if (culler.useCompute)
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer);
+
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+        if (!culler.useCompute)
+        {
+            // Read last frame's query without waiting; unknown counts as visible
+            if (culler.queryIssued[i])
+            {
+                GLuint available = 0, samples = 1;
+                glGetQueryObjectuiv(culler.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available) glGetQueryObjectuiv(culler.queries[i], GL_QUERY_RESULT, &samples);
+                culler.lastVisible[i] = samples != 0;
+            }
+            if (!culler.lastVisible[i]) continue;
+        }
+        glUniformMatrix4fv(culler.prepassModelLoc, 1, GL_FALSE, glm::value_ptr(instances[i].model));
+        glBindVertexArray(instances[i].VAO);
+        if (culler.useCompute)
+            glDrawArraysIndirect(GL_TRIANGLES, (const void*)(i * sizeof(HiZDrawCommand)));
+        else
+            glDrawArrays(GL_TRIANGLES, instances[i].first, instances[i].count);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+// Step 2: farthest-depth mip chain
+inline void hiZBuildPyramid(HiZCuller& culler)
+{
+    if (!culler.useCompute) return;
+
+    glUseProgram(culler.copyProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, culler.depthTex);
+    glUniform1i(glGetUniformLocation(culler.copyProgram, "depthTex"), 0);
+    glBindImageTexture(0, culler.pyramidTex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute((culler.width + 7) / 8, (culler.height + 7) / 8, 1);
+
+    glUseProgram(culler.downsampleProgram);
+    int w = culler.width, h = culler.height;
+    for (int level = 1; level < culler.levels; ++level)
+    {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glBindImageTexture(0, culler.pyramidTex, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, culler.pyramidTex, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((w + 7) / 8, (h + 7) / 8, 1);
+    }
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Step 3: visibility of every instance for this frame
+inline void hiZCull(HiZCuller& culler, const std::vector<HiZInstance>& instances, const glm::mat4& viewProj)
+{
+    if (culler.useCompute)
+    {
+        std::vector<HiZGPUInstance>& gpuInstances = culler.gpuInstances;
+        gpuInstances.resize(instances.size());
+        for (size_t i = 0; i < instances.size(); ++i)
+        {
+            const HiZInstance& inst = instances[i];
+            gpuInstances[i] = { inst.model, glm::vec4(inst.boundsMin, 1.0f), glm::vec4(inst.boundsMax, 1.0f),
+                                (GLuint)inst.count, (GLuint)inst.first, 0u, 0u };
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.instanceSSBO);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpuInstances.size() * sizeof(HiZGPUInstance), gpuInstances.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glUseProgram(culler.cullProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, culler.pyramidTex);
+        glUniform1i(glGetUniformLocation(culler.cullProgram, "hiZ"), 0);
+        glUniformMatrix4fv(culler.cullViewProjLoc, 1, GL_FALSE, glm::value_ptr(viewProj));
+        glUniform2i(culler.cullViewportLoc, culler.width, culler.height);
+        glUniform1i(culler.cullLevelsLoc, culler.levels);
+        glUniform1ui(culler.cullCountLoc, (GLuint)instances.size());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, culler.instanceSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, culler.commandBuffer);
+        glDispatchCompute((GLuint)(instances.size() + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return;
+    }
+
+    // Fallback: one occlusion query per bounding box against the prepass depth
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, culler.depthFBO);
+    glViewport(0, 0, culler.width, culler.height);
+    // LEQUAL: the box of a visible object touches its own prepass depth
+    GLint depthFunc;
+    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    glUseProgram(culler.boxProgram);
+    glUniformMatrix4fv(culler.boxViewProjLoc, 1, GL_FALSE, glm::value_ptr(viewProj));
+    glBindVertexArray(culler.boxVAO);
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+        const HiZInstance& inst = instances[i];
+        // A box that reaches behind the camera would be clipped away: never cull it
+        glm::mat4 mvp = viewProj * inst.model;
+        culler.straddlesNear[i] = false;
+        for (int c = 0; c < 8 && !culler.straddlesNear[i]; ++c)
+        {
+            glm::vec3 corner((c & 1) ? inst.boundsMax.x : inst.boundsMin.x,
+                             (c & 2) ? inst.boundsMax.y : inst.boundsMin.y,
+                             (c & 4) ? inst.boundsMax.z : inst.boundsMin.z);
+            glm::vec4 clip = mvp * glm::vec4(corner, 1.0f);
+            culler.straddlesNear[i] = clip.w <= 0.0f || clip.z < -clip.w;
+        }
+        if (culler.straddlesNear[i])
+        {
+            culler.queryIssued[i] = false;
+            culler.lastVisible[i] = true;
+            continue;
+        }
+        glUniformMatrix4fv(culler.boxModelLoc, 1, GL_FALSE, glm::value_ptr(inst.model));
+        glUniform3fv(culler.boxMinLoc, 1, glm::value_ptr(inst.boundsMin));
+        glUniform3fv(culler.boxMaxLoc, 1, glm::value_ptr(inst.boundsMax));
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, culler.queries[i]);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        culler.queryIssued[i] = true;
+    }
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(depthFunc);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+// Runs steps 1-3. Changes the bound program: rebind yours before drawing
+inline void hiZBeginFrame(HiZCuller& culler, const std::vector<HiZInstance>& instances, const glm::mat4& viewProj)
+{
+    reserveHiZInstances(culler, instances);
+    hiZDepthPrepass(culler, instances, viewProj);
+    hiZBuildPyramid(culler);
+    hiZCull(culler, instances, viewProj);
+}
+
+// Draws instance i if it survived culling (the caller sets its own uniforms)
+inline void hiZDrawInstance(const HiZCuller& culler, const std::vector<HiZInstance>& instances, size_t i)
+{
+    glBindVertexArray(instances[i].VAO);
+    if (culler.useCompute)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer);
+        glDrawArraysIndirect(GL_TRIANGLES, (const void*)(i * sizeof(HiZDrawCommand)));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else if (culler.queryIssued[i])
+    {
+        glBeginConditionalRender(culler.queries[i], GL_QUERY_WAIT);
+        glDrawArrays(GL_TRIANGLES, instances[i].first, instances[i].count);
+        glEndConditionalRender();
+    }
+    else
+    {
+        glDrawArrays(GL_TRIANGLES, instances[i].first, instances[i].count);
+    }
+    glBindVertexArray(0);
+}
+
+} // namespace cgcc
+
+#endif // CGCC_HIZCULLING_H
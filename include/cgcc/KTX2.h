@@ -0,0 +1,234 @@
+/* KTX2.h - KTX2 container for block-compressed textures with their mip chain
+ *
+ * writeKTX2() stores BC1/BC3/BC7 levels produced by BlockCompression.h (used by
+ * the offline TexCompress tool); readKTX2() reads such a file back. The texture
+ * streamer (TextureStreamer.h) uploads its levels with glCompressedTexSubImage2D,
+ * so the texture reaches video memory still compressed and without any image
+ * decoding.
+ *
+ * Only what these tools write is supported: one 2D image, no supercompression,
+ * BC1 (RGB), BC3 or BC7 in UNORM or sRGB. Anything else, or a format the driver
+ * does not expose (compressedGLFormat() returns 0), makes the streamer fall back
+ * to the original image.
+ */
+
+#ifndef CGCC_KTX2_H
+#define CGCC_KTX2_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "GLExt.h"
+#include "BlockCompression.h"
+
+namespace cgcc {
+
+const uint8_t ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// VkFormat values of the supported block formats
+enum : uint32_t {
+    VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131,
+    VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132,
+    VK_FORMAT_BC3_UNORM_BLOCK = 137,
+    VK_FORMAT_BC3_SRGB_BLOCK = 138,
+    VK_FORMAT_BC7_UNORM_BLOCK = 145,
+    VK_FORMAT_BC7_SRGB_BLOCK = 146,
+};
+
+struct KTX2Header {
+    uint8_t identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth, pixelHeight, pixelDepth;
+    uint32_t layerCount, faceCount, levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset, dfdByteLength;
+    uint32_t kvdByteOffset, kvdByteLength;
+    uint64_t sgdByteOffset, sgdByteLength;
+};
+
+struct KTX2LevelIndex {
+    uint64_t byteOffset, byteLength, uncompressedByteLength;
+};
+
+struct KTX2Texture {
+    uint32_t vkFormat = 0;
+    int width = 0, height = 0;
+    std::vector<std::vector<uint8_t>> levels; // level 0 = full size
+};
+
+inline uint32_t ktx2VkFormat(BlockFormat format, bool srgb)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1: return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    case BlockFormat::BC3: return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+    default: return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+    }
+}
+
+inline bool ktx2BlockFormat(uint32_t vkFormat, BlockFormat& format, bool& srgb)
+{
+    switch (vkFormat)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK: case VK_FORMAT_BC1_RGB_SRGB_BLOCK: format = BlockFormat::BC1; break;
+    case VK_FORMAT_BC3_UNORM_BLOCK: case VK_FORMAT_BC3_SRGB_BLOCK: format = BlockFormat::BC3; break;
+    case VK_FORMAT_BC7_UNORM_BLOCK: case VK_FORMAT_BC7_SRGB_BLOCK: format = BlockFormat::BC7; break;
+    default: return false;
+    }
+    srgb = vkFormat == VK_FORMAT_BC1_RGB_SRGB_BLOCK || vkFormat == VK_FORMAT_BC3_SRGB_BLOCK || vkFormat == VK_FORMAT_BC7_SRGB_BLOCK;
+    return true;
+}
+
+// Basic data format descriptor (required by KTX2) for one of the block formats
+inline std::vector<uint32_t> ktx2DataFormatDescriptor(BlockFormat format, bool srgb)
+{
+    // Color models from the Khronos Data Format spec
+    const uint32_t modelBC1A = 128, modelBC3 = 130, modelBC7 = 134;
+    const uint32_t channelColor = 0, channelBC3Alpha = 15, qualifierLinear = 0x10;
+    struct Sample { uint32_t bitOffset, bitLength, channel; };
+    std::vector<Sample> samples;
+    uint32_t model;
+    switch (format)
+    {
+    case BlockFormat::BC1: model = modelBC1A; samples = { { 0, 64, channelColor } }; break;
+    case BlockFormat::BC3: model = modelBC3; samples = { { 0, 64, channelBC3Alpha | (srgb ? qualifierLinear : 0) }, { 64, 64, channelColor } }; break;
+    default: model = modelBC7; samples = { { 0, 128, channelColor } }; break;
+    }
+    uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+    std::vector<uint32_t> dfd;
+    dfd.push_back(4 + blockSize);                                      // dfdTotalSize
+    dfd.push_back(0);                                                  // vendorId = Khronos, descriptorType = basic
+    dfd.push_back(2 | (blockSize << 16));                              // version 1.3, block size
+    dfd.push_back(model | (1u << 8) | ((srgb ? 2u : 1u) << 16));       // model, BT.709 primaries, sRGB / linear, straight alpha
+    dfd.push_back(3 | (3u << 8));                                      // 4x4x1x1 texel block (dimensions - 1)
+    dfd.push_back((uint32_t)blockBytes(format));                       // bytesPlane0
+    dfd.push_back(0);                                                  // bytesPlane4..7
+    for (const Sample& s : samples)
+    {
+        dfd.push_back(s.bitOffset | ((s.bitLength - 1) << 16) | (s.channel << 24));
+        dfd.push_back(0);          // sample position
+        dfd.push_back(0);          // sampleLower
+        dfd.push_back(0xFFFFFFFF); // sampleUpper
+    }
+    return dfd;
+}
+
+// Writes a KTX2 file; levels[0] is the full-size image
+inline bool writeKTX2(const std::string& path, BlockFormat format, bool srgb, int width, int height, const std::vector<std::vector<uint8_t>>& levels)
+{
+    std::vector<uint32_t> dfd = ktx2DataFormatDescriptor(format, srgb);
+    KTX2Header header = {};
+    std::memcpy(header.identifier, ktx2Identifier, sizeof(ktx2Identifier));
+    header.vkFormat = ktx2VkFormat(format, srgb);
+    header.typeSize = 1;
+    header.pixelWidth = (uint32_t)width;
+    header.pixelHeight = (uint32_t)height;
+    header.faceCount = 1;
+    header.levelCount = (uint32_t)levels.size();
+    header.dfdByteOffset = (uint32_t)(sizeof(KTX2Header) + levels.size() * sizeof(KTX2LevelIndex));
+    header.dfdByteLength = (uint32_t)(dfd.size() * sizeof(uint32_t));
+
+    // Level data is stored smallest first, each level aligned to the block size
+    const uint64_t alignment = (uint64_t)blockBytes(format);
+    std::vector<KTX2LevelIndex> index(levels.size());
+    uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+    for (size_t i = levels.size(); i-- > 0;)
+    {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        index[i] = { offset, levels[i].size(), levels[i].size() };
+        offset += levels[i].size();
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)index.data(), index.size() * sizeof(KTX2LevelIndex));
+    file.write((const char*)dfd.data(), dfd.size() * sizeof(uint32_t));
+    for (size_t i = levels.size(); i-- > 0;)
+    {
+        static const char zeros[16] = {};
+        file.write(zeros, (std::streamsize)(index[i].byteOffset - (uint64_t)file.tellp()));
+        file.write((const char*)levels[i].data(), levels[i].size());
+    }
+    return (bool)file;
+}
+
+inline bool readKTX2(const std::string& path, KTX2Texture& texture)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    KTX2Header header;
+    file.read((char*)&header, sizeof(header));
+    BlockFormat format;
+    bool srgb;
+    if (!file || std::memcmp(header.identifier, ktx2Identifier, sizeof(ktx2Identifier)) != 0 ||
+        !ktx2BlockFormat(header.vkFormat, format, srgb) || header.supercompressionScheme != 0 ||
+        header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 || header.pixelHeight == 0)
+    {
+        std::cout << "ERROR::KTX2::UNSUPPORTED_FILE " << path << std::endl;
+        return false;
+    }
+    uint32_t levelCount = std::max(header.levelCount, 1u);
+    std::vector<KTX2LevelIndex> index(levelCount);
+    file.read((char*)index.data(), levelCount * sizeof(KTX2LevelIndex));
+
+    texture.vkFormat = header.vkFormat;
+    texture.width = (int)header.pixelWidth;
+    texture.height = (int)header.pixelHeight;
+    texture.levels.assign(levelCount, {});
+    for (uint32_t i = 0; i < levelCount && file; ++i)
+    {
+        int w = std::max(1, texture.width >> i), h = std::max(1, texture.height >> i);
+        if (index[i].byteLength != compressedImageSize(format, w, h))
+        {
+            std::cout << "ERROR::KTX2::BAD_LEVEL_SIZE " << path << std::endl;
+            return false;
+        }
+        texture.levels[i].resize((size_t)index[i].byteLength);
+        file.seekg((std::streamoff)index[i].byteOffset);
+        file.read((char*)texture.levels[i].data(), (std::streamsize)index[i].byteLength);
+    }
+    if (!file)
+    {
+        std::cout << "ERROR::KTX2::TRUNCATED_FILE " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// GL internal format of a KTX2 texture, or 0 when the driver cannot sample it
+inline GLenum compressedGLFormat(uint32_t vkFormat)
+{
+    switch (vkFormat)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK: return glCaps.s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return glCaps.s3tcSRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : 0;
+    case VK_FORMAT_BC3_UNORM_BLOCK: return glCaps.s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+    case VK_FORMAT_BC3_SRGB_BLOCK: return glCaps.s3tcSRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : 0;
+    case VK_FORMAT_BC7_UNORM_BLOCK: return glCaps.bptc ? GL_COMPRESSED_RGBA_BPTC_UNORM : 0;
+    case VK_FORMAT_BC7_SRGB_BLOCK: return glCaps.bptc ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : 0;
+    default: return 0;
+    }
+}
+
+// <image>.png -> <image>.ktx2, the name TexCompress writes by default
+inline std::string compressedTexturePath(const std::string& imagePath)
+{
+    size_t dot = imagePath.find_last_of('.');
+    size_t slash = imagePath.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return imagePath + ".ktx2";
+    return imagePath.substr(0, dot) + ".ktx2";
+}
+
+} // namespace cgcc
+
+#endif // CGCC_KTX2_H
@@ -0,0 +1,366 @@
+/* MipChain.h - mip levels built on the CPU, filtered in linear light
+ *
+ * glGenerateMipmap averages the stored bytes, which for sRGB-encoded art (every
+ * PNG in assets/) darkens the smaller levels: the mean of 0 and 255 should be
+ * 188, not 128. Here each level is decoded to linear floats, filtered, and
+ * encoded back to sRGB (alpha is always linear), so no GL work is needed.
+ *
+ * Two filters, both separable and applied to the previous level:
+ *   Box     2x2 average, fast and what glGenerateMipmap usually does
+ *   Kaiser  6 taps per axis (Kaiser-windowed sinc), sharper minified texels
+ * Pixels are filtered as one 4-float SSE2 vector each when the compiler targets
+ * SSE2, and the rows of a large level are split across threads.
+ *
+ * Generating the chain of a big texture still costs more than reading it, so
+ * the result can be cached on disk under mipCacheDir, keyed on the image path,
+ * its size and modification time and the filter options. loadMipChain() does
+ * the whole thing for an image file: cache, else stb_image + generate + store.
+ */
+
+#ifndef CGCC_MIPCHAIN_H
+#define CGCC_MIPCHAIN_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CGCC_MIP_SSE2 1
+#endif
+
+#include <stb_image.h>
+
+#include "ProgramCache.h" // hashBytes
+
+namespace cgcc {
+
+enum class MipFilter { Box, Kaiser };
+
+struct MipOptions {
+    bool srgb = true;                  // color data: filter in linear light (false for normal maps, masks...)
+    MipFilter filter = MipFilter::Box;
+    int threads = 0;                   // 0 = one per core
+};
+
+inline const float* srgbDecodeTable()
+{
+    static const std::vector<float> table = [] {
+        std::vector<float> values(256);
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// Linear [0,1] quantized to 16 bits -> sRGB byte; fine enough for every byte to round-trip
+const int srgbEncodeSteps = 65536;
+
+inline const uint8_t* srgbEncodeTable()
+{
+    static const std::vector<uint8_t> table = [] {
+        std::vector<uint8_t> values(srgbEncodeSteps);
+        for (int i = 0; i < srgbEncodeSteps; ++i)
+        {
+            float l = (float)i / (srgbEncodeSteps - 1);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            values[i] = (uint8_t)std::clamp((int)(c * 255.0f + 0.5f), 0, 255);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// Taps of one axis: source texels 2x+first .. 2x+first+taps-1 for output texel x
+struct MipKernel {
+    int first, taps;
+    float weights[6];
+};
+
+inline float besselI0(float x)
+{
+    float sum = 1.0f, term = 1.0f;
+    for (int k = 1; k < 16; ++k)
+    {
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum += term;
+    }
+    return sum;
+}
+
+inline MipKernel mipKernel(MipFilter filter)
+{
+    if (filter == MipFilter::Box)
+        return { 0, 2, { 0.5f, 0.5f } };
+
+    // Kaiser-windowed sinc at half the source frequency, radius 3 source texels, alpha 4
+    const float radius = 3.0f, alpha = 4.0f, pi = 3.14159265f;
+    MipKernel kernel = { -2, 6, {} };
+    float sum = 0.0f;
+    for (int t = 0; t < kernel.taps; ++t)
+    {
+        float d = (kernel.first + t) - 0.5f; // texel center relative to the output texel center
+        float x = d * 0.5f;
+        float sinc = std::sin(pi * x) / (pi * x);
+        float r = d / radius;
+        kernel.weights[t] = sinc * besselI0(alpha * std::sqrt(std::max(0.0f, 1.0f - r * r))) / besselI0(alpha);
+        sum += kernel.weights[t];
+    }
+    for (int t = 0; t < kernel.taps; ++t)
+        kernel.weights[t] /= sum;
+    return kernel;
+}
+
+// Output rows [y0, y1) of the next level. Each source row is decoded and
+// filtered horizontally once into a small ring, then the taps are combined
+// vertically; edges are clamped.
+inline void downsampleRows(const uint8_t* src, int width, int height, uint8_t* dst, int outWidth,
+                           const MipKernel& kernel, bool srgb, int y0, int y1)
+{
+    const float* decode = srgbDecodeTable();
+    const uint8_t* encode = srgbEncodeTable();
+    size_t outFloats = (size_t)outWidth * 4;
+    std::vector<float> linear((size_t)width * 4);
+    std::vector<float> ring(kernel.taps * outFloats);
+    std::vector<int> ringRow(kernel.taps, -1);
+    std::vector<float> column(outFloats);
+
+    auto filteredRow = [&](int sy) -> const float* {
+        sy = std::clamp(sy, 0, height - 1);
+        int slot = sy % kernel.taps;
+        float* row = &ring[slot * outFloats];
+        if (ringRow[slot] == sy)
+            return row;
+        ringRow[slot] = sy;
+
+        const uint8_t* in = src + (size_t)sy * width * 4;
+        for (int x = 0; x < width; ++x)
+        {
+            for (int c = 0; c < 3; ++c)
+                linear[x * 4 + c] = srgb ? decode[in[x * 4 + c]] : in[x * 4 + c] * (1.0f / 255.0f);
+            linear[x * 4 + 3] = in[x * 4 + 3] * (1.0f / 255.0f);
+        }
+        for (int x = 0; x < outWidth; ++x)
+        {
+#ifdef CGCC_MIP_SSE2
+            __m128 sum = _mm_setzero_ps();
+            for (int t = 0; t < kernel.taps; ++t)
+            {
+                int sx = std::clamp(2 * x + kernel.first + t, 0, width - 1);
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[t]), _mm_loadu_ps(&linear[sx * 4])));
+            }
+            _mm_storeu_ps(&row[x * 4], sum);
+#else
+            float sum[4] = {};
+            for (int t = 0; t < kernel.taps; ++t)
+            {
+                int sx = std::clamp(2 * x + kernel.first + t, 0, width - 1);
+                for (int c = 0; c < 4; ++c)
+                    sum[c] += kernel.weights[t] * linear[sx * 4 + c];
+            }
+            std::memcpy(&row[x * 4], sum, sizeof(sum));
+#endif
+        }
+        return row;
+    };
+
+    const float* taps[6];
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int t = 0; t < kernel.taps; ++t)
+            taps[t] = filteredRow(2 * y + kernel.first + t);
+        for (size_t i = 0; i < outFloats; i += 4)
+        {
+#ifdef CGCC_MIP_SSE2
+            __m128 sum = _mm_setzero_ps();
+            for (int t = 0; t < kernel.taps; ++t)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[t]), _mm_loadu_ps(taps[t] + i)));
+            // The Kaiser lobes can overshoot
+            sum = _mm_min_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            _mm_storeu_ps(&column[i], sum);
+#else
+            for (int c = 0; c < 4; ++c)
+            {
+                float sum = 0.0f;
+                for (int t = 0; t < kernel.taps; ++t)
+                    sum += kernel.weights[t] * taps[t][i + c];
+                column[i + c] = std::clamp(sum, 0.0f, 1.0f);
+            }
+#endif
+        }
+        uint8_t* out = dst + (size_t)y * outWidth * 4;
+        for (size_t i = 0; i < outFloats; i += 4)
+        {
+            for (int c = 0; c < 3; ++c)
+                out[i + c] = srgb ? encode[(int)(column[i + c] * (srgbEncodeSteps - 1) + 0.5f)] : (uint8_t)(column[i + c] * 255.0f + 0.5f);
+            out[i + 3] = (uint8_t)(column[i + 3] * 255.0f + 0.5f);
+        }
+    }
+}
+
+// Next mip level (half size, at least 1x1) of an RGBA8 image
+inline std::vector<uint8_t> downsampleLevel(const std::vector<uint8_t>& rgba, int width, int height,
+                                            int& outWidth, int& outHeight, const MipOptions& options = {})
+{
+    outWidth = std::max(1, width / 2);
+    outHeight = std::max(1, height / 2);
+    std::vector<uint8_t> out((size_t)outWidth * outHeight * 4);
+    MipKernel kernel = mipKernel(options.filter);
+    // The tables are built once, before any worker can race on them
+    srgbDecodeTable();
+    srgbEncodeTable();
+
+    // Threads only pay off on the larger levels (~32K texels each at least)
+    int threads = options.threads > 0 ? options.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min({ threads, outHeight, std::max(1, outWidth * outHeight / 32768) });
+    if (threads <= 1)
+    {
+        downsampleRows(rgba.data(), width, height, out.data(), outWidth, kernel, options.srgb, 0, outHeight);
+        return out;
+    }
+    std::vector<std::thread> workers;
+    int rowsPerThread = (outHeight + threads - 1) / threads;
+    for (int y0 = 0; y0 < outHeight; y0 += rowsPerThread)
+    {
+        int y1 = std::min(outHeight, y0 + rowsPerThread);
+        workers.emplace_back(downsampleRows, rgba.data(), width, height, out.data(), outWidth, std::cref(kernel), options.srgb, y0, y1);
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+    return out;
+}
+
+// Fills levels[1..] down to 1x1; levels[0] must already hold the width x height image
+inline void generateMipLevels(std::vector<std::vector<uint8_t>>& levels, int width, int height, const MipOptions& options = {})
+{
+    levels.resize(1);
+    while (width > 1 || height > 1)
+    {
+        std::vector<uint8_t> next = downsampleLevel(levels.back(), width, height, width, height, options);
+        levels.push_back(std::move(next));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Disk cache of generated chains
+// ---------------------------------------------------------------------------
+
+// Relative to the working directory, like programCacheDir
+inline std::string mipCacheDir = "texture_cache";
+inline bool mipCacheEnabled = true;
+
+// File layout: header, then the levels from 0 down, tightly packed RGBA8
+struct MipCacheHeader {
+    char magic[4]; // "CGMC"
+    uint32_t version;
+    uint64_t key;
+    int32_t width, height;
+    uint32_t levelCount;
+};
+const uint32_t mipCacheFileVersion = 1;
+
+// Key of an image file as it is now, with the options used to filter it
+inline uint64_t mipCacheKey(const std::string& imagePath, const MipOptions& options)
+{
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(imagePath, error);
+    int64_t time = error ? 0 : (int64_t)std::filesystem::last_write_time(imagePath, error).time_since_epoch().count();
+    uint64_t hash = hashBytes(&mipCacheFileVersion, sizeof(mipCacheFileVersion));
+    hash = hashBytes(imagePath.c_str(), imagePath.size() + 1, hash);
+    hash = hashBytes(&size, sizeof(size), hash);
+    hash = hashBytes(&time, sizeof(time), hash);
+    uint8_t flags[2] = { (uint8_t)options.srgb, (uint8_t)options.filter };
+    return hashBytes(flags, sizeof(flags), hash);
+}
+
+inline std::string mipCachePath(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mips", (unsigned long long)key);
+    return mipCacheDir + "/" + name;
+}
+
+// Restores a whole chain (level 0 included); false when there is no usable entry
+inline bool loadCachedMips(uint64_t key, std::vector<std::vector<uint8_t>>& levels, int& width, int& height)
+{
+    if (!mipCacheEnabled)
+        return false;
+    std::ifstream file(mipCachePath(key), std::ios::binary);
+    if (!file)
+        return false;
+    MipCacheHeader header;
+    file.read((char*)&header, sizeof(header));
+    if (!file || std::memcmp(header.magic, "CGMC", 4) != 0 || header.version != mipCacheFileVersion ||
+        header.key != key || header.width <= 0 || header.height <= 0 || header.levelCount == 0 || header.levelCount > 32)
+        return false;
+    levels.assign(header.levelCount, {});
+    for (uint32_t i = 0; i < header.levelCount; ++i)
+    {
+        int w = std::max(1, header.width >> i), h = std::max(1, header.height >> i);
+        levels[i].resize((size_t)w * h * 4);
+        file.read((char*)levels[i].data(), (std::streamsize)levels[i].size());
+    }
+    if (!file)
+        return false;
+    width = header.width;
+    height = header.height;
+    return true;
+}
+
+inline void storeCachedMips(uint64_t key, const std::vector<std::vector<uint8_t>>& levels, int width, int height)
+{
+    if (!mipCacheEnabled || levels.empty())
+        return;
+    std::error_code error;
+    std::filesystem::create_directories(mipCacheDir, error);
+    MipCacheHeader header = { { 'C', 'G', 'M', 'C' }, mipCacheFileVersion, key, width, height, (uint32_t)levels.size() };
+    // Written under a temporary name and renamed, so a crash never leaves a truncated entry
+    std::string path = mipCachePath(key);
+    std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        file.write((const char*)&header, sizeof(header));
+        for (const std::vector<uint8_t>& level : levels)
+            file.write((const char*)level.data(), (std::streamsize)level.size());
+        if (!file)
+            return;
+    }
+    std::filesystem::rename(tempPath, path, error);
+}
+
+// Whole chain of an image file as RGBA8, from the cache when it is up to date.
+// Thread safe: meant to run on loader threads.
+inline bool loadMipChain(const std::string& path, const MipOptions& options, std::vector<std::vector<uint8_t>>& levels, int& width, int& height)
+{
+    uint64_t key = mipCacheKey(path, options);
+    if (loadCachedMips(key, levels, width, height))
+        return true;
+
+    int channels;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!data)
+        return false;
+    levels.assign(1, std::vector<uint8_t>(data, data + (size_t)width * height * 4));
+    stbi_image_free(data);
+    generateMipLevels(levels, width, height, options);
+    storeCachedMips(key, levels, width, height);
+    return true;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_MIPCHAIN_H
@@ -0,0 +1,227 @@
+/* OBJLoader.h - the text half of the examples' loadSimpleOBJ
+ *
+ * Reads the v / vt / vn / f lines of an OBJ file and packs one vertex per
+ * face corner in the order of any VertexLayout (VertexLayout.h). The color
+ * is the same for every vertex. A corner without a normal gets (0, 0, 1):
+ *
+ *     cgcc::PackedVertices<ObjVertex> vBuffer;
+ *     std::vector<glm::vec3> positions;
+ *     if (cgcc::parseSimpleOBJ("Suzanne.obj", color, vBuffer, positions))
+ *         ...glBufferData(GL_ARRAY_BUFFER, vBuffer.size(), vBuffer.data(), ...)
+ *
+ * Faces are expected to be triangles; they are not triangulated. positions
+ * gets the "v" lines as listed in the file. Creating the buffers stays in
+ * the examples, so the parsing can be measured on its own (cgcc_microbench).
+ *
+ * The file is read whole into a LinearArena (Arena.h) and parsed in place,
+ * counting the lines once first, so positions and vBuffer grow once and the
+ * vt / vn arrays live in the arena. Pass the same scratch arena to several
+ * loads and reset it after them to keep the heap out of loading.
+ */
+
+#ifndef CGCC_OBJLOADER_H
+#define CGCC_OBJLOADER_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "VertexLayout.h"
+#include "Arena.h"
+
+namespace cgcc {
+
+// Everything a face corner can give to a vertex
+struct OBJCorner {
+    glm::vec3 position;
+    glm::vec3 color;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+inline const float* objCornerAttribute(const OBJCorner& corner, VertexAttribute attribute)
+{
+    switch (attribute)
+    {
+    case VertexAttribute::Position: return &corner.position[0];
+    case VertexAttribute::Color: return &corner.color[0];
+    case VertexAttribute::Normal: return &corner.normal[0];
+    default: return &corner.texCoord[0];
+    }
+}
+
+template <typename Layout, size_t... I>
+inline void pushOBJCorner(PackedVertices<Layout>& vBuffer, const OBJCorner& corner, std::index_sequence<I...>)
+{
+    vBuffer.push(objCornerAttribute(corner, Layout::attributes[I])...);
+}
+
+inline bool objSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+inline const char* objSkipSpace(const char* p, const char* lineEnd)
+{
+    while (p < lineEnd && objSpace(*p))
+        p++;
+    return p;
+}
+
+inline const char* objTokenEnd(const char* p, const char* lineEnd)
+{
+    while (p < lineEnd && !objSpace(*p))
+        p++;
+    return p;
+}
+
+// Whether the first word of a line is keyword; if so p moves past it
+inline bool objKeyword(const char*& p, const char* lineEnd, const char* keyword)
+{
+    const char* begin = objSkipSpace(p, lineEnd);
+    const char* end = objTokenEnd(begin, lineEnd);
+    size_t length = std::strlen(keyword);
+    if ((size_t)(end - begin) != length || std::memcmp(begin, keyword, length) != 0)
+        return false;
+    p = end;
+    return true;
+}
+
+// Up to count floats from the rest of a line; missing ones are 0
+inline void objFloats(const char* p, const char* lineEnd, float* values, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        p = objSkipSpace(p, lineEnd);
+        char* next = const_cast<char*>(p);
+        values[i] = p < lineEnd ? std::strtof(p, &next) : 0.0f;
+        if (next == p)
+            p = lineEnd;
+        else
+            p = next;
+    }
+}
+
+// One v/vt/vn index of a face corner, 1-based in the file; empty gives 0
+inline int objIndex(const char* begin, const char* end)
+{
+    if (begin == end)
+        return 0;
+    return (int)std::strtol(begin, nullptr, 10) - 1;
+}
+
+// The whole file, zero-terminated, in memory from the arena
+inline const char* readOBJText(const std::string& path, LinearArena& arena, size_t& size)
+{
+    std::ifstream arqEntrada(path.c_str(), std::ios::binary | std::ios::ate);
+    if (!arqEntrada.is_open())
+        return nullptr;
+    size = (size_t)arqEntrada.tellg();
+    char* text = arena.allocate<char>(size + 1);
+    arqEntrada.seekg(0);
+    arqEntrada.read(text, (std::streamsize)size);
+    size = (size_t)arqEntrada.gcount();
+    text[size] = '\0';
+    return text;
+}
+
+// scratch holds the file and the vt/vn arrays until its next reset; without
+// one, a temporary arena is used
+template <typename Layout>
+inline bool parseSimpleOBJ(const std::string& path, glm::vec3 color, PackedVertices<Layout>& vBuffer, std::vector<glm::vec3>& positions, LinearArena* scratch = nullptr)
+{
+    LinearArena localArena;
+    LinearArena& arena = scratch ? *scratch : localArena;
+
+    size_t size = 0;
+    const char* text = readOBJText(path, arena, size);
+    if (!text)
+    {
+        std::cerr << "Erro ao tentar ler o arquivo " << path << std::endl;
+        return false;
+    }
+    const char* textEnd = text + size;
+
+    // Count first, so every array is allocated once at its final size
+    size_t vertexCount = 0, texCoordCount = 0, normalCount = 0, cornerCount = 0;
+    for (const char* line = text; line < textEnd;)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', textEnd - line));
+        if (!lineEnd)
+            lineEnd = textEnd;
+        const char* p = line;
+        if (objKeyword(p, lineEnd, "v")) vertexCount++;
+        else if (objKeyword(p, lineEnd, "vt")) texCoordCount++;
+        else if (objKeyword(p, lineEnd, "vn")) normalCount++;
+        else if (objKeyword(p, lineEnd, "f"))
+        {
+            for (p = objSkipSpace(p, lineEnd); p < lineEnd; p = objSkipSpace(objTokenEnd(p, lineEnd), lineEnd))
+                cornerCount++;
+        }
+        line = lineEnd + 1;
+    }
+
+    positions.clear();
+    positions.reserve(vertexCount);
+    glm::vec2* texCoords = arena.allocate<glm::vec2>(texCoordCount);
+    glm::vec3* normals = arena.allocate<glm::vec3>(normalCount);
+    size_t nTexCoords = 0, nNormals = 0;
+    vBuffer.reserve(vBuffer.count() + cornerCount);
+
+    for (const char* line = text; line < textEnd;)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', textEnd - line));
+        if (!lineEnd)
+            lineEnd = textEnd;
+        const char* p = line;
+
+        if (objKeyword(p, lineEnd, "v"))
+        {
+            glm::vec3 vertice;
+            objFloats(p, lineEnd, &vertice[0], 3);
+            positions.push_back(vertice);
+        }
+        else if (objKeyword(p, lineEnd, "vt"))
+        {
+            objFloats(p, lineEnd, &texCoords[nTexCoords++][0], 2);
+        }
+        else if (objKeyword(p, lineEnd, "vn"))
+        {
+            objFloats(p, lineEnd, &normals[nNormals++][0], 3);
+        }
+        else if (objKeyword(p, lineEnd, "f"))
+        {
+            for (p = objSkipSpace(p, lineEnd); p < lineEnd; p = objSkipSpace(p, lineEnd))
+            {
+                const char* tokenEnd = objTokenEnd(p, lineEnd);
+                // v, v/vt, v//vn or v/vt/vn
+                const char* slash1 = static_cast<const char*>(std::memchr(p, '/', tokenEnd - p));
+                const char* slash2 = slash1 ? static_cast<const char*>(std::memchr(slash1 + 1, '/', tokenEnd - slash1 - 1)) : nullptr;
+                int vi = objIndex(p, slash1 ? slash1 : tokenEnd);
+                int ti = slash1 ? objIndex(slash1 + 1, slash2 ? slash2 : tokenEnd) : 0;
+                int ni = slash2 ? objIndex(slash2 + 1, tokenEnd) : 0;
+                p = tokenEnd;
+
+                OBJCorner corner;
+                corner.position = (vi >= 0 && vi < (int)positions.size()) ? positions[vi] : glm::vec3(0.0f);
+                corner.color = color;
+                // Normal (if available, else a default one)
+                corner.normal = (ni >= 0 && ni < (int)nNormals) ? normals[ni] : glm::vec3(0.0f, 0.0f, 1.0f);
+                corner.texCoord = (ti >= 0 && ti < (int)nTexCoords) ? texCoords[ti] : glm::vec2(0.0f);
+                pushOBJCorner(vBuffer, corner, std::make_index_sequence<Layout::attributeCount>());
+            }
+        }
+        line = lineEnd + 1;
+    }
+    return true;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_OBJLOADER_H
@@ -0,0 +1,79 @@
+/* Palette.h - 8-bit indexed images for pixel art
+ *
+ * Pixel art like pixelWall.png uses a handful of colors, so storing it as RGBA8
+ * (plus mips that only blur it) wastes memory and bandwidth. palettizeImage()
+ * finds out whether an image has at most 256 distinct RGBA colors and, if so,
+ * splits it into one byte per texel and a palette. On the GPU that becomes:
+ *
+ *     GL_R8UI index texture, GL_NEAREST, no mips   (1 byte per texel, 4x less than RGBA8)
+ *     palette as a colors x 1 GL_RGBA8 texture      (at most 1 KB)
+ *
+ * and the shader looks the color up itself:
+ *
+ *     uniform usampler2D texIndex;
+ *     uniform sampler2D texPalette;
+ *     vec4 c = texelFetch(texPalette, ivec2(texture(texIndex, uv).r, 0), 0);
+ *
+ * Integer textures cannot be filtered, so this is only for art meant to be
+ * sampled nearest. TextureStreamer.h imports images this way when asked to.
+ */
+
+#ifndef CGCC_PALETTE_H
+#define CGCC_PALETTE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+namespace cgcc {
+
+const int maxPaletteColors = 256;
+
+// Indices (one byte per texel) and palette (RGBA8, one entry per color) of an
+// image; false, leaving them unspecified, when it has more than maxColors colors
+inline bool palettizeImage(const uint8_t* rgba, int width, int height, std::vector<uint8_t>& indices,
+                           std::vector<uint8_t>& palette, int maxColors = maxPaletteColors)
+{
+    // Open addressing over 4x as many slots as colors, so probes stay short
+    const uint32_t slots = 1024;
+    uint32_t keys[slots];
+    int16_t values[slots];
+    std::memset(values, -1, sizeof(values));
+
+    size_t count = (size_t)width * height;
+    indices.resize(count);
+    palette.clear();
+    uint32_t lastColor = 0;
+    int lastIndex = -1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t color;
+        std::memcpy(&color, rgba + i * 4, 4);
+        // Pixel art comes in runs of the same color
+        if (color == lastColor && lastIndex >= 0)
+        {
+            indices[i] = (uint8_t)lastIndex;
+            continue;
+        }
+        uint32_t slot = (color * 2654435761u) >> 22;
+        while (values[slot] >= 0 && keys[slot] != color)
+            slot = (slot + 1) & (slots - 1);
+        if (values[slot] < 0)
+        {
+            int colors = (int)palette.size() / 4;
+            if (colors >= maxColors)
+                return false;
+            keys[slot] = color;
+            values[slot] = (int16_t)colors;
+            palette.insert(palette.end(), rgba + i * 4, rgba + i * 4 + 4);
+        }
+        lastColor = color;
+        lastIndex = values[slot];
+        indices[i] = (uint8_t)lastIndex;
+    }
+    return true;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_PALETTE_H
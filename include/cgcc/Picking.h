@@ -0,0 +1,71 @@
+/* Picking.h - where the Atividade Vivencial models are, and which one a ray hits
+ *
+ * composeModelMatrix() is the model matrix of an object given as position,
+ * Euler angles in degrees (applied x, then y, then z) and scale. It is shared
+ * by the draw loop and by picking, which moves the click ray into the model's
+ * space with its inverse and tests it against the triangles with
+ * intersectTriangle() (Moller-Trumbore).
+ */
+
+#ifndef CGCC_PICKING_H
+#define CGCC_PICKING_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace cgcc {
+
+inline glm::mat4 composeModelMatrix(const glm::vec3& position, const glm::vec3& rotationDegrees, const glm::vec3& scale)
+{
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+    model = glm::rotate(model, glm::radians(rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+    model = glm::rotate(model, glm::radians(rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::rotate(model, glm::radians(rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(model, scale);
+}
+
+// Function to test for ray-triangle intersection (Moller-Trumbore algorithm)
+inline bool intersectTriangle(const glm::vec3& rayOrigin, const glm::vec3& rayDir, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& outDistance)
+{
+    const float EPSILON = 0.0000001f;
+    glm::vec3 edge1, edge2, h, s, q;
+    float a, f, u, v;
+
+    edge1 = v1 - v0;
+    edge2 = v2 - v0;
+
+    h = glm::cross(rayDir, edge2);
+    a = glm::dot(edge1, h);
+
+    if (a > -EPSILON && a < EPSILON)
+        return false; // Ray is parallel to the triangle
+
+    f = 1.0f / a;
+    s = rayOrigin - v0;
+    u = f * glm::dot(s, h);
+
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    q = glm::cross(s, edge1);
+    v = f * glm::dot(rayDir, q);
+
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    // At this stage, we can compute t to find out where the intersection point is on the line.
+    float t = f * glm::dot(edge2, q);
+
+    if (t > EPSILON) // ray intersects the triangle
+    {
+        outDistance = t;
+        return true;
+    }
+
+    // This means that the intersection point was behind the ray
+    return false;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_PICKING_H
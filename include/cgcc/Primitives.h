@@ -0,0 +1,434 @@
+/* Primitives.h - indexed procedural meshes, generated once and cached
+ *
+ * A UV sphere written as a triangle soup stores every vertex of a quad once
+ * per triangle that uses it (6 vertices per quad instead of about 1) and, when
+ * each corner is recomputed with cos/sin, pays for the trig 4 times per quad.
+ * Here every primitive is generated with shared vertices and an index buffer:
+ *
+ *     uvSphere(radius, latSegments, lonSegments)  rings of (lon+1) vertices, seam duplicated for the UVs
+ *     icosphere(radius, subdivisions)             subdivided icosahedron, evenly spread triangles
+ *     cube(size)                                  24 vertices, flat normals per face
+ *     pyramid(base, height)                       square base, apex on +y, flat normals
+ *     plane(width, depth, xSegments, zSegments)   grid on y = 0 facing +y
+ *
+ * The UV sphere evaluates sin/cos once per ring and once per column and then
+ * builds each ring from those tables, 4 vertices at a time with SSE2 when the
+ * compiler targets it (bit-identical to the scalar path).
+ *
+ * The vertex buffer holds all positions first (xyz, tightly packed) and then
+ * the other attributes (normal xyz, uv), so the same buffer and index buffer
+ * also serve a position-only VAO for the depth prepass (DepthPrepass.h).
+ * Attribute locations are 0 (position), 2 (normal) and 3 (texture coordinate),
+ * leaving 1 free for a color. Triangles are counter-clockwise seen from
+ * outside, and indices are 16-bit when the mesh fits.
+ *
+ * Meshes live in a PrimitiveCache keyed by (type, parameters): asking again
+ * for the same sphere returns the buffers already on the GPU.
+ *
+ *     cgcc::PrimitiveCache primitives;
+ *     cgcc::PrimitiveMesh sphere = cgcc::uvSphere(primitives, 0.5f, 16, 16);
+ *     glBindVertexArray(sphere.vao);
+ *     cgcc::drawPrimitive(sphere);
+ */
+
+#ifndef CGCC_PRIMITIVES_H
+#define CGCC_PRIMITIVES_H
+
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CGCC_PRIMITIVES_SSE2 1
+#endif
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "VertexLayout.h"
+
+namespace cgcc {
+
+const GLuint primitivePositionAttrib = 0;
+const GLuint primitiveNormalAttrib = 2;
+const GLuint primitiveTexCoordAttrib = 3;
+
+// The two streams of the vertex buffer
+using PrimitivePositionLayout = VertexLayout<VertexAttrib<VertexAttribute::Position>>;
+using PrimitiveAttributeLayout = VertexLayout<
+    VertexAttrib<VertexAttribute::Normal, VertexFormat::Float3, primitiveNormalAttrib>,
+    VertexAttrib<VertexAttribute::TexCoord, VertexFormat::Float2, primitiveTexCoordAttrib>>;
+
+enum class PrimitiveType { UVSphere, Icosphere, Cube, Pyramid, Plane };
+
+// Mesh on the CPU: positions and attributes are separate streams of the same vertices
+struct PrimitiveData {
+    std::vector<GLfloat> positions;  // x y z
+    std::vector<GLfloat> attributes; // nx ny nz u v
+    std::vector<GLuint> indices;     // triangles
+
+    size_t vertexCount() const { return positions.size() / 3; }
+};
+
+struct PrimitiveMesh {
+    GLuint vao = 0;         // position, normal, uv
+    GLuint positionVAO = 0; // position only, same buffers
+    GLuint vbo = 0, ebo = 0;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+};
+
+inline void addPrimitiveVertex(PrimitiveData& data, glm::vec3 position, glm::vec3 normal, glm::vec2 uv)
+{
+    data.positions.insert(data.positions.end(), { position.x, position.y, position.z });
+    data.attributes.insert(data.attributes.end(), { normal.x, normal.y, normal.z, uv.x, uv.y });
+}
+
+// Rings from the pole at +y (theta = 0) to -y; column j at phi = j * 2pi / lonSegments
+inline PrimitiveData generateUVSphere(float radius, int latSegments, int lonSegments)
+{
+    const float pi = glm::pi<float>();
+    int columns = lonSegments + 1;
+
+    // Trig tables, once per column and once per ring
+    std::vector<float> radiusCos(columns), radiusSin(columns), columnU(columns);
+    for (int j = 0; j < columns; ++j)
+    {
+        float phi = j * 2.0f * pi / lonSegments;
+        radiusCos[j] = radius * std::cos(phi);
+        radiusSin[j] = radius * std::sin(phi);
+        columnU[j] = phi / (2.0f * pi);
+    }
+
+    PrimitiveData data;
+    data.positions.resize((size_t)(latSegments + 1) * columns * 3);
+    data.attributes.resize((size_t)(latSegments + 1) * columns * 5);
+    for (int i = 0; i <= latSegments; ++i)
+    {
+        float theta = i * pi / latSegments;
+        float sinTheta = std::sin(theta);
+        float y = radius * std::cos(theta);
+        float v = theta / pi;
+        GLfloat* position = &data.positions[(size_t)i * columns * 3];
+        GLfloat* attribute = &data.attributes[(size_t)i * columns * 5];
+        int j = 0;
+#ifdef CGCC_PRIMITIVES_SSE2
+        __m128 ringSin = _mm_set1_ps(sinTheta);
+        __m128 yy = _mm_set1_ps(y * y);
+        __m128 vy = _mm_set1_ps(y);
+        for (; j + 4 <= columns; j += 4)
+        {
+            __m128 x = _mm_mul_ps(_mm_loadu_ps(&radiusCos[j]), ringSin);
+            __m128 z = _mm_mul_ps(_mm_loadu_ps(&radiusSin[j]), ringSin);
+            // normal = position / |position|, rounded like glm::normalize
+            __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), yy), _mm_mul_ps(z, z)));
+            __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), length);
+            alignas(16) float lanes[5][4];
+            _mm_store_ps(lanes[0], x);
+            _mm_store_ps(lanes[1], z);
+            _mm_store_ps(lanes[2], _mm_mul_ps(x, inverse));
+            _mm_store_ps(lanes[3], _mm_mul_ps(vy, inverse));
+            _mm_store_ps(lanes[4], _mm_mul_ps(z, inverse));
+            for (int k = 0; k < 4; ++k)
+            {
+                GLfloat* p = position + (j + k) * 3;
+                GLfloat* a = attribute + (j + k) * 5;
+                p[0] = lanes[0][k]; p[1] = y; p[2] = lanes[1][k];
+                a[0] = lanes[2][k]; a[1] = lanes[3][k]; a[2] = lanes[4][k];
+                a[3] = columnU[j + k]; a[4] = v;
+            }
+        }
+#endif
+        for (; j < columns; ++j)
+        {
+            glm::vec3 p(radiusCos[j] * sinTheta, y, radiusSin[j] * sinTheta);
+            glm::vec3 n = glm::normalize(p);
+            GLfloat* a = attribute + j * 5;
+            position[j * 3 + 0] = p.x; position[j * 3 + 1] = p.y; position[j * 3 + 2] = p.z;
+            a[0] = n.x; a[1] = n.y; a[2] = n.z;
+            a[3] = columnU[j]; a[4] = v;
+        }
+    }
+
+    data.indices.reserve((size_t)latSegments * lonSegments * 6);
+    for (int i = 0; i < latSegments; ++i)
+    {
+        for (int j = 0; j < lonSegments; ++j)
+        {
+            GLuint v0 = i * columns + j, v1 = v0 + columns, v2 = v0 + 1, v3 = v1 + 1;
+            data.indices.insert(data.indices.end(), { v0, v2, v1, v1, v2, v3 });
+        }
+    }
+    return data;
+}
+
+// Each subdivision splits every triangle in 4 and pushes the new vertices out
+// to the sphere. The UVs follow the UV sphere's convention but the seam is not
+// split, so prefer uvSphere() for textured spheres.
+inline PrimitiveData generateIcosphere(float radius, int subdivisions)
+{
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> directions = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 },
+    };
+    for (glm::vec3& d : directions)
+        d = glm::normalize(d);
+    std::vector<GLuint> triangles = {
+        0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+        1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+        3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+        4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1,
+    };
+
+    for (int s = 0; s < subdivisions; ++s)
+    {
+        // An edge's midpoint is shared by the two triangles on either side
+        std::unordered_map<uint64_t, GLuint> midpoints;
+        auto midpoint = [&](GLuint a, GLuint b) {
+            uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            GLuint index = (GLuint)directions.size();
+            directions.push_back(glm::normalize(directions[a] + directions[b]));
+            midpoints.emplace(key, index);
+            return index;
+        };
+        std::vector<GLuint> subdivided;
+        subdivided.reserve(triangles.size() * 4);
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            GLuint a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+            GLuint ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            subdivided.insert(subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+        }
+        triangles.swap(subdivided);
+    }
+
+    const float pi = glm::pi<float>();
+    PrimitiveData data;
+    data.positions.reserve(directions.size() * 3);
+    data.attributes.reserve(directions.size() * 5);
+    for (const glm::vec3& d : directions)
+    {
+        float phi = std::atan2(d.z, d.x);
+        if (phi < 0.0f)
+            phi += 2.0f * pi;
+        glm::vec2 uv(phi / (2.0f * pi), std::acos(glm::clamp(d.y, -1.0f, 1.0f)) / pi);
+        addPrimitiveVertex(data, d * radius, d, uv);
+    }
+    data.indices = std::move(triangles);
+    return data;
+}
+
+// Quad with corners origin, origin + u, origin + u + v, origin + v (counter-clockwise seen from the normal)
+inline void addPrimitiveQuad(PrimitiveData& data, glm::vec3 origin, glm::vec3 u, glm::vec3 v, glm::vec3 normal)
+{
+    GLuint first = (GLuint)data.vertexCount();
+    addPrimitiveVertex(data, origin, normal, { 0, 0 });
+    addPrimitiveVertex(data, origin + u, normal, { 1, 0 });
+    addPrimitiveVertex(data, origin + u + v, normal, { 1, 1 });
+    addPrimitiveVertex(data, origin + v, normal, { 0, 1 });
+    data.indices.insert(data.indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+}
+
+inline PrimitiveData generateCube(float size)
+{
+    float h = size * 0.5f;
+    PrimitiveData data;
+    addPrimitiveQuad(data, { -h, -h, h }, { size, 0, 0 }, { 0, size, 0 }, { 0, 0, 1 });     // front
+    addPrimitiveQuad(data, { h, -h, -h }, { -size, 0, 0 }, { 0, size, 0 }, { 0, 0, -1 });   // back
+    addPrimitiveQuad(data, { h, -h, h }, { 0, 0, -size }, { 0, size, 0 }, { 1, 0, 0 });     // right
+    addPrimitiveQuad(data, { -h, -h, -h }, { 0, 0, size }, { 0, size, 0 }, { -1, 0, 0 });   // left
+    addPrimitiveQuad(data, { -h, h, h }, { size, 0, 0 }, { 0, 0, -size }, { 0, 1, 0 });     // top
+    addPrimitiveQuad(data, { -h, -h, -h }, { size, 0, 0 }, { 0, 0, size }, { 0, -1, 0 });   // bottom
+    return data;
+}
+
+// Base on y = -height/2, apex at (0, height/2, 0)
+inline PrimitiveData generatePyramid(float base, float height)
+{
+    float b = base * 0.5f, y = height * 0.5f;
+    PrimitiveData data;
+    addPrimitiveQuad(data, { -b, -y, -b }, { base, 0, 0 }, { 0, 0, base }, { 0, -1, 0 });
+    glm::vec3 apex(0, y, 0);
+    glm::vec3 corners[4] = { { -b, -y, b }, { b, -y, b }, { b, -y, -b }, { -b, -y, -b } };
+    for (int i = 0; i < 4; ++i)
+    {
+        glm::vec3 a = corners[i], c = corners[(i + 1) % 4];
+        glm::vec3 normal = glm::normalize(glm::cross(c - a, apex - a));
+        GLuint first = (GLuint)data.vertexCount();
+        addPrimitiveVertex(data, a, normal, { 0, 0 });
+        addPrimitiveVertex(data, c, normal, { 1, 0 });
+        addPrimitiveVertex(data, apex, normal, { 0.5f, 1 });
+        data.indices.insert(data.indices.end(), { first, first + 1, first + 2 });
+    }
+    return data;
+}
+
+inline PrimitiveData generatePlane(float width, float depth, int xSegments, int zSegments)
+{
+    PrimitiveData data;
+    for (int i = 0; i <= zSegments; ++i)
+    {
+        float v = (float)i / zSegments;
+        for (int j = 0; j <= xSegments; ++j)
+        {
+            float u = (float)j / xSegments;
+            addPrimitiveVertex(data, { (u - 0.5f) * width, 0, (0.5f - v) * depth }, { 0, 1, 0 }, { u, v });
+        }
+    }
+    GLuint columns = xSegments + 1;
+    for (int i = 0; i < zSegments; ++i)
+    {
+        for (int j = 0; j < xSegments; ++j)
+        {
+            GLuint v0 = i * columns + j, v1 = v0 + 1, v2 = v0 + columns, v3 = v2 + 1;
+            data.indices.insert(data.indices.end(), { v0, v1, v3, v0, v3, v2 });
+        }
+    }
+    return data;
+}
+
+// Uploads a mesh into one VBO (positions, then attributes) and one EBO
+inline PrimitiveMesh createPrimitiveMesh(const PrimitiveData& data)
+{
+    PrimitiveMesh mesh;
+    size_t positionBytes = data.positions.size() * sizeof(GLfloat);
+    size_t attributeBytes = data.attributes.size() * sizeof(GLfloat);
+    glGenBuffers(1, &mesh.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glBufferData(GL_ARRAY_BUFFER, positionBytes + attributeBytes, NULL, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, positionBytes, data.positions.data());
+    glBufferSubData(GL_ARRAY_BUFFER, positionBytes, attributeBytes, data.attributes.data());
+
+    // The element buffer binding is VAO state: it is filled while the first VAO
+    // is bound and bound again for the second one
+    glGenBuffers(1, &mesh.ebo);
+    mesh.indexCount = (GLsizei)data.indices.size();
+    auto bindBuffers = [&](GLuint vao) {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+        setupVertexAttributes<PrimitivePositionLayout>();
+    };
+
+    glGenVertexArrays(1, &mesh.vao);
+    bindBuffers(mesh.vao);
+    if (data.vertexCount() <= 65536)
+    {
+        std::vector<GLushort> shortIndices(data.indices.begin(), data.indices.end());
+        mesh.indexType = GL_UNSIGNED_SHORT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), shortIndices.data(), GL_STATIC_DRAW);
+    }
+    else
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(GLuint), data.indices.data(), GL_STATIC_DRAW);
+    setupVertexAttributes<PrimitiveAttributeLayout>(positionBytes);
+
+    glGenVertexArrays(1, &mesh.positionVAO);
+    bindBuffers(mesh.positionVAO);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return mesh;
+}
+
+// Draws the mesh with whichever of its VAOs is bound
+inline void drawPrimitive(const PrimitiveMesh& mesh)
+{
+    glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, (GLvoid*)0);
+}
+
+inline void destroyPrimitiveMesh(PrimitiveMesh& mesh)
+{
+    if (mesh.vao) glDeleteVertexArrays(1, &mesh.vao);
+    if (mesh.positionVAO) glDeleteVertexArrays(1, &mesh.positionVAO);
+    if (mesh.vbo) glDeleteBuffers(1, &mesh.vbo);
+    if (mesh.ebo) glDeleteBuffers(1, &mesh.ebo);
+    mesh = PrimitiveMesh();
+}
+
+// What identifies a mesh: its type and the parameters it was generated with
+struct PrimitiveKey {
+    PrimitiveType type;
+    float size[2];
+    int segments[2];
+
+    bool operator==(const PrimitiveKey& other) const
+    {
+        return type == other.type && size[0] == other.size[0] && size[1] == other.size[1] &&
+               segments[0] == other.segments[0] && segments[1] == other.segments[1];
+    }
+};
+
+inline PrimitiveData generatePrimitive(const PrimitiveKey& key)
+{
+    switch (key.type)
+    {
+    case PrimitiveType::UVSphere: return generateUVSphere(key.size[0], key.segments[0], key.segments[1]);
+    case PrimitiveType::Icosphere: return generateIcosphere(key.size[0], key.segments[0]);
+    case PrimitiveType::Cube: return generateCube(key.size[0]);
+    case PrimitiveType::Pyramid: return generatePyramid(key.size[0], key.size[1]);
+    case PrimitiveType::Plane: return generatePlane(key.size[0], key.size[1], key.segments[0], key.segments[1]);
+    }
+    return PrimitiveData();
+}
+
+struct PrimitiveCache {
+    std::vector<std::pair<PrimitiveKey, PrimitiveMesh>> meshes;
+};
+
+// The cached mesh for key, generated and uploaded the first time it is asked for
+inline PrimitiveMesh getPrimitive(PrimitiveCache& cache, const PrimitiveKey& key)
+{
+    for (const auto& entry : cache.meshes)
+    {
+        if (entry.first == key)
+            return entry.second;
+    }
+    PrimitiveMesh mesh = createPrimitiveMesh(generatePrimitive(key));
+    cache.meshes.push_back({ key, mesh });
+    return mesh;
+}
+
+inline PrimitiveMesh uvSphere(PrimitiveCache& cache, float radius, int latSegments, int lonSegments)
+{
+    return getPrimitive(cache, { PrimitiveType::UVSphere, { radius, 0 }, { latSegments, lonSegments } });
+}
+
+inline PrimitiveMesh icosphere(PrimitiveCache& cache, float radius, int subdivisions)
+{
+    return getPrimitive(cache, { PrimitiveType::Icosphere, { radius, 0 }, { subdivisions, 0 } });
+}
+
+inline PrimitiveMesh cube(PrimitiveCache& cache, float size)
+{
+    return getPrimitive(cache, { PrimitiveType::Cube, { size, 0 }, { 0, 0 } });
+}
+
+inline PrimitiveMesh pyramid(PrimitiveCache& cache, float base, float height)
+{
+    return getPrimitive(cache, { PrimitiveType::Pyramid, { base, height }, { 0, 0 } });
+}
+
+inline PrimitiveMesh plane(PrimitiveCache& cache, float width, float depth, int xSegments = 1, int zSegments = 1)
+{
+    return getPrimitive(cache, { PrimitiveType::Plane, { width, depth }, { xSegments, zSegments } });
+}
+
+inline void destroyPrimitiveCache(PrimitiveCache& cache)
+{
+    for (auto& entry : cache.meshes)
+        destroyPrimitiveMesh(entry.second);
+    cache.meshes.clear();
+}
+
+} // namespace cgcc
+
+#endif // CGCC_PRIMITIVES_H
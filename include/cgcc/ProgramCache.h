@@ -0,0 +1,191 @@
+/* ProgramCache.h - on-disk cache of linked shader program binaries
+ *
+ * Compiling and linking GLSL from source on every launch gets slow as the
+ * number of programs grows. After a successful link the driver's binary is
+ * saved with glGetProgramBinary under programCacheDir, one file per program,
+ * named after a hash of everything that affects the result: the shader
+ * sources, the defines prepended to them, GL_RENDERER and GL_VERSION. The next
+ * start restores it with glProgramBinary instead of compiling.
+ *
+ * The cache is best effort and silent: a missing file, a format the driver no
+ * longer accepts or a binary it rejects (e.g. after a driver update) just
+ * returns 0, and the caller compiles from source and stores a fresh binary.
+ *
+ * Typical use around a compile + link:
+ *
+ *     uint64_t key = cgcc::programCacheKey({ vertexSource, fragmentSource });
+ *     if (GLuint program = cgcc::loadCachedProgram(key)) return program;
+ *     ... compile, glCreateProgram, cgcc::markProgramRetrievable(program), link ...
+ *     cgcc::storeCachedProgram(key, program);
+ */
+
+#ifndef CGCC_PROGRAMCACHE_H
+#define CGCC_PROGRAMCACHE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <initializer_list>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#include "GLExt.h"
+
+namespace cgcc {
+
+// Relative to the working directory (the executable's output folder)
+inline std::string programCacheDir = "shader_cache";
+inline bool programCacheEnabled = true;
+
+// File layout: header followed by `length` bytes of driver binary
+struct ProgramBinaryHeader {
+    char magic[4];   // "CGPB"
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+const uint32_t programBinaryFileVersion = 1;
+
+// FNV-1a, 64 bits
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Key of a program: its sources and defines plus the driver that will run it
+inline uint64_t programCacheKey(const std::vector<const GLchar*>& sources, const std::string& defines = "")
+{
+    uint64_t hash = hashBytes(&programBinaryFileVersion, sizeof(programBinaryFileVersion));
+    // Each string is hashed with its terminator so that ("ab", "c") != ("a", "bc")
+    auto mix = [&hash](const char* text) {
+        if (!text) text = "";
+        hash = hashBytes(text, std::strlen(text) + 1, hash);
+    };
+    for (const GLchar* source : sources)
+        mix(source);
+    mix(defines.c_str());
+    mix((const char*)glGetString(GL_RENDERER));
+    mix((const char*)glGetString(GL_VERSION));
+    return hash;
+}
+
+inline uint64_t programCacheKey(std::initializer_list<const GLchar*> sources, const std::string& defines = "")
+{
+    return programCacheKey(std::vector<const GLchar*>(sources), defines);
+}
+
+inline bool programCacheAvailable()
+{
+    return programCacheEnabled && glCaps.programBinary;
+}
+
+inline std::string programCachePath(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return programCacheDir + "/" + name;
+}
+
+// Must be called between glCreateProgram and glLinkProgram for the binary to be retrievable
+inline void markProgramRetrievable(GLuint program)
+{
+    if (programCacheAvailable())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+inline bool programBinaryFormatSupported(GLenum format)
+{
+    static std::vector<GLint> formats;
+    if (formats.empty())
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+        formats.resize(std::max(count, 0));
+        if (count > 0)
+            glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+    }
+    return std::find(formats.begin(), formats.end(), (GLint)format) != formats.end();
+}
+
+// Restores a linked program from the cache; returns 0 when there is no usable binary
+inline GLuint loadCachedProgram(uint64_t key)
+{
+    if (!programCacheAvailable())
+        return 0;
+    std::string path = programCachePath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return 0;
+
+    ProgramBinaryHeader header;
+    file.read((char*)&header, sizeof(header));
+    if (!file || std::memcmp(header.magic, "CGPB", 4) != 0 || header.version != programBinaryFileVersion ||
+        header.key != key || header.length == 0 || !programBinaryFormatSupported(header.format))
+        return 0;
+    std::vector<char> binary(header.length);
+    file.read(binary.data(), header.length);
+    if (!file)
+        return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)header.length);
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // Stale binary: drop it, the caller rebuilds from source and stores a new one
+        glDeleteProgram(program);
+        file.close();
+        std::remove(path.c_str());
+        return 0;
+    }
+    return program;
+}
+
+// Saves the binary of a successfully linked program
+inline void storeCachedProgram(uint64_t key, GLuint program)
+{
+    if (!programCacheAvailable() || program == 0)
+        return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(programCacheDir, error);
+    ProgramBinaryHeader header = { { 'C', 'G', 'P', 'B' }, programBinaryFileVersion, key, format, (uint32_t)written };
+    // Written under a temporary name and renamed, so a crash never leaves a truncated entry
+    std::string path = programCachePath(key);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        file.write((const char*)&header, sizeof(header));
+        file.write(binary.data(), written);
+        if (!file)
+            return;
+    }
+    std::filesystem::rename(tempPath, path, error);
+}
+
+} // namespace cgcc
+
+#endif // CGCC_PROGRAMCACHE_H
@@ -0,0 +1,110 @@
+/* Shader.h - small helpers to compile and link GLSL programs
+ *
+ * Same checks and log format as the setupShader() functions in the examples,
+ * shared by the helper modules that build their own internal programs.
+ * buildProgram() and buildComputeProgram() go through the program binary
+ * cache (ProgramCache.h).
+ */
+
+#ifndef CGCC_SHADER_H
+#define CGCC_SHADER_H
+
+#include <iostream>
+#include <initializer_list>
+
+#include "GLExt.h"
+#include "ProgramCache.h"
+
+namespace cgcc {
+
+inline const char* shaderStageName(GLenum type)
+{
+    switch (type)
+    {
+    case GL_VERTEX_SHADER: return "VERTEX";
+    case GL_FRAGMENT_SHADER: return "FRAGMENT";
+    case GL_GEOMETRY_SHADER: return "GEOMETRY";
+    case GL_COMPUTE_SHADER: return "COMPUTE";
+    default: return "UNKNOWN";
+    }
+}
+
+// Compiles one stage; returns the shader identifier (0 on failure)
+inline GLuint compileShader(GLenum type, const GLchar* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    // Check for compilation errors (display via log in the terminal)
+    GLint success;
+    GLchar infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::" << shaderStageName(type) << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Links the given stages into a program and deletes them; returns 0 on failure
+inline GLuint linkProgram(std::initializer_list<GLuint> shaders)
+{
+    GLuint program = glCreateProgram();
+    markProgramRetrievable(program);
+    bool complete = true;
+    for (GLuint shader : shaders)
+    {
+        if (shader == 0) complete = false;
+        else glAttachShader(program, shader);
+    }
+    GLint success = GL_FALSE;
+    if (complete)
+    {
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+    }
+    for (GLuint shader : shaders)
+    {
+        if (shader != 0) glDeleteShader(shader);
+    }
+    if (!success)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+inline GLuint buildProgram(const GLchar* vertexSource, const GLchar* fragmentSource)
+{
+    uint64_t cacheKey = programCacheKey({ vertexSource, fragmentSource });
+    if (GLuint cached = loadCachedProgram(cacheKey))
+        return cached;
+    GLuint program = linkProgram({ compileShader(GL_VERTEX_SHADER, vertexSource),
+                                   compileShader(GL_FRAGMENT_SHADER, fragmentSource) });
+    storeCachedProgram(cacheKey, program);
+    return program;
+}
+
+inline GLuint buildComputeProgram(const GLchar* computeSource)
+{
+    uint64_t cacheKey = programCacheKey({ computeSource });
+    if (GLuint cached = loadCachedProgram(cacheKey))
+        return cached;
+    GLuint program = linkProgram({ compileShader(GL_COMPUTE_SHADER, computeSource) });
+    storeCachedProgram(cacheKey, program);
+    return program;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_SHADER_H
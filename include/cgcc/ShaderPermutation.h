@@ -0,0 +1,139 @@
+/* ShaderPermutation.h - specialized shader variants from one GLSL template
+ *
+ * An uber-shader that tests its features at run time (is there a texture? is
+ * specular on? how many lights?) pays for every branch on every fragment. Here
+ * the template is written with #ifdef/#if on a few feature defines instead,
+ * and each combination the scene actually uses is compiled as its own program,
+ * so the compiler strips the unused paths and unrolls the light loop.
+ *
+ * A permutation is a bitmask built with constexpr helpers, so the feature set
+ * of each draw is known at compile time:
+ *
+ *     constexpr uint32_t litTextured = cgcc::shaderPermutation(1, cgcc::FeatureTexture | cgcc::FeatureTexCoord);
+ *     GLuint program = cgcc::getPermutation(phongShaders, litTextured);
+ *
+ * Defines seen by the template (see permutationDefines):
+ *   LIGHT_COUNT      number of lights, always defined (0..15)
+ *   USE_TEXTURE      modulate the color by texBuff
+ *   USE_PALETTE      ... read as an index texture + palette (Palette.h) instead
+ *   USE_SPECULAR     add the specular term
+ *   VERTEX_COLOR     the vertex format has a color attribute
+ *   VERTEX_TEXCOORD  the vertex format has a texture coordinate attribute
+ *
+ * Programs are compiled on first use (or up front with preparePermutations)
+ * through buildProgram(), so they also go through the binary cache.
+ */
+
+#ifndef CGCC_SHADERPERMUTATION_H
+#define CGCC_SHADERPERMUTATION_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <cstdint>
+
+#include "Shader.h"
+
+namespace cgcc {
+
+enum ShaderFeature : uint32_t {
+    FeatureTexture     = 1u << 0,
+    FeatureSpecular    = 1u << 1,
+    FeatureVertexColor = 1u << 2,
+    FeatureTexCoord    = 1u << 3,
+    FeaturePalette     = 1u << 4,
+};
+
+// Bits 8..11 hold the light count
+const uint32_t permutationLightShift = 8;
+const uint32_t permutationLightMask = 0xFu << permutationLightShift;
+
+constexpr uint32_t shaderPermutation(int lightCount, uint32_t features)
+{
+    return features | ((uint32_t)lightCount << permutationLightShift);
+}
+
+constexpr int permutationLightCount(uint32_t permutation)
+{
+    return (int)((permutation & permutationLightMask) >> permutationLightShift);
+}
+
+constexpr bool hasFeature(uint32_t permutation, ShaderFeature feature)
+{
+    return (permutation & feature) != 0;
+}
+
+// Texturing needs texture coordinates in the vertex format, and a palette a texture
+constexpr bool permutationValid(uint32_t permutation)
+{
+    return permutationLightCount(permutation) <= 15 &&
+           (!hasFeature(permutation, FeatureTexture) || hasFeature(permutation, FeatureTexCoord)) &&
+           (!hasFeature(permutation, FeaturePalette) || hasFeature(permutation, FeatureTexture));
+}
+
+// The #define block of a permutation, to be placed right after the #version line
+inline std::string permutationDefines(uint32_t permutation)
+{
+    std::string defines = "#define LIGHT_COUNT " + std::to_string(permutationLightCount(permutation)) + "\n";
+    if (hasFeature(permutation, FeatureTexture)) defines += "#define USE_TEXTURE\n";
+    if (hasFeature(permutation, FeatureSpecular)) defines += "#define USE_SPECULAR\n";
+    if (hasFeature(permutation, FeatureVertexColor)) defines += "#define VERTEX_COLOR\n";
+    if (hasFeature(permutation, FeatureTexCoord)) defines += "#define VERTEX_TEXCOORD\n";
+    if (hasFeature(permutation, FeaturePalette)) defines += "#define USE_PALETTE\n";
+    return defines;
+}
+
+// Full source of one stage: version line, defines, template body
+inline std::string permutationSource(const char* version, const GLchar* templateSource, uint32_t permutation)
+{
+    return std::string(version) + "\n" + permutationDefines(permutation) + templateSource;
+}
+
+// The templates of a program and the permutations compiled so far
+struct ShaderPermutations {
+    const char* version;           // e.g. "#version 400"; the templates have no #version line
+    const GLchar* vertexTemplate;
+    const GLchar* fragmentTemplate;
+    std::vector<std::pair<uint32_t, GLuint>> programs;
+};
+
+inline GLuint buildPermutation(const ShaderPermutations& set, uint32_t permutation)
+{
+    std::string vertexSource = permutationSource(set.version, set.vertexTemplate, permutation);
+    std::string fragmentSource = permutationSource(set.version, set.fragmentTemplate, permutation);
+    return buildProgram(vertexSource.c_str(), fragmentSource.c_str());
+}
+
+// Program of a permutation, compiled the first time it is asked for (0 if it fails to build)
+inline GLuint getPermutation(ShaderPermutations& set, uint32_t permutation)
+{
+    for (const auto& entry : set.programs)
+    {
+        if (entry.first == permutation)
+            return entry.second;
+    }
+    GLuint program = buildPermutation(set, permutation);
+    set.programs.push_back({ permutation, program });
+    return program;
+}
+
+// Compiles the permutations a scene is known to use before the first frame
+inline void preparePermutations(ShaderPermutations& set, std::initializer_list<uint32_t> permutations)
+{
+    for (uint32_t permutation : permutations)
+        getPermutation(set, permutation);
+}
+
+inline void destroyPermutations(ShaderPermutations& set)
+{
+    for (const auto& entry : set.programs)
+    {
+        if (entry.second) glDeleteProgram(entry.second);
+    }
+    set.programs.clear();
+}
+
+} // namespace cgcc
+
+#endif // CGCC_SHADERPERMUTATION_H
@@ -0,0 +1,262 @@
+/* StaticGeometry.h - small meshes built by the compiler
+ *
+ * A pyramid or a cube typed out as a GLfloat array is easy to get wrong (one
+ * misplaced corner or color) and has to agree with the attribute pointers by
+ * hand. Here the shapes are constexpr functions, so they are evaluated while
+ * compiling and end up as static constexpr arrays in the executable, like the
+ * hand-written tables, with no generation at startup:
+ *
+ *     constexpr auto cubeSoup = cgcc::cubeGeometry(1.0f, faceColors);
+ *     constexpr auto cube = cgcc::indexGeometry<PositionColor, cgcc::uniqueVertexCount<PositionColor>(cubeSoup)>(cubeSoup);
+ *     // cube.vertices: std::array<GLfloat, 24 * 6>, cube.indices: std::array<GLushort, 36>
+ *
+ * A shape is first a triangle soup of GeometryVertex (every attribute a vertex
+ * could have). indexGeometry() merges the vertices that are identical in the
+ * attributes the layout keeps, in order of first occurrence, and packs them
+ * in the order of a VertexLayout (VertexLayout.h), which also sets up the
+ * attribute pointers, so the array and the pointers cannot disagree. Only
+ * float formats can be packed this way; the packed ones go through
+ * PackedVertices at run time.
+ * packGeometry() packs the soup as is, for glDrawArrays.
+ *
+ * Triangles are counter-clockwise seen from outside.
+ */
+
+#ifndef CGCC_STATICGEOMETRY_H
+#define CGCC_STATICGEOMETRY_H
+
+#include <array>
+#include <cstddef>
+
+#include "VertexLayout.h"
+
+namespace cgcc {
+
+using GeometryColor = std::array<float, 3>;
+
+struct GeometryVertex {
+    float position[3] = {};
+    float color[3] = {};
+    float normal[3] = {};
+    float uv[2] = {};
+};
+
+template <size_t N>
+using GeometrySoup = std::array<GeometryVertex, N>;
+
+// Layouts a GeometryVertex can be packed into at compile time: float formats
+// only (no bit_cast before C++20), reading at most the floats it stores
+template <typename Layout>
+constexpr bool staticGeometryLayout()
+{
+    for (int i = 0; i < Layout::attributeCount; ++i)
+    {
+        int stored = Layout::attributes[i] == VertexAttribute::TexCoord ? 2 : 3;
+        if (vertexFormatInfo(Layout::formats[i]).inputs > stored)
+            return false;
+    }
+    return Layout::allFloat;
+}
+
+template <typename Layout, size_t VertexCount, size_t IndexCount>
+struct StaticMesh {
+    static_assert(staticGeometryLayout<Layout>(), "static geometry needs float attributes that GeometryVertex holds");
+
+    std::array<GLfloat, VertexCount * Layout::floats> vertices{};
+    std::array<GLushort, IndexCount> indices{};
+};
+
+// No std::sqrt in constant expressions before C++26: Newton's method
+constexpr float constexprSqrt(float x)
+{
+    if (x <= 0.0f)
+        return 0.0f;
+    float r = x > 1.0f ? x : 1.0f;
+    for (int i = 0; i < 32; ++i)
+        r = 0.5f * (r + x / r);
+    return r;
+}
+
+constexpr GeometryVertex geometryVertex(float x, float y, float z, GeometryColor color, float nx, float ny, float nz, float u, float v)
+{
+    GeometryVertex vertex;
+    vertex.position[0] = x; vertex.position[1] = y; vertex.position[2] = z;
+    vertex.color[0] = color[0]; vertex.color[1] = color[1]; vertex.color[2] = color[2];
+    vertex.normal[0] = nx; vertex.normal[1] = ny; vertex.normal[2] = nz;
+    vertex.uv[0] = u; vertex.uv[1] = v;
+    return vertex;
+}
+
+// Cube centered at the origin, one flat color per face, faces in the order
+// +x, -x, +y, -y, +z, -z
+constexpr GeometrySoup<36> cubeGeometry(float size, const std::array<GeometryColor, 6>& faceColors)
+{
+    // Per face: normal, then the u and v edges (u x v = normal)
+    constexpr int axes[6][3][3] = {
+        { { 1, 0, 0 },  { 0, 1, 0 }, { 0, 0, 1 } },
+        { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+        { { 0, 1, 0 },  { 0, 0, 1 }, { 1, 0, 0 } },
+        { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+        { { 0, 0, 1 },  { 1, 0, 0 }, { 0, 1, 0 } },
+        { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } },
+    };
+    constexpr int corners[6] = { 0, 1, 2, 0, 2, 3 }; // two triangles of the quad
+    constexpr float cornerU[4] = { 0, 1, 1, 0 };
+    constexpr float cornerV[4] = { 0, 0, 1, 1 };
+    float h = size * 0.5f;
+    GeometrySoup<36> soup{};
+    for (int f = 0; f < 6; ++f)
+    {
+        const auto& n = axes[f][0];
+        const auto& u = axes[f][1];
+        const auto& v = axes[f][2];
+        for (int k = 0; k < 6; ++k)
+        {
+            int c = corners[k];
+            float su = cornerU[c] * 2.0f - 1.0f, sv = cornerV[c] * 2.0f - 1.0f;
+            soup[f * 6 + k] = geometryVertex(h * (n[0] + su * u[0] + sv * v[0]),
+                                             h * (n[1] + su * u[1] + sv * v[1]),
+                                             h * (n[2] + su * u[2] + sv * v[2]),
+                                             faceColors[f], (float)n[0], (float)n[1], (float)n[2], cornerU[c], cornerV[c]);
+        }
+    }
+    return soup;
+}
+
+// Square base on y = -height/2 and apex at (0, height/2, 0). Both base
+// triangles use baseColors for their first, second and third corners; the
+// sides take one color each, counter-clockwise seen from above starting at +z
+constexpr GeometrySoup<18> pyramidGeometry(float base, float height, const std::array<GeometryColor, 3>& baseColors,
+                                           const std::array<GeometryColor, 4>& sideColors)
+{
+    float b = base * 0.5f, y = height * 0.5f;
+    // Base corners counter-clockwise seen from above: (-,+z) (+,+z) (+,-z) (-,-z)
+    const float cx[4] = { -b, b, b, -b };
+    const float cz[4] = { b, b, -b, -b };
+    GeometrySoup<18> soup{};
+    // Base, facing down
+    const int baseCorners[6] = { 3, 2, 0, 0, 2, 1 };
+    for (int k = 0; k < 6; ++k)
+    {
+        int c = baseCorners[k];
+        soup[k] = geometryVertex(cx[c], -y, cz[c], baseColors[k % 3], 0, -1, 0, (cx[c] + b) / base, (cz[c] + b) / base);
+    }
+    // Sides: corner i, corner i + 1, apex
+    for (int s = 0; s < 4; ++s)
+    {
+        int a = s, c = (s + 1) % 4;
+        // Outward normal: edge (a -> c) x (a -> apex)
+        float ex = cx[c] - cx[a], ez = cz[c] - cz[a];
+        float px = -cx[a], py = 2.0f * y, pz = -cz[a];
+        float nx = -ez * py, ny = ez * px - ex * pz, nz = ex * py;
+        float length = constexprSqrt(nx * nx + ny * ny + nz * nz);
+        nx /= length; ny /= length; nz /= length;
+        soup[6 + s * 3 + 0] = geometryVertex(cx[a], -y, cz[a], sideColors[s], nx, ny, nz, 0, 0);
+        soup[6 + s * 3 + 1] = geometryVertex(cx[c], -y, cz[c], sideColors[s], nx, ny, nz, 1, 0);
+        soup[6 + s * 3 + 2] = geometryVertex(0, y, 0, sideColors[s], nx, ny, nz, 0.5f, 1);
+    }
+    return soup;
+}
+
+// Attribute a of a vertex as floats
+constexpr const float* geometryAttribute(const GeometryVertex& vertex, VertexAttribute attribute)
+{
+    switch (attribute)
+    {
+    case VertexAttribute::Color: return vertex.color;
+    case VertexAttribute::Normal: return vertex.normal;
+    case VertexAttribute::TexCoord: return vertex.uv;
+    default: return vertex.position;
+    }
+}
+
+// Equal in every attribute that Layout keeps
+template <typename Layout>
+constexpr bool sameGeometryVertex(const GeometryVertex& a, const GeometryVertex& b)
+{
+    for (int i = 0; i < Layout::attributeCount; ++i)
+    {
+        const float* x = geometryAttribute(a, Layout::attributes[i]);
+        const float* y = geometryAttribute(b, Layout::attributes[i]);
+        for (int c = 0; c < vertexFormatInfo(Layout::formats[i]).inputs; ++c)
+        {
+            if (x[c] != y[c])
+                return false;
+        }
+    }
+    return true;
+}
+
+// Vertices left after merging the ones Layout cannot tell apart (the
+// VertexCount of indexGeometry)
+template <typename Layout, size_t N>
+constexpr size_t uniqueVertexCount(const GeometrySoup<N>& soup)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        bool seen = false;
+        for (size_t j = 0; j < i && !seen; ++j)
+            seen = sameGeometryVertex<Layout>(soup[i], soup[j]);
+        if (!seen)
+            ++count;
+    }
+    return count;
+}
+
+// Writes the attributes of Layout, in its order, at out[first..]
+template <typename Layout, size_t Size>
+constexpr void writeGeometryVertex(const GeometryVertex& vertex, std::array<GLfloat, Size>& out, size_t first)
+{
+    for (int a = 0; a < Layout::attributeCount; ++a)
+    {
+        const float* source = geometryAttribute(vertex, Layout::attributes[a]);
+        for (int c = 0; c < vertexFormatInfo(Layout::formats[a]).inputs; ++c)
+            out[first + Layout::offset(a) / sizeof(GLfloat) + c] = source[c];
+    }
+}
+
+// The soup packed as is, N vertices for glDrawArrays
+template <typename Layout, size_t N>
+constexpr std::array<GLfloat, N * Layout::floats> packGeometry(const GeometrySoup<N>& soup)
+{
+    static_assert(staticGeometryLayout<Layout>(), "static geometry needs float attributes that GeometryVertex holds");
+    std::array<GLfloat, N * Layout::floats> vertices{};
+    for (size_t i = 0; i < N; ++i)
+        writeGeometryVertex<Layout>(soup[i], vertices, i * Layout::floats);
+    return vertices;
+}
+
+// Shared vertices and one index per soup vertex
+template <typename Layout, size_t VertexCount, size_t N>
+constexpr StaticMesh<Layout, VertexCount, N> indexGeometry(const GeometrySoup<N>& soup)
+{
+    static_assert(VertexCount <= 65536, "indices are 16-bit");
+    StaticMesh<Layout, VertexCount, N> mesh;
+    GeometrySoup<VertexCount> unique{};
+    size_t count = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        size_t index = count;
+        for (size_t j = 0; j < count; ++j)
+        {
+            if (sameGeometryVertex<Layout>(soup[i], unique[j]))
+            {
+                index = j;
+                break;
+            }
+        }
+        if (index == count)
+        {
+            unique[count] = soup[i];
+            writeGeometryVertex<Layout>(soup[i], mesh.vertices, count * Layout::floats);
+            ++count;
+        }
+        mesh.indices[i] = (GLushort)index;
+    }
+    return mesh;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_STATICGEOMETRY_H
@@ -0,0 +1,164 @@
+/* TextureArray.h - several textures as the layers of one GL_TEXTURE_2D_ARRAY
+ *
+ * When every textured draw binds its own GL_TEXTURE_2D, objects that differ
+ * only by texture cannot share a draw call. Packed as layers of one array
+ * texture they can: the array stays bound, and each instance carries the
+ * index of its layer as a per-instance vertex attribute, read in the shader as
+ *
+ *     uniform sampler2DArray texArray;
+ *     color = texture(texArray, vec3(texCoord, layer));
+ *
+ * All layers share one size and format (RGBA8 with a full mip chain), so each
+ * image is resampled on the CPU to the layer size: starting from the smallest
+ * level of its mip chain that is still at least that large (MipChain.h, disk
+ * cache included), then bilinearly, in linear light for color data. Unlike an
+ * atlas, no padding or UV remapping is needed and wrapping and mipmapping work
+ * per layer. The images are decoded on one thread each.
+ */
+
+#ifndef CGCC_TEXTUREARRAY_H
+#define CGCC_TEXTUREARRAY_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+#include "GLExt.h"
+#include "MipChain.h"
+#include "Trace.h"
+
+namespace cgcc {
+
+struct TextureArray {
+    GLuint texture = 0;
+    int width = 0, height = 0;
+    std::vector<std::string> paths; // layer i holds paths[i]
+};
+
+// Layer of an image in the array, -1 if it is not there
+inline int textureArrayLayer(const TextureArray& array, const std::string& path)
+{
+    auto it = std::find(array.paths.begin(), array.paths.end(), path);
+    return it == array.paths.end() ? -1 : (int)(it - array.paths.begin());
+}
+
+// Bilinear resample of an RGBA8 image (texel centers aligned, edges clamped)
+inline std::vector<uint8_t> resizeImage(const std::vector<uint8_t>& rgba, int width, int height, int outWidth, int outHeight, bool srgb)
+{
+    const float* decode = srgbDecodeTable();
+    const uint8_t* encode = srgbEncodeTable();
+    auto value = [&](int x, int y, int c) {
+        uint8_t v = rgba[((size_t)y * width + x) * 4 + c];
+        return (srgb && c < 3) ? decode[v] : v * (1.0f / 255.0f);
+    };
+    std::vector<uint8_t> out((size_t)outWidth * outHeight * 4);
+    for (int y = 0; y < outHeight; ++y)
+    {
+        float sy = std::clamp((y + 0.5f) * height / outHeight - 0.5f, 0.0f, (float)(height - 1));
+        int y0 = (int)sy, y1 = std::min(y0 + 1, height - 1);
+        float fy = sy - y0;
+        for (int x = 0; x < outWidth; ++x)
+        {
+            float sx = std::clamp((x + 0.5f) * width / outWidth - 0.5f, 0.0f, (float)(width - 1));
+            int x0 = (int)sx, x1 = std::min(x0 + 1, width - 1);
+            float fx = sx - x0;
+            for (int c = 0; c < 4; ++c)
+            {
+                float top = value(x0, y0, c) + (value(x1, y0, c) - value(x0, y0, c)) * fx;
+                float bottom = value(x0, y1, c) + (value(x1, y1, c) - value(x0, y1, c)) * fx;
+                float v = std::clamp(top + (bottom - top) * fy, 0.0f, 1.0f);
+                out[((size_t)y * outWidth + x) * 4 + c] = (srgb && c < 3) ? encode[(int)(v * (srgbEncodeSteps - 1) + 0.5f)] : (uint8_t)(v * 255.0f + 0.5f);
+            }
+        }
+    }
+    return out;
+}
+
+// Mip chain of one layer: the image scaled to width x height. A missing image
+// becomes a grey layer so the other layers keep their indices.
+inline void loadArrayLayer(const std::string& path, int width, int height, const MipOptions& options, std::vector<std::vector<uint8_t>>& levels)
+{
+    CGCC_TRACE_THREAD("texture array loader");
+    CGCC_TRACE_ZONE("load texture layer");
+    std::vector<std::vector<uint8_t>> source;
+    int sourceWidth, sourceHeight;
+    if (!loadMipChain(path, options, source, sourceWidth, sourceHeight))
+    {
+        std::cout << "Failed to load texture " << path << std::endl;
+        levels.assign(1, std::vector<uint8_t>((size_t)width * height * 4, 128));
+        for (size_t i = 3; i < levels[0].size(); i += 4)
+            levels[0][i] = 255;
+    }
+    else
+    {
+        // Mip levels already did the heavy downscaling; bilinear covers less than 2x
+        size_t level = 0;
+        while (level + 1 < source.size() && (sourceWidth >> (level + 1)) >= width && (sourceHeight >> (level + 1)) >= height)
+            ++level;
+        int w = std::max(1, sourceWidth >> level), h = std::max(1, sourceHeight >> level);
+        if (w == width && h == height)
+            levels.assign(1, std::move(source[level]));
+        else
+            levels.assign(1, resizeImage(source[level], w, h, width, height, options.srgb));
+    }
+    generateMipLevels(levels, width, height, options);
+}
+
+// Loads the images into the layers of a new width x height array texture
+inline bool buildTextureArray(TextureArray& array, const std::vector<std::string>& paths, int width, int height, const MipOptions& options = {})
+{
+    CGCC_TRACE_ZONE("buildTextureArray");
+    if (paths.empty() || width <= 0 || height <= 0)
+        return false;
+    // Decoding, resampling and mip generation in parallel, one image per thread
+    std::vector<std::vector<std::vector<uint8_t>>> layers(paths.size());
+    MipOptions layerOptions = options;
+    layerOptions.threads = 1;
+    std::vector<std::thread> loaders;
+    for (size_t i = 0; i < paths.size(); ++i)
+        loaders.emplace_back(loadArrayLayer, std::cref(paths[i]), width, height, std::cref(layerOptions), std::ref(layers[i]));
+    for (std::thread& loader : loaders)
+        loader.join();
+
+    GLsizei levelCount = (GLsizei)layers[0].size();
+    GLsizei layerCount = (GLsizei)paths.size();
+    glGenTextures(1, &array.texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    if (glCaps.textureStorage)
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levelCount, GL_RGBA8, width, height, layerCount);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLsizei level = 0; level < levelCount; ++level)
+    {
+        int w = std::max(1, width >> level), h = std::max(1, height >> level);
+        if (!glCaps.textureStorage)
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, w, h, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        for (GLsizei layer = 0; layer < layerCount; ++layer)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE, layers[layer][level].data());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    array.width = width;
+    array.height = height;
+    array.paths = paths;
+    return true;
+}
+
+inline void destroyTextureArray(TextureArray& array)
+{
+    if (array.texture) glDeleteTextures(1, &array.texture);
+    array = TextureArray();
+}
+
+} // namespace cgcc
+
+#endif // CGCC_TEXTUREARRAY_H
@@ -0,0 +1,464 @@
+/* TextureStreamer.h - textures loaded in the background and uploaded a bit per frame
+ *
+ * requestTexture() only queues the file: worker threads read and decode it
+ * (the block-compressed <image>.ktx2 when there is one the driver can sample,
+ * otherwise the image through stb_image, with its mip chain filtered on the CPU
+ * by MipChain.h and kept in its disk cache, so no glGenerateMipmap is needed).
+ * Each frame updateTextureStreamer() copies the decoded rows into a small ring
+ * of pixel unpack buffers and issues
+ * glTexSubImage2D / glCompressedTexSubImage2D from them, stopping when the
+ * frame's time budget is spent or the next buffer is still being read by the
+ * GPU (checked with a fence, never waited on). The levels are allocated with
+ * glTexStorage2D where available, else one glTexImage2D per level as it is reached.
+ *
+ * Until a texture has all its levels uploaded streamedTexture() returns a 1x1
+ * grey placeholder, so the application can bind whatever it returns every frame.
+ *
+ * Pixel art can be requested with allowPalette: if the image has at most 256
+ * colors it is stored as an 8-bit index texture (GL_R8UI, nearest, no mips)
+ * plus a palette texture (Palette.h), and streamedPalette() returns the palette
+ * once it is resident, telling the application to use its palette shader.
+ * Which way each such request went is printed (palette, too many colors, or a
+ * .ktx2 that was used instead).
+ *
+ * With the environment variable CGCC_IGNORE_KTX2 set, .ktx2 files are not
+ * looked for, so the result does not depend on whether the compress_textures
+ * target was ever built (cgcc_golden sets it).
+ *
+ * Textures get GL_REPEAT wrapping and GL_LINEAR filtering, like loadTexture()
+ * in the examples. The worker threads only touch memory; every GL call is made
+ * from the thread that calls updateTextureStreamer().
+ */
+
+#ifndef CGCC_TEXTURESTREAMER_H
+#define CGCC_TEXTURESTREAMER_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+
+#include "GLExt.h"
+#include "BlockCompression.h"
+#include "KTX2.h"
+#include "MipChain.h"
+#include "Palette.h"
+#include "Trace.h"
+
+namespace cgcc {
+
+// A decoded image waiting for upload
+struct StreamedImage {
+    int handle = -1;
+    bool ok = false;
+    bool compressed = false;
+    GLenum internalFormat = GL_RGBA8;
+    GLenum pixelFormat = GL_RGBA; // uncompressed formats only
+    int texelBytes = 4;
+    int blockBytes = 0;           // compressed formats only
+    int width = 0, height = 0;
+    std::vector<std::vector<uint8_t>> levels;
+    std::vector<uint8_t> palette; // RGBA8 entries when levels hold palette indices
+};
+
+struct StreamJob {
+    int handle;
+    std::string path;
+    MipOptions mips;
+    bool allowPalette;
+};
+
+struct StreamedTextureSlot {
+    std::string path;
+    GLuint texture = 0;
+    GLuint palette = 0;
+    bool resident = false;
+};
+
+const int textureStreamerRingSize = 3;
+
+struct TextureStreamer {
+    // Shared with the workers (guarded by mutex)
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<StreamJob> jobs;
+    std::deque<StreamedImage> decoded;
+    bool stopping = false;
+    bool useCompressed = true; // set before the workers start, read-only after
+
+    // Main thread only
+    std::vector<StreamedTextureSlot> textures;
+    GLuint placeholder = 0;
+    StreamedImage current; // being uploaded
+    bool uploading = false;
+    GLuint currentTexture = 0, currentPalette = 0;
+    int level = 0, row = 0; // next row (block row when compressed) of the current level
+
+    GLuint pbo[textureStreamerRingSize] = {};
+    size_t pboCapacity[textureStreamerRingSize] = {};
+    GLsync fences[textureStreamerRingSize] = {};
+    int nextPBO = 0;
+    size_t pboSize = 4 << 20; // bytes per ring buffer
+};
+
+// Cache marker saying an image has too many colors for a palette. A mip
+// chain in the cache says nothing about that: loadMipChain() stores one for
+// any image, so the decision is kept in a file of its own
+inline std::string paletteRejectedPath(uint64_t key)
+{
+    return mipCachePath(key) + ".truecolor";
+}
+
+// One line per palette request, saying which path the texture took
+inline void logPaletteDecision(const std::string& path, const std::string& decision)
+{
+    std::cout << ("Texture " + path + ": " + decision + "\n") << std::flush;
+}
+
+// Runs on a worker: file I/O and decoding only, no GL calls
+inline void decodeStreamedImage(const std::string& path, const MipOptions& mips, bool allowPalette, bool useCompressed, StreamedImage& image)
+{
+    CGCC_TRACE_ZONE("decode texture");
+    std::string compressedPath = compressedTexturePath(path);
+    KTX2Texture ktx;
+    if (useCompressed && std::ifstream(compressedPath, std::ios::binary).good() && readKTX2(compressedPath, ktx))
+    {
+        BlockFormat format;
+        bool srgb;
+        GLenum internalFormat = compressedGLFormat(ktx.vkFormat);
+        if (internalFormat != 0 && ktx2BlockFormat(ktx.vkFormat, format, srgb))
+        {
+            if (allowPalette)
+                logPaletteDecision(path, "block-compressed " + compressedPath + " found, palette not tried");
+            image.compressed = true;
+            image.internalFormat = internalFormat;
+            image.blockBytes = cgcc::blockBytes(format);
+            image.width = ktx.width;
+            image.height = ktx.height;
+            image.levels = std::move(ktx.levels);
+            image.ok = true;
+            return;
+        }
+    }
+
+    if (allowPalette)
+    {
+        // Only an image already found to have too many colors skips the count
+        uint64_t key = mipCacheKey(path, mips);
+        std::string rejectedPath = paletteRejectedPath(key);
+        if (mipCacheEnabled && std::ifstream(rejectedPath).good() && loadCachedMips(key, image.levels, image.width, image.height))
+        {
+            logPaletteDecision(path, "more than " + std::to_string(maxPaletteColors) + " colors (cached), RGBA8 with mips");
+            image.ok = true;
+            return;
+        }
+        int width, height, channels;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (!data)
+            return;
+        image.width = width;
+        image.height = height;
+        image.levels.resize(1);
+        bool paletted = palettizeImage(data, width, height, image.levels[0], image.palette);
+        if (paletted)
+        {
+            image.internalFormat = GL_R8UI;
+            image.pixelFormat = GL_RED_INTEGER;
+            image.texelBytes = 1;
+            logPaletteDecision(path, "8-bit indices, " + std::to_string(image.palette.size() / 4) + " color palette");
+        }
+        else
+        {
+            // Too many colors: an ordinary texture after all
+            image.palette.clear();
+            image.levels[0].assign(data, data + (size_t)width * height * 4);
+            generateMipLevels(image.levels, width, height, mips);
+            storeCachedMips(key, image.levels, width, height);
+            if (mipCacheEnabled)
+                std::ofstream(rejectedPath, std::ios::trunc) << path << "\n";
+            logPaletteDecision(path, "more than " + std::to_string(maxPaletteColors) + " colors, RGBA8 with mips");
+        }
+        stbi_image_free(data);
+        image.ok = true;
+        return;
+    }
+
+    // Mip chain on the worker instead of glGenerateMipmap on the main thread
+    image.ok = loadMipChain(path, mips, image.levels, image.width, image.height);
+}
+
+inline void textureStreamerWorker(TextureStreamer& streamer)
+{
+    CGCC_TRACE_THREAD("texture decode");
+    while (true)
+    {
+        StreamJob job;
+        {
+            std::unique_lock<std::mutex> lock(streamer.mutex);
+            streamer.wake.wait(lock, [&] { return streamer.stopping || !streamer.jobs.empty(); });
+            if (streamer.stopping)
+                return;
+            job = std::move(streamer.jobs.front());
+            streamer.jobs.pop_front();
+        }
+        StreamedImage image;
+        image.handle = job.handle;
+        decodeStreamedImage(job.path, job.mips, job.allowPalette, streamer.useCompressed, image);
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        streamer.decoded.push_back(std::move(image));
+    }
+}
+
+// Creates the placeholder, the buffer ring and the workers (0 threads = one per core, up to 4)
+inline void initTextureStreamer(TextureStreamer& streamer, int threads = 0)
+{
+    const GLubyte grey[4] = { 128, 128, 128, 255 };
+    glGenTextures(1, &streamer.placeholder);
+    glBindTexture(GL_TEXTURE_2D, streamer.placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenBuffers(textureStreamerRingSize, streamer.pbo);
+
+    streamer.useCompressed = std::getenv("CGCC_IGNORE_KTX2") == nullptr;
+    if (threads <= 0)
+        threads = std::clamp((int)std::thread::hardware_concurrency(), 1, 4);
+    for (int i = 0; i < threads; ++i)
+        streamer.workers.emplace_back(textureStreamerWorker, std::ref(streamer));
+}
+
+// Queues an image file; returns the handle to pass to streamedTexture(). The
+// mip options only apply to images without a usable .ktx2 (filtered at cook
+// time); allowPalette tries the indexed form first (see above)
+inline int requestTexture(TextureStreamer& streamer, const std::string& path, const MipOptions& mips = {}, bool allowPalette = false)
+{
+    int handle = (int)streamer.textures.size();
+    streamer.textures.push_back({ path, 0, 0, false });
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        streamer.jobs.push_back({ handle, path, mips, allowPalette });
+    }
+    streamer.wake.notify_one();
+    return handle;
+}
+
+// The texture once it is fully uploaded, the placeholder until then
+inline GLuint streamedTexture(const TextureStreamer& streamer, int handle)
+{
+    const StreamedTextureSlot& slot = streamer.textures[handle];
+    return slot.resident ? slot.texture : streamer.placeholder;
+}
+
+// Palette of a resident indexed texture; 0 while it is not resident or when it
+// is an ordinary texture
+inline GLuint streamedPalette(const TextureStreamer& streamer, int handle)
+{
+    const StreamedTextureSlot& slot = streamer.textures[handle];
+    return slot.resident ? slot.palette : 0;
+}
+
+inline bool textureStreamerIdle(TextureStreamer& streamer)
+{
+    std::lock_guard<std::mutex> lock(streamer.mutex);
+    return !streamer.uploading && streamer.jobs.empty() && streamer.decoded.empty() &&
+           std::all_of(streamer.textures.begin(), streamer.textures.end(), [](const StreamedTextureSlot& t) { return t.resident || t.path.empty(); });
+}
+
+// Bytes per row of a level and number of rows (block rows for compressed formats)
+inline void streamedLevelRows(const StreamedImage& image, int level, size_t& rowBytes, int& rows)
+{
+    int w = std::max(1, image.width >> level), h = std::max(1, image.height >> level);
+    rowBytes = image.compressed ? (size_t)((w + 3) / 4) * image.blockBytes : (size_t)w * image.texelBytes;
+    rows = image.compressed ? (h + 3) / 4 : h;
+}
+
+// Creates the texture the current image goes into (and its palette, small
+// enough to be uploaded right away)
+inline void beginStreamedUpload(TextureStreamer& streamer)
+{
+    StreamedImage& image = streamer.current;
+    // Integer textures cannot be filtered
+    GLint filter = image.palette.empty() ? GL_LINEAR : GL_NEAREST;
+    glGenTextures(1, &streamer.currentTexture);
+    glBindTexture(GL_TEXTURE_2D, streamer.currentTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+    if (glCaps.textureStorage)
+        glTexStorage2D(GL_TEXTURE_2D, (GLsizei)image.levels.size(), image.internalFormat, image.width, image.height);
+
+    if (!image.palette.empty())
+    {
+        glGenTextures(1, &streamer.currentPalette);
+        glBindTexture(GL_TEXTURE_2D, streamer.currentPalette);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, (GLsizei)image.palette.size() / 4, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.palette.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    streamer.level = 0;
+    streamer.row = 0;
+    streamer.uploading = true;
+}
+
+// Copies as many rows of the current level as fit in the next ring buffer and
+// uploads them; false when that buffer is still in use by the GPU
+inline bool uploadStreamedChunk(TextureStreamer& streamer)
+{
+    int slot = streamer.nextPBO;
+    if (streamer.fences[slot])
+    {
+        if (glClientWaitSync(streamer.fences[slot], 0, 0) == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(streamer.fences[slot]);
+        streamer.fences[slot] = 0;
+    }
+
+    StreamedImage& image = streamer.current;
+    size_t rowBytes;
+    int rows;
+    streamedLevelRows(image, streamer.level, rowBytes, rows);
+    size_t capacity = std::max(streamer.pboSize, rowBytes);
+    int count = std::min(rows - streamer.row, (int)(capacity / rowBytes));
+    size_t bytes = rowBytes * count;
+    int w = std::max(1, image.width >> streamer.level), h = std::max(1, image.height >> streamer.level);
+
+    glBindTexture(GL_TEXTURE_2D, streamer.currentTexture);
+    if (streamer.row == 0 && !glCaps.textureStorage)
+    {
+        // Without immutable storage each level is allocated when it is reached,
+        // before the unpack buffer is bound (with it bound NULL would be an offset)
+        if (image.compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, streamer.level, image.internalFormat, w, h, 0, (GLsizei)image.levels[streamer.level].size(), NULL);
+        else
+            glTexImage2D(GL_TEXTURE_2D, streamer.level, image.internalFormat, w, h, 0, image.pixelFormat, GL_UNSIGNED_BYTE, NULL);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, streamer.pbo[slot]);
+    if (streamer.pboCapacity[slot] < capacity)
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+        streamer.pboCapacity[slot] = capacity;
+    }
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!mapped)
+    {
+        // Retried next frame (the level is allocated again, which is harmless)
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return false;
+    }
+    std::memcpy(mapped, image.levels[streamer.level].data() + rowBytes * streamer.row, bytes);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    if (image.compressed)
+    {
+        int y = streamer.row * 4;
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, streamer.level, 0, y, w, std::min(count * 4, h - y), image.internalFormat, (GLsizei)bytes, (const void*)0);
+    }
+    else
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, streamer.level, 0, streamer.row, w, count, image.pixelFormat, GL_UNSIGNED_BYTE, (const void*)0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    streamer.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    streamer.nextPBO = (slot + 1) % textureStreamerRingSize;
+
+    streamer.row += count;
+    if (streamer.row >= rows)
+    {
+        streamer.row = 0;
+        if (++streamer.level >= (int)image.levels.size())
+        {
+            // All levels are in: swap the placeholder for the real texture
+            StreamedTextureSlot& texture = streamer.textures[image.handle];
+            texture.texture = streamer.currentTexture;
+            texture.palette = streamer.currentPalette;
+            texture.resident = true;
+            streamer.currentTexture = streamer.currentPalette = 0;
+            streamer.current = StreamedImage();
+            streamer.uploading = false;
+        }
+    }
+    return true;
+}
+
+// Call once per frame: uploads decoded images for at most budgetMs milliseconds
+inline void updateTextureStreamer(TextureStreamer& streamer, double budgetMs = 2.0)
+{
+    CGCC_TRACE_ZONE("upload textures");
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&] { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+    while (elapsedMs() < budgetMs)
+    {
+        if (!streamer.uploading)
+        {
+            {
+                std::lock_guard<std::mutex> lock(streamer.mutex);
+                if (streamer.decoded.empty())
+                    return;
+                streamer.current = std::move(streamer.decoded.front());
+                streamer.decoded.pop_front();
+            }
+            if (!streamer.current.ok)
+            {
+                std::cout << "Failed to load texture " << streamer.textures[streamer.current.handle].path << std::endl;
+                streamer.textures[streamer.current.handle].path.clear(); // stays on the placeholder
+                continue;
+            }
+            beginStreamedUpload(streamer);
+        }
+        if (!uploadStreamedChunk(streamer))
+            return;
+    }
+}
+
+inline void destroyTextureStreamer(TextureStreamer& streamer)
+{
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        streamer.stopping = true;
+    }
+    streamer.wake.notify_all();
+    for (std::thread& worker : streamer.workers)
+        worker.join();
+    streamer.workers.clear();
+
+    for (int i = 0; i < textureStreamerRingSize; ++i)
+    {
+        if (streamer.fences[i]) glDeleteSync(streamer.fences[i]);
+        streamer.fences[i] = 0;
+    }
+    glDeleteBuffers(textureStreamerRingSize, streamer.pbo);
+    for (StreamedTextureSlot& texture : streamer.textures)
+    {
+        if (texture.texture) glDeleteTextures(1, &texture.texture);
+        if (texture.palette) glDeleteTextures(1, &texture.palette);
+    }
+    streamer.textures.clear();
+    if (streamer.currentTexture) glDeleteTextures(1, &streamer.currentTexture);
+    if (streamer.currentPalette) glDeleteTextures(1, &streamer.currentPalette);
+    if (streamer.placeholder) glDeleteTextures(1, &streamer.placeholder);
+    streamer.currentTexture = streamer.currentPalette = streamer.placeholder = 0;
+}
+
+} // namespace cgcc
+
+#endif // CGCC_TEXTURESTREAMER_H
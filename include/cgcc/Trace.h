@@ -0,0 +1,191 @@
+/* Trace.h - zones on a timeline, per thread, for chrome://tracing or Perfetto
+ *
+ * FrameTimer.h gives numbers per frame; a trace shows what every thread was
+ * doing over time (the loader, the texture decode workers, the render loop):
+ *
+ *     void loadModel()
+ *     {
+ *         CGCC_TRACE_ZONE("loadModel");      // from here to the end of the scope
+ *         ...
+ *     }
+ *     CGCC_TRACE_THREAD("texture decode");   // names the calling thread
+ *     CGCC_TRACE_WRITE("trace.json");        // before exiting
+ *
+ * Open the file in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * The macros compile to nothing unless CGCC_TRACING is defined (CMake option
+ * CGCC_TRACING). When enabled, a zone reads the clock twice and writes one
+ * event into a ring buffer owned by its thread. There are no locks and no
+ * allocation, only a relaxed load and a release store of the ring's head. A
+ * thread registers its ring under a mutex the first time it records. When a
+ * ring is full the oldest events are overwritten. Rings outlive their
+ * threads, so the workers of a streamer that was already destroyed are still
+ * written out. Zone names must be string literals (only the pointer is kept).
+ *
+ * writeTrace() reads the rings without stopping the threads, so call it when
+ * they are quiet (on exit); an event being recorded during the copy may be
+ * torn.
+ */
+
+#ifndef CGCC_TRACE_H
+#define CGCC_TRACE_H
+
+#ifdef CGCC_TRACING
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace cgcc {
+
+const size_t traceRingSize = 1 << 16; // events per thread
+
+struct TraceEvent {
+    const char* name;
+    uint64_t begin; // ns since the trace epoch
+    uint64_t end;
+};
+
+struct TraceRing {
+    std::vector<TraceEvent> events = std::vector<TraceEvent>(traceRingSize);
+    std::atomic<uint64_t> head{ 0 }; // events ever written
+    int thread = 0;
+    std::string name;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceRing>> rings;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+inline TraceRegistry& traceRegistry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+inline uint64_t traceNow()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceRegistry().epoch).count();
+}
+
+// The calling thread's ring, registered on first use
+inline TraceRing& traceRing()
+{
+    thread_local std::shared_ptr<TraceRing> ring;
+    if (!ring)
+    {
+        ring = std::make_shared<TraceRing>();
+        TraceRegistry& registry = traceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        ring->thread = (int)registry.rings.size() + 1;
+        ring->name = "thread " + std::to_string(ring->thread);
+        registry.rings.push_back(ring);
+    }
+    return *ring;
+}
+
+inline void setTraceThreadName(const std::string& name)
+{
+    TraceRing& ring = traceRing();
+    std::lock_guard<std::mutex> lock(traceRegistry().mutex);
+    ring.name = name;
+}
+
+inline void recordTraceEvent(const char* name, uint64_t begin, uint64_t end)
+{
+    TraceRing& ring = traceRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.events[head % traceRingSize] = { name, begin, end };
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+struct TraceZone {
+    const char* name;
+    uint64_t begin;
+
+    explicit TraceZone(const char* zoneName) : name(zoneName), begin(traceNow()) {}
+    ~TraceZone() { recordTraceEvent(name, begin, traceNow()); }
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+};
+
+inline void writeTraceString(std::ostream& out, const std::string& text)
+{
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+// Chrome Trace Event Format: one complete ("X") event per zone, in microseconds
+inline bool writeTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::TRACE::FILE_NOT_WRITTEN\n" << path << std::endl;
+        return false;
+    }
+    TraceRegistry& registry = traceRegistry();
+    std::vector<std::shared_ptr<TraceRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        rings = registry.rings;
+    }
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"cgcc\"}}";
+    for (const auto& ring : rings)
+    {
+        std::string name;
+        {
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            name = ring->name;
+        }
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->thread << ",\"args\":{\"name\":";
+        writeTraceString(file, name);
+        file << "}}";
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > traceRingSize ? head - traceRingSize : 0;
+        for (uint64_t i = first; i < head; ++i)
+        {
+            const TraceEvent& event = ring->events[i % traceRingSize];
+            file << ",\n{\"name\":";
+            writeTraceString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread
+                 << ",\"ts\":" << event.begin / 1000 << "." << (event.begin % 1000) / 100
+                 << ",\"dur\":" << (event.end - event.begin) / 1000 << "." << ((event.end - event.begin) % 1000) / 100 << "}";
+        }
+    }
+    file << "\n]}\n";
+    return true;
+}
+
+} // namespace cgcc
+
+#define CGCC_TRACE_CONCAT_(a, b) a##b
+#define CGCC_TRACE_CONCAT(a, b) CGCC_TRACE_CONCAT_(a, b)
+#define CGCC_TRACE_ZONE(name) ::cgcc::TraceZone CGCC_TRACE_CONCAT(cgccTraceZone, __LINE__)(name)
+#define CGCC_TRACE_THREAD(name) ::cgcc::setTraceThreadName(name)
+#define CGCC_TRACE_WRITE(path) ::cgcc::writeTrace(path)
+
+#else
+
+#define CGCC_TRACE_ZONE(name) ((void)0)
+#define CGCC_TRACE_THREAD(name) ((void)0)
+#define CGCC_TRACE_WRITE(path) ((void)0)
+
+#endif // CGCC_TRACING
+
+#endif // CGCC_TRACE_H
@@ -0,0 +1,241 @@
+/* VertexLayout.h - vertex formats declared once, as template arguments
+ *
+ * Hand-written attribute setup repeats the layout three times: in the vertex
+ * array (how many values, in which order), in the stride and offset math of
+ * each glVertexAttribPointer, and in the shader's locations. A VertexLayout
+ * lists the attributes instead, each with the format it is stored in, and
+ * everything else is derived from that list at compile time:
+ *
+ *     using ObjVertex = cgcc::VertexLayout<
+ *         cgcc::VertexAttrib<cgcc::VertexAttribute::Position>,                              // 3 floats
+ *         cgcc::VertexAttrib<cgcc::VertexAttribute::Color, cgcc::VertexFormat::UNorm8x3>,   // 4 bytes
+ *         cgcc::VertexAttrib<cgcc::VertexAttribute::Normal, cgcc::VertexFormat::SNorm10x3>>; // 4 bytes
+ *     ObjVertex::stride                           // 20 bytes
+ *     ObjVertex::offset(2)                        // 16, where the normal starts
+ *     cgcc::setupVertexAttributes<ObjVertex>();    // the glVertexAttribPointer calls
+ *
+ *     cgcc::PackedVertices<ObjVertex> vertices;   // and the matching writer
+ *     vertices.push(position, color, normal);
+ *
+ * Attribute i goes to shader location i unless the VertexAttrib names another.
+ * The packed formats cost nothing in the shader: normalized integers and
+ * halves arrive as floats, so "in vec3 normal" reads a SNorm10x3 normal as is.
+ *
+ *     Float2/3/4   GL_FLOAT                          4 bytes per component
+ *     Half2        GL_HALF_FLOAT                     4 bytes, e.g. texture coordinates
+ *     UNorm16x2    GL_UNSIGNED_SHORT, normalized     4 bytes, [0,1] texture coordinates
+ *     UNorm8x3     GL_UNSIGNED_BYTE, normalized      4 bytes (alpha 1), colors
+ *     SNorm10x3    GL_INT_2_10_10_10_REV, normalized 4 bytes, unit normals
+ */
+
+#ifndef CGCC_VERTEXLAYOUT_H
+#define CGCC_VERTEXLAYOUT_H
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <glad/glad.h>
+
+namespace cgcc {
+
+enum class VertexAttribute { Position, Color, Normal, TexCoord };
+
+enum class VertexFormat { Float2, Float3, Float4, Half2, UNorm16x2, UNorm8x3, SNorm10x3 };
+
+struct VertexFormatInfo {
+    int inputs;        // floats written per vertex
+    GLint components;  // size given to glVertexAttribPointer
+    GLenum type;
+    GLboolean normalized;
+    int bytes;
+};
+
+constexpr VertexFormatInfo vertexFormatInfo(VertexFormat format)
+{
+    switch (format)
+    {
+    case VertexFormat::Float2: return { 2, 2, GL_FLOAT, GL_FALSE, 8 };
+    case VertexFormat::Float3: return { 3, 3, GL_FLOAT, GL_FALSE, 12 };
+    case VertexFormat::Float4: return { 4, 4, GL_FLOAT, GL_FALSE, 16 };
+    case VertexFormat::Half2: return { 2, 2, GL_HALF_FLOAT, GL_FALSE, 4 };
+    case VertexFormat::UNorm16x2: return { 2, 2, GL_UNSIGNED_SHORT, GL_TRUE, 4 };
+    case VertexFormat::UNorm8x3: return { 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4 };
+    case VertexFormat::SNorm10x3: return { 3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4 };
+    }
+    return { 0, 0, GL_FLOAT, GL_FALSE, 0 };
+}
+
+constexpr VertexFormat defaultVertexFormat(VertexAttribute attribute)
+{
+    return attribute == VertexAttribute::TexCoord ? VertexFormat::Float2 : VertexFormat::Float3;
+}
+
+// One attribute of a layout; Location -1 means its index in the layout
+template <VertexAttribute Attribute, VertexFormat Format = defaultVertexFormat(Attribute), int Location = -1>
+struct VertexAttrib {
+    static constexpr VertexAttribute attribute = Attribute;
+    static constexpr VertexFormat format = Format;
+    static constexpr int location = Location;
+};
+
+template <typename... Attribs>
+struct VertexLayout {
+    static constexpr int attributeCount = sizeof...(Attribs);
+    static constexpr VertexAttribute attributes[] = { Attribs::attribute... };
+    static constexpr VertexFormat formats[] = { Attribs::format... };
+    static constexpr int locations[] = { Attribs::location... };
+    static constexpr GLsizei stride = (vertexFormatInfo(Attribs::format).bytes + ...);
+    // Every attribute stored as floats: the vertex is also an array of floats
+    static constexpr bool allFloat = ((vertexFormatInfo(Attribs::format).type == GL_FLOAT) && ...);
+    static constexpr int floats = stride / (int)sizeof(GLfloat);
+
+    // Byte where attribute i starts inside a vertex
+    static constexpr size_t offset(int i)
+    {
+        size_t bytes = 0;
+        for (int a = 0; a < i; ++a)
+            bytes += vertexFormatInfo(formats[a]).bytes;
+        return bytes;
+    }
+
+    static constexpr GLuint location(int i)
+    {
+        return locations[i] < 0 ? (GLuint)i : (GLuint)locations[i];
+    }
+};
+
+// Attribute pointers of a layout, for the VAO and GL_ARRAY_BUFFER currently
+// bound; baseOffset is where the first vertex starts in the buffer
+template <typename Layout>
+inline void setupVertexAttributes(size_t baseOffset = 0)
+{
+    for (int i = 0; i < Layout::attributeCount; ++i)
+    {
+        VertexFormatInfo info = vertexFormatInfo(Layout::formats[i]);
+        glVertexAttribPointer(Layout::location(i), info.components, info.type, info.normalized,
+                              Layout::stride, (GLvoid*)(baseOffset + Layout::offset(i)));
+        glEnableVertexAttribArray(Layout::location(i));
+    }
+}
+
+// IEEE half, rounded to nearest even
+inline uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t biased = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+    if (biased == 0xff)
+        return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    int exponent = (int)biased - 127 + 15;
+    if (exponent >= 31)
+        return (uint16_t)(sign | 0x7c00);
+    uint32_t half, remainder, halfway;
+    if (exponent <= 0)
+    {
+        // Subnormal half
+        if (exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        half = mantissa >> shift;
+        remainder = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    }
+    else
+    {
+        half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+        remainder = mantissa & 0x1fff;
+        halfway = 0x1000;
+    }
+    if (remainder > halfway || (remainder == halfway && (half & 1)))
+        ++half; // a carry into the exponent is still the right value
+    return (uint16_t)(sign | half);
+}
+
+// Writes vertexFormatInfo(format).inputs floats in the given format
+inline void packVertexAttribute(VertexFormat format, const float* values, uint8_t* out)
+{
+    auto unorm = [](float v, float scale) { return (uint32_t)std::lround(std::clamp(v, 0.0f, 1.0f) * scale); };
+    switch (format)
+    {
+    case VertexFormat::Float2: std::memcpy(out, values, 8); break;
+    case VertexFormat::Float3: std::memcpy(out, values, 12); break;
+    case VertexFormat::Float4: std::memcpy(out, values, 16); break;
+    case VertexFormat::Half2:
+    {
+        uint16_t halves[2] = { floatToHalf(values[0]), floatToHalf(values[1]) };
+        std::memcpy(out, halves, 4);
+        break;
+    }
+    case VertexFormat::UNorm16x2:
+    {
+        uint16_t shorts[2] = { (uint16_t)unorm(values[0], 65535.0f), (uint16_t)unorm(values[1], 65535.0f) };
+        std::memcpy(out, shorts, 4);
+        break;
+    }
+    case VertexFormat::UNorm8x3:
+        for (int c = 0; c < 3; ++c)
+            out[c] = (uint8_t)unorm(values[c], 255.0f);
+        out[3] = 255;
+        break;
+    case VertexFormat::SNorm10x3:
+    {
+        // x in bits 0-9, y in 10-19, z in 20-29, two's complement; w = 0
+        uint32_t packed = 0;
+        for (int c = 0; c < 3; ++c)
+        {
+            int v = (int)std::lround(std::clamp(values[c], -1.0f, 1.0f) * 511.0f);
+            packed |= ((uint32_t)v & 0x3ff) << (10 * c);
+        }
+        std::memcpy(out, &packed, 4);
+        break;
+    }
+    }
+}
+
+// First float of an attribute value: glm vectors, float arrays, std::array...
+template <typename T>
+inline const float* vertexAttributeData(const T& value)
+{
+    return &value[0];
+}
+
+// Packs one vertex, its attributes given in layout order; returns the next vertex
+template <typename Layout, typename... Values>
+inline uint8_t* packVertex(uint8_t* out, const Values&... values)
+{
+    static_assert(sizeof...(Values) == Layout::attributeCount, "one value per attribute of the layout");
+    const float* data[] = { vertexAttributeData(values)... };
+    for (int i = 0; i < Layout::attributeCount; ++i)
+        packVertexAttribute(Layout::formats[i], data[i], out + Layout::offset(i));
+    return out + Layout::stride;
+}
+
+// Growing buffer of packed vertices, ready for glBufferData
+template <typename Layout>
+struct PackedVertices {
+    std::vector<uint8_t> bytes;
+
+    template <typename... Values>
+    void push(const Values&... values)
+    {
+        size_t end = bytes.size();
+        bytes.resize(end + Layout::stride);
+        packVertex<Layout>(bytes.data() + end, values...);
+    }
+
+    void reserve(size_t vertices) { bytes.reserve(vertices * Layout::stride); }
+    size_t count() const { return bytes.size() / Layout::stride; }
+    const uint8_t* data() const { return bytes.data(); }
+    size_t size() const { return bytes.size(); }
+};
+
+} // namespace cgcc
+
+#endif // CGCC_VERTEXLAYOUT_H
@@ -27,6 +27,33 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// On-disk cache of linked shader program binaries
+#include <cgcc/ProgramCache.h>
+
+// Vertex formats declared once: attribute pointers and vertex packing
+#include <cgcc/VertexLayout.h>
+
+// OBJ parsing into packed vertices
+#include <cgcc/OBJLoader.h>
+
+// Model matrices and ray/triangle picking
+#include <cgcc/Picking.h>
+
+// Vsync and frame rate cap
+#include <cgcc/FramePacer.h>
+
+// CPU and GPU (timer query) timings per frame, overlay and CSV
+#include <cgcc/FrameTimer.h>
+
+// Per-thread timing zones exported for chrome://tracing (with CGCC_TRACING)
+#include <cgcc/Trace.h>
+
+// Buffers and textures with size and lifetime; leak report on exit
+#include <cgcc/GPUMemory.h>
+
+// x, y, z, r, g, b as floats, at locations 0 and 1
+using PositionColor = cgcc::VertexLayout<cgcc::VertexAttrib<cgcc::VertexAttribute::Position>, cgcc::VertexAttrib<cgcc::VertexAttribute::Color>>;
+
 // Random number generator for cube positions
 std::random_device rd;
 std::mt19937 gen(rd());
@@ -69,102 +96,41 @@ const GLchar* fragmentShaderSource = "#version 450\n"
 
 // Structure to hold OBJ model data and transformations
 struct OBJModel {
-    GLuint VAO;
+    GLuint VAO, VBO;
     int numVertices;
     glm::vec3 position;
     glm::vec3 rotation; // Euler angles for simplicity
     glm::vec3 scale;
     std::vector<glm::vec3> vertices; // Store vertex positions for intersection testing
 
-    OBJModel(GLuint vao, int vertices) : VAO(vao), numVertices(vertices), position(0.0f), rotation(0.0f), scale(1.0f) {}
+    OBJModel(GLuint vao, GLuint vbo, int vertices) : VAO(vao), VBO(vbo), numVertices(vertices), position(0.0f), rotation(0.0f), scale(1.0f) {}
 };
 
 // Function to load a simple OBJ file (copied from LoadSimpleOBJ.cpp)
-int loadSimpleOBJ(string filePATH, int &nVertices, glm::vec3 color, std::vector<glm::vec3>& outVertices)
+// The buffer is returned so that it can be deleted with the VAO
+int loadSimpleOBJ(string filePATH, int &nVertices, glm::vec3 color, std::vector<glm::vec3>& outVertices, GLuint& outVBO)
  {
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> texCoords;
-    std::vector<glm::vec3> normals;
-    std::vector<GLfloat> vBuffer;
-    // glm::vec3 color = glm::vec3(1.0, 0.0, 0.0); // Default color // Remove this line
-
-    std::ifstream arqEntrada(filePATH.c_str());
-    if (!arqEntrada.is_open())
-	{
-        std::cerr << "Erro ao tentar ler o arquivo " << filePATH << std::endl;
+    CGCC_TRACE_ZONE("loadSimpleOBJ");
+    cgcc::PackedVertices<PositionColor> vBuffer;
+    if (!cgcc::parseSimpleOBJ(filePATH, color, vBuffer, outVertices))
         return -1;
-    }
-
-    std::string line;
-    while (std::getline(arqEntrada, line))
-	{
-        std::istringstream ssline(line);
-        std::string word;
-        ssline >> word;
-
-        if (word == "v")
-		{
-            glm::vec3 vertice;
-            ssline >> vertice.x >> vertice.y >> vertice.z;
-            vertices.push_back(vertice);
-        }
-        else if (word == "vt")
-		{
-            glm::vec2 vt;
-            ssline >> vt.s >> vt.t;
-            texCoords.push_back(vt);
-        }
-        else if (word == "vn")
-		{
-            glm::vec3 normal;
-            ssline >> normal.x >> normal.y >> normal.z;
-            normals.push_back(normal);
-        }
-        else if (word == "f")
-		 {
-            while (ssline >> word)
-			{
-                int vi = 0, ti = 0, ni = 0;
-                std::istringstream ss(word);
-                std::string index;
-
-                if (std::getline(ss, index, '/')) vi = !index.empty() ? std::stoi(index) - 1 : 0;
-                if (std::getline(ss, index, '/')) ti = !index.empty() ? std::stoi(index) - 1 : 0;
-                if (std::getline(ss, index)) ni = !index.empty() ? std::stoi(index) - 1 : 0;
-
-                vBuffer.push_back(vertices[vi].x);
-                vBuffer.push_back(vertices[vi].y);
-                vBuffer.push_back(vertices[vi].z);
-                vBuffer.push_back(color.r);
-                vBuffer.push_back(color.g);
-                vBuffer.push_back(color.b);
-            }
-        }
-    }
-
-    arqEntrada.close();
-
-    outVertices = vertices; // Store vertices in the output vector
 
     std::cout << "Gerando o buffer de geometria..." << std::endl;
     GLuint VBO, VAO;
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vBuffer.size() * sizeof(GLfloat), vBuffer.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vBuffer.size(), vBuffer.data(), GL_STATIC_DRAW);
 
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
+    cgcc::setupVertexAttributes<PositionColor>();
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-	nVertices = vBuffer.size() / 6;  // x, y, z, r, g, b (valores atualmente armazenados por vértice)
+	nVertices = (int)vBuffer.count();  // x, y, z, r, g, b (valores atualmente armazenados por vértice)
+    outVBO = VBO;
 
     return VAO;
 }
@@ -190,53 +156,17 @@ size_t selectedModelIndex = 0; // Index of the currently selected model
 glm::mat4 viewMatrix;
 glm::mat4 projectionMatrix;
 
-// Function to test for ray-triangle intersection (Moller-Trumbore algorithm)
-bool intersectTriangle(const glm::vec3& rayOrigin, const glm::vec3& rayDir, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& outDistance)
-{
-    const float EPSILON = 0.0000001f;
-    glm::vec3 edge1, edge2, h, s, q;
-    float a, f, u, v;
-
-    edge1 = v1 - v0;
-    edge2 = v2 - v0;
-
-    h = glm::cross(rayDir, edge2);
-    a = glm::dot(edge1, h);
-
-    if (a > -EPSILON && a < EPSILON)
-        return false; // Ray is parallel to the triangle
-
-    f = 1.0f / a;
-    s = rayOrigin - v0;
-    u = f * glm::dot(s, h);
-
-    if (u < 0.0f || u > 1.0f)
-        return false;
-
-    q = glm::cross(s, edge1);
-    v = f * glm::dot(rayDir, q);
-
-    if (v < 0.0f || u + v > 1.0f)
-        return false;
-
-    // At this stage, we can compute t to find out where the intersection point is on the line.
-    float t = f * glm::dot(edge2, q);
-
-    if (t > EPSILON) // ray intersects the triangle
-    {
-        outDistance = t;
-        return true;
-    }
-
-    // This means that the intersection point was behind the ray
-    return false;
-}
+// Frame timing: CPU time per frame, GPU time per pass and CPU time of picking.
+// 'T' shows the overlay; the statistics are written to frame_times.csv on exit
+const char* windowTitle = "Ola 3D – Otavio!";
+cgcc::FrameTimer frameTimer;
 
 // MAIN function
 int main()
 {
 	// GLFW initialization
 	glfwInit();
+	CGCC_TRACE_THREAD("main");
 
 	//Muita atenção aqui: alguns ambientes não aceitam essas configurações
 	//Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -252,7 +182,7 @@ int main()
 //#endif
 
 	// Create GLFW window
-	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Ola 3D – Otavio!", nullptr, nullptr);
+	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, windowTitle, nullptr, nullptr);
 	glfwMakeContextCurrent(window);
 
 	// Register keyboard callback function
@@ -266,6 +196,10 @@ int main()
 		std::cout << "Failed to initialize GLAD" << std::endl;
 
 	}
+	// Entry points newer than the GLAD profile (shader binary cache)
+	cgcc::loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+	// Every buffer from here on is recorded (report on exit)
+	cgcc::installGPUMemoryTracker();
 
 	// Get version information
 	const GLubyte* renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -291,18 +225,20 @@ int main()
     // Load OBJ models
     int numVerticesSuzanne;
     std::vector<glm::vec3> verticesSuzanne;
-    GLuint suzanneVAO = loadSimpleOBJ("../../assets/Modelos3D/Suzanne.obj", numVerticesSuzanne, glm::vec3(1.0f, 0.0f, 0.0f), verticesSuzanne); // Red color
+    GLuint suzanneVBO;
+    GLuint suzanneVAO = loadSimpleOBJ("../../assets/Modelos3D/Suzanne.obj", numVerticesSuzanne, glm::vec3(1.0f, 0.0f, 0.0f), verticesSuzanne, suzanneVBO); // Red color
     if (suzanneVAO != -1) {
-        models.push_back(OBJModel(suzanneVAO, numVerticesSuzanne));
+        models.push_back(OBJModel(suzanneVAO, suzanneVBO, numVerticesSuzanne));
         models.back().vertices = verticesSuzanne;
     }
 
     // Load another Suzanne model
     int numVerticesSuzanne2;
     std::vector<glm::vec3> verticesSuzanne2;
-    GLuint suzanneVAO2 = loadSimpleOBJ("../../assets/Modelos3D/Suzanne.obj", numVerticesSuzanne2, glm::vec3(1.0f, 1.0f, 0.0f), verticesSuzanne2); // Yellow color
+    GLuint suzanneVBO2;
+    GLuint suzanneVAO2 = loadSimpleOBJ("../../assets/Modelos3D/Suzanne.obj", numVerticesSuzanne2, glm::vec3(1.0f, 1.0f, 0.0f), verticesSuzanne2, suzanneVBO2); // Yellow color
     if (suzanneVAO2 != -1) {
-        models.push_back(OBJModel(suzanneVAO2, numVerticesSuzanne2));
+        models.push_back(OBJModel(suzanneVAO2, suzanneVBO2, numVerticesSuzanne2));
         models.back().vertices = verticesSuzanne2;
     }
 
@@ -318,6 +254,14 @@ int main()
     // Time variables for smooth movement
     float lastFrame = 0.0f;
 
+    // Movement and rotation run every frame: draw continuously, but at the
+    // display's rate (vsync) instead of as fast as the GPU allows
+    cgcc::FramePacer framePacer;
+    cgcc::initFramePacer(framePacer, window);
+
+    cgcc::initFrameTimer(frameTimer);
+    float lastTitleUpdate = 0.0f;
+
 	// Application loop - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
@@ -326,7 +270,9 @@ int main()
         float deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-		glfwPollEvents();
+		cgcc::beginFrame(framePacer);
+        CGCC_TRACE_ZONE("frame");
+        cgcc::beginFrameTimer(frameTimer);
 
         // Calculate view matrix (camera) - simple example
         viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), // Camera position
@@ -342,8 +288,10 @@ int main()
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
         glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
 
+        cgcc::beginGpuPass(frameTimer, "clear");
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // Change background to black
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        cgcc::beginGpuPass(frameTimer, "opaque");
 		glLineWidth(2);
 		glPointSize(5);
 		// float angle = (GLfloat)glfwGetTime(); // Remove unused angle variable
@@ -401,11 +349,7 @@ int main()
 			// model = glm::translate(model, cubeOffsets[i]); // Remove this line
 
             // Apply model's transformations
-            model = glm::translate(model, models[i].position);
-            model = glm::rotate(model, glm::radians(models[i].rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(models[i].rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(models[i].rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-            model = glm::scale(model, glm::vec3(models[i].scale));
+            model = cgcc::composeModelMatrix(models[i].position, models[i].rotation, glm::vec3(models[i].scale));
 
 
 			glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
@@ -415,15 +359,32 @@ int main()
             glBindVertexArray(0); // Unbind VAO
 		}
 		// glBindVertexArray(0); // Remove this line
-		glfwSwapBuffers(window);
+        // Timing overlay on top of the frame, min/avg/p99 in the title twice a second
+        if (frameTimer.overlay) {
+            cgcc::drawFrameTimerOverlay(frameTimer, width, height);
+            if (currentFrame - lastTitleUpdate > 0.5f) {
+                glfwSetWindowTitle(window, cgcc::frameTimerSummary(frameTimer).c_str());
+                lastTitleUpdate = currentFrame;
+            }
+        }
+        cgcc::endFrameTimer(frameTimer);
+		cgcc::endFrame(framePacer);
 	}
 	// Request OpenGL to deallocate buffers
 	// glDeleteVertexArrays(1, &VAO); // Remove this line
-    // Delete all model VAOs
+    // Delete all model VAOs and their buffers
     for (const auto& model : models) {
         glDeleteVertexArrays(1, &model.VAO);
+        glDeleteBuffers(1, &model.VBO);
     }
+    cgcc::writeFrameTimerCSV(frameTimer, "frame_times.csv");
+    std::cout << cgcc::frameTimerSummary(frameTimer) << std::endl;
+    cgcc::destroyFrameTimer(frameTimer);
 	// Terminate GLFW execution, cleaning up allocated resources
+	CGCC_TRACE_WRITE("trace.json");
+	// Anything still allocated here is a leak
+	cgcc::reportGPUMemory(std::cout);
+	cgcc::removeGPUMemoryTracker();
 	glfwTerminate();
 	return 0;
 }
@@ -458,6 +419,14 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	if (key == GLFW_KEY_LEFT_BRACKET) isScalingDown = (action != GLFW_RELEASE);
 	if (key == GLFW_KEY_RIGHT_BRACKET) isScalingUp = (action != GLFW_RELEASE);
 
+    // Toggle the frame timing overlay on 'T' press (numbers in the window title)
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        frameTimer.overlay = !frameTimer.overlay;
+        if (!frameTimer.overlay)
+            glfwSetWindowTitle(window, windowTitle);
+        std::cout << "Frame timing overlay: " << (frameTimer.overlay ? "ON" : "OFF") << std::endl;
+    }
+
     // Select next model on 'M' press
     // if (key == GLFW_KEY_M && action == GLFW_PRESS) { // Remove this block
     //     selectedModelIndex = (selectedModelIndex + 1) % models.size();
@@ -471,6 +440,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
     {
+        cgcc::beginCpuSection(frameTimer, "picking");
         double xpos, ypos;
         glfwGetCursorPos(window, &xpos, &ypos);
 
@@ -502,11 +472,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 
         for (size_t i = 0; i < models.size(); ++i)
         {
-            glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), models[i].position);
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(models[i].rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(models[i].rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(models[i].rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-            modelMatrix = glm::scale(modelMatrix, glm::vec3(models[i].scale));
+            glm::mat4 modelMatrix = cgcc::composeModelMatrix(models[i].position, models[i].rotation, glm::vec3(models[i].scale));
 
             glm::mat4 inverseModelMatrix = glm::inverse(modelMatrix);
 
@@ -521,7 +487,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
                 glm::vec3 v2 = models[i].vertices[j + 2];
 
                 float distance;
-                if (intersectTriangle(localRayOrigin, localRayDir, v0, v1, v2, distance))
+                if (cgcc::intersectTriangle(localRayOrigin, localRayDir, v0, v1, v2, distance))
                 {
                     if (distance < closestDistance)
                     {
@@ -532,6 +498,8 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
             }
         }
 
+        cgcc::endCpuSection(frameTimer, "picking");
+
         if (intersectedModelIndex != -1)
         {
             selectedModelIndex = intersectedModelIndex;
@@ -545,6 +513,12 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 // The function returns the shader program identifier
 int setupShader()
 {
+	CGCC_TRACE_ZONE("setupShader");
+	// If the program was linked on a previous run, restore the binary from the cache
+	uint64_t cacheKey = cgcc::programCacheKey({ vertexShaderSource, fragmentShaderSource });
+	if (GLuint cachedProgram = cgcc::loadCachedProgram(cacheKey))
+		return cachedProgram;
+
 	// Vertex shader
 	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
@@ -570,6 +544,7 @@ int setupShader()
 	}
 	// Link shaders and create shader program identifier
 	GLuint shaderProgram = glCreateProgram();
+	cgcc::markProgramRetrievable(shaderProgram);
 	glAttachShader(shaderProgram, vertexShader);
 	glAttachShader(shaderProgram, fragmentShader);
 	glLinkProgram(shaderProgram);
@@ -581,6 +556,9 @@ int setupShader()
 	}
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
+	// Keep the linked binary for the next runs
+	if (success)
+		cgcc::storeCachedProgram(cacheKey, shaderProgram);
 
 	return shaderProgram;
 }
@@ -643,13 +621,10 @@ int setupGeometry()
 	// Size in bytes
 	// Offset from byte zero
 	
-	// Position attribute (x, y, z)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	// Color attribute (r, g, b)
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3*sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
+	// Here they come from the PositionColor layout: position attribute (x, y, z)
+	// at location 0, color attribute (r, g, b) at location 1
+	static_assert(PositionColor::floats == 6, "the array above is x, y, z, r, g, b");
+	cgcc::setupVertexAttributes<PositionColor>();
 
 
 	// Note that this is allowed, the call to glVertexAttribPointer registered the VBO as the currently
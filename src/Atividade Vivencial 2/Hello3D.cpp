@@ -27,6 +27,56 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Optional GPU occlusion culling (hierarchical Z), clustered lighting, deferred shading
+// and depth prepass; background shader compilation with hot reload
+#include <cgcc/GLExt.h>
+#include <cgcc/AsyncShader.h>
+#include <cgcc/ShaderPermutation.h>
+#include <cgcc/HiZCulling.h>
+#include <cgcc/ClusteredLighting.h>
+#include <cgcc/DeferredShading.h>
+#include <cgcc/DepthPrepass.h>
+
+// Vertex formats declared once: attribute pointers and vertex packing
+#include <cgcc/VertexLayout.h>
+
+// OBJ parsing into packed vertices
+#include <cgcc/OBJLoader.h>
+
+// Model matrices and ray/triangle picking
+#include <cgcc/Picking.h>
+
+// Vsync and frame rate cap
+#include <cgcc/FramePacer.h>
+
+// CPU and GPU (timer query) timings per frame, overlay and CSV
+#include <cgcc/FrameTimer.h>
+
+// Per-thread timing zones exported for chrome://tracing (with CGCC_TRACING)
+#include <cgcc/Trace.h>
+
+// Per-frame counts of draws, binds, uniform uploads and buffer bytes
+#include <cgcc/GLCallCounters.h>
+
+// Buffers and textures with size, owner and lifetime; leak report on exit
+#include <cgcc/GPUMemory.h>
+
+// Heap allocations per subsystem (with CGCC_ALLOC_TRACKING); scratch arenas for
+// loading and per-frame data
+#define CGCC_ALLOC_TRACKER_IMPLEMENTATION
+#include <cgcc/AllocTracker.h>
+#include <cgcc/Arena.h>
+
+// OBJ meshes: float position, 8-bit color and 10-bit normal (20 bytes instead of
+// 9 floats), at locations 0, 1 and 2 of phong.vert
+using ObjVertex = cgcc::VertexLayout<
+    cgcc::VertexAttrib<cgcc::VertexAttribute::Position>,
+    cgcc::VertexAttrib<cgcc::VertexAttribute::Color, cgcc::VertexFormat::UNorm8x3>,
+    cgcc::VertexAttrib<cgcc::VertexAttribute::Normal, cgcc::VertexFormat::SNorm10x3>>;
+
+// Cube: x, y, z, r, g, b as floats
+using PositionColor = cgcc::VertexLayout<cgcc::VertexAttrib<cgcc::VertexAttribute::Position>, cgcc::VertexAttrib<cgcc::VertexAttribute::Color>>;
+
 // Random number generator for cube positions
 std::random_device rd;
 std::mt19937 gen(rd());
@@ -38,186 +88,144 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
 // Function prototypes
-int setupShader();
+void setupShaders();
+void pollShaders(double now);
 int setupGeometry();
 
 // Window dimensions (can be changed at runtime)
 const GLuint WIDTH = 1000, HEIGHT = 1000;
 
 
-// Vertex Shader source code
-const GLchar* vertexShaderSource = "#version 450\n"
+// Shader sources live in assets/shaders and are compiled in the background
+// (see setupShaders). This flat shader is drawn until they are ready
+const GLchar* fallbackVertexShaderSource = "#version 400\n"
 "layout (location = 0) in vec3 position;\n"
 "layout (location = 1) in vec3 color;\n"
-"layout (location = 2) in vec3 normal;\n"
 "uniform mat4 model;\n"
 "uniform mat4 view;\n"
 "uniform mat4 projection;\n"
-"out vec3 vNormal;\n"
-"out vec3 vFragPos;\n"
 "out vec3 vColor;\n"
 "void main()\n"
 "{\n"
-"    vec4 worldPos = model * vec4(position, 1.0);\n"
-"    gl_Position = projection * view * worldPos;\n"
-"    vFragPos = vec3(worldPos);\n"
-"    vNormal = mat3(transpose(inverse(model))) * normal;\n"
+"    gl_Position = projection * view * model * vec4(position, 1.0);\n"
 "    vColor = color;\n"
 "}\0";
 
-// Fragment Shader source code
-const GLchar* fragmentShaderSource = "#version 450\n"
-"struct Light {\n"
-"    vec3 position;\n"
-"    vec3 color;\n"
-"    float intensity;\n"
-"};\n"
-"uniform Light lights[3];\n"
-"uniform vec3 camPos;\n"
-"uniform float ka;\n"
-"uniform float kd;\n"
-"uniform float ks;\n"
-"uniform float q;\n"
-"in vec3 vNormal;\n"
-"in vec3 vFragPos;\n"
+const GLchar* fallbackFragmentShaderSource = "#version 400\n"
 "in vec3 vColor;\n"
 "out vec4 color;\n"
 "void main()\n"
 "{\n"
-"    vec3 N = normalize(vNormal);\n"
-"    vec3 V = normalize(camPos - vFragPos);\n"
-"    vec3 result = vec3(0.0);\n"
-"    for (int i = 0; i < 3; ++i) {\n"
-"        vec3 L = normalize(lights[i].position - vFragPos);\n"
-"        vec3 lightColor = lights[i].color * lights[i].intensity;\n"
-"        // Ambient\n"
-"        vec3 ambient = ka * lightColor;\n"
-"        // Diffuse\n"
-"        float diff = max(dot(N, L), 0.0);\n"
-"        vec3 diffuse = kd * diff * lightColor;\n"
-"        // Specular\n"
-"        vec3 R = reflect(-L, N);\n"
-"        float spec = pow(max(dot(R, V), 0.0), q);\n"
-"        vec3 specular = ks * spec * lightColor;\n"
-"        result += (ambient + diffuse) * vColor + specular;\n"
-"    }\n"
-"    color = vec4(result, 1.0);\n"
+"    color = vec4(0.5 * vColor, 1.0);\n"
 "}\0";
 
+// Uniform locations shared by the Phong programs
+struct PhongUniforms {
+    GLint model, view, projection, camPos, ka, kd, ks, q;
+    GLint lightPos[3], lightColor[3], lightIntensity[3];
+};
+
+PhongUniforms getPhongUniforms(GLuint program)
+{
+    PhongUniforms u;
+    u.model = glGetUniformLocation(program, "model");
+    u.view = glGetUniformLocation(program, "view");
+    u.projection = glGetUniformLocation(program, "projection");
+    u.camPos = glGetUniformLocation(program, "camPos");
+    u.ka = glGetUniformLocation(program, "ka");
+    u.kd = glGetUniformLocation(program, "kd");
+    u.ks = glGetUniformLocation(program, "ks");
+    u.q = glGetUniformLocation(program, "q");
+    // Light struct uniforms
+    char nameBuf[64];
+    for (int i = 0; i < 3; ++i) {
+        sprintf(nameBuf, "lights[%d].position", i);
+        u.lightPos[i] = glGetUniformLocation(program, nameBuf);
+        sprintf(nameBuf, "lights[%d].color", i);
+        u.lightColor[i] = glGetUniformLocation(program, nameBuf);
+        sprintf(nameBuf, "lights[%d].intensity", i);
+        u.lightIntensity[i] = glGetUniformLocation(program, nameBuf);
+    }
+    return u;
+}
+
+// A Phong program compiled in the background, with the uniform locations of its
+// current link (refreshed whenever it is relinked)
+struct PhongProgram {
+    cgcc::AsyncProgram async;
+    PhongUniforms uniforms;
+};
+
+// Forward, clustered forward, deferred (G-buffer + lighting) and depth prepass programs
+PhongProgram forwardProgram, clusteredProgram, gBufferProgram, deferredProgram, deferredClusteredProgram, prepassProgram;
+PhongProgram fallbackProgram; // built synchronously, never reloaded
+const std::string shaderDir = "../../assets/shaders/";
+
+// Feature set of the forward Phong shaders: the OBJ vertex format (color + normal),
+// the three main lights and a material with ks > 0. Only this permutation is compiled
+constexpr uint32_t forwardPermutation = cgcc::shaderPermutation(3, cgcc::FeatureVertexColor | cgcc::FeatureSpecular);
+
 // Structure to hold OBJ model data and transformations
 struct OBJModel {
-    GLuint VAO;
+    GLuint VAO, VBO;
+    GLuint positionVAO, positionVBO; // Position-only stream for the depth prepass
     int numVertices;
     glm::vec3 position;
     glm::vec3 rotation; // Euler angles for simplicity
     glm::vec3 scale;
     std::vector<glm::vec3> vertices; // Store vertex positions for intersection testing
+    glm::vec3 boundsMin, boundsMax; // Local-space bounding box (used by occlusion culling)
 
-    OBJModel(GLuint vao, int vertices) : VAO(vao), numVertices(vertices), position(0.0f), rotation(0.0f), scale(1.0f) {}
+    OBJModel(GLuint vao, GLuint vbo, int vertices) : VAO(vao), VBO(vbo), positionVAO(0), positionVBO(0), numVertices(vertices), position(0.0f), rotation(0.0f), scale(1.0f), boundsMin(0.0f), boundsMax(0.0f) {}
 };
 
+// Compute the local-space bounding box from the stored vertex positions
+void computeBounds(OBJModel& model)
+{
+    if (model.vertices.empty()) return;
+    model.boundsMin = model.boundsMax = model.vertices[0];
+    for (const glm::vec3& v : model.vertices) {
+        model.boundsMin = glm::min(model.boundsMin, v);
+        model.boundsMax = glm::max(model.boundsMax, v);
+    }
+}
+
 // Function to load a simple OBJ file (copied from LoadSimpleOBJ.cpp)
-int loadSimpleOBJ(string filePATH, int &nVertices, glm::vec3 color, std::vector<glm::vec3>& outVertices)
+// If outPositionVAO is given, also builds the position-only stream used by the depth prepass.
+// The buffers are returned so that they can be deleted with the VAOs.
+// The file and the parser's temporary arrays go to scratch, reset by the caller
+int loadSimpleOBJ(string filePATH, int &nVertices, glm::vec3 color, std::vector<glm::vec3>& outVertices, GLuint& outVBO, cgcc::LinearArena& scratch, GLuint* outPositionVAO = nullptr, GLuint* outPositionVBO = nullptr)
  {
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> texCoords;
-    std::vector<glm::vec3> normals;
-    std::vector<GLfloat> vBuffer;
-    // glm::vec3 color = glm::vec3(1.0, 0.0, 0.0); // Default color // Remove this line
-
-    std::ifstream arqEntrada(filePATH.c_str());
-    if (!arqEntrada.is_open())
-    {
-        std::cerr << "Erro ao tentar ler o arquivo " << filePATH << std::endl;
+    CGCC_TRACE_ZONE("loadSimpleOBJ");
+    cgcc::GPUMemoryTag memoryTag(filePATH);
+    cgcc::PackedVertices<ObjVertex> vBuffer;
+    if (!cgcc::parseSimpleOBJ(filePATH, color, vBuffer, outVertices, &scratch))
         return -1;
-    }
-
-    std::string line;
-    while (std::getline(arqEntrada, line))
-    {
-        std::istringstream ssline(line);
-        std::string word;
-        ssline >> word;
-
-        if (word == "v")
-        {
-            glm::vec3 vertice;
-            ssline >> vertice.x >> vertice.y >> vertice.z;
-            vertices.push_back(vertice);
-        }
-        else if (word == "vt")
-        {
-            glm::vec2 vt;
-            ssline >> vt.s >> vt.t;
-            texCoords.push_back(vt);
-        }
-        else if (word == "vn")
-        {
-            glm::vec3 normal;
-            ssline >> normal.x >> normal.y >> normal.z;
-            normals.push_back(normal);
-        }
-        else if (word == "f")
-         {
-            while (ssline >> word)
-            {
-                int vi = 0, ti = 0, ni = 0;
-                std::istringstream ss(word);
-                std::string index;
-
-                if (std::getline(ss, index, '/')) vi = !index.empty() ? std::stoi(index) - 1 : 0;
-                if (std::getline(ss, index, '/')) ti = !index.empty() ? std::stoi(index) - 1 : 0;
-                if (std::getline(ss, index)) ni = !index.empty() ? std::stoi(index) - 1 : 0;
-
-                vBuffer.push_back(vertices[vi].x);
-                vBuffer.push_back(vertices[vi].y);
-                vBuffer.push_back(vertices[vi].z);
-                vBuffer.push_back(color.r);
-                vBuffer.push_back(color.g);
-                vBuffer.push_back(color.b);
-                // Add normal (if available)
-                if (ni >= 0 && ni < normals.size()) {
-                    vBuffer.push_back(normals[ni].x);
-                    vBuffer.push_back(normals[ni].y);
-                    vBuffer.push_back(normals[ni].z);
-                } else {
-                    // Default normal if missing
-                    vBuffer.push_back(0.0f);
-                    vBuffer.push_back(0.0f);
-                    vBuffer.push_back(1.0f);
-                }
-            }
-        }
-    }
-
-    arqEntrada.close();
-
-    outVertices = vertices; // Store vertices in the output vector
 
     std::cout << "Gerando o buffer de geometria..." << std::endl;
     GLuint VBO, VAO;
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vBuffer.size() * sizeof(GLfloat), vBuffer.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vBuffer.size(), vBuffer.data(), GL_STATIC_DRAW);
 
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
 
-
-    // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(0);
-    // Color
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-    // Normal
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(2);
+    // Position, color, normal
+    cgcc::setupVertexAttributes<ObjVertex>();
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    nVertices = vBuffer.size() / 9;  // x, y, z, r, g, b, nx, ny, nz
+    nVertices = (int)vBuffer.count();
+    outVBO = VBO;
+
+    if (outPositionVAO) {
+        GLuint positionVBO;
+        *outPositionVAO = cgcc::createPositionStream(vBuffer.data(), nVertices, ObjVertex::stride, positionVBO);
+        if (outPositionVBO)
+            *outPositionVBO = positionVBO;
+    }
 
     return VAO;
 }
@@ -243,53 +251,38 @@ size_t selectedModelIndex = 0; // Index of the currently selected model
 glm::mat4 viewMatrix;
 glm::mat4 projectionMatrix;
 
-// Function to test for ray-triangle intersection (Moller-Trumbore algorithm)
-bool intersectTriangle(const glm::vec3& rayOrigin, const glm::vec3& rayDir, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& outDistance)
-{
-    const float EPSILON = 0.0000001f;
-    glm::vec3 edge1, edge2, h, s, q;
-    float a, f, u, v;
-
-    edge1 = v1 - v0;
-    edge2 = v2 - v0;
-
-    h = glm::cross(rayDir, edge2);
-    a = glm::dot(edge1, h);
-
-    if (a > -EPSILON && a < EPSILON)
-        return false; // Ray is parallel to the triangle
-
-    f = 1.0f / a;
-    s = rayOrigin - v0;
-    u = f * glm::dot(s, h);
+// Frame timing: CPU time per frame, GPU time per pass and CPU time of picking.
+// 'T' shows the overlay; the statistics are written to frame_times.csv on exit
+const char* windowTitle = "Ola 3D – Otavio!";
+cgcc::FrameTimer frameTimer;
 
-    if (u < 0.0f || u > 1.0f)
-        return false;
+// Hierarchical-Z occlusion culling, toggled with 'O'
+bool occlusionCulling = false;
+cgcc::HiZCuller hiZCuller;
+std::vector<cgcc::HiZInstance> hiZInstances;
 
-    q = glm::cross(s, edge1);
-    v = f * glm::dot(rayDir, q);
+// Clustered lighting, toggled with 'L'. The first three point lights are the
+// ones that follow the selected model; 'K' spawns more around the scene
+bool clusteredLighting = false;
+cgcc::ClusterGrid clusterGrid;
+std::vector<cgcc::PointLight> pointLights(3);
+const size_t lightsPerSpawn = 100;
 
-    if (v < 0.0f || u + v > 1.0f)
-        return false;
+// Deferred shading, toggled with 'G': geometry pass into a G-buffer, then one
+// lighting pass over the visible pixels
+bool deferredShading = false;
+cgcc::GBuffer gBuffer;
 
-    // At this stage, we can compute t to find out where the intersection point is on the line.
-    float t = f * glm::dot(edge2, q);
-
-    if (t > EPSILON) // ray intersects the triangle
-    {
-        outDistance = t;
-        return true;
-    }
-
-    // This means that the intersection point was behind the ray
-    return false;
-}
+// Depth prepass, toggled with 'P': depth-only pass, then shading with GL_EQUAL so
+// each pixel is shaded once. Models are always drawn front to back
+bool depthPrepass = false;
 
 // MAIN function
 int main()
 {
     // GLFW initialization
     glfwInit();
+    CGCC_TRACE_THREAD("main");
 
     //Muita atenção aqui: alguns ambientes não aceitam essas configurações
     //Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -305,7 +298,7 @@ int main()
 //#endif
 
     // Create GLFW window
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Ola 3D – Otavio!", nullptr, nullptr);
+    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, windowTitle, nullptr, nullptr);
     glfwMakeContextCurrent(window);
 
     // Register keyboard callback function
@@ -319,6 +312,12 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
 
     }
+    // Entry points newer than the GLAD profile (compute shaders etc.)
+    cgcc::loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    // Counting wrappers around the GL entry points ('C' logs them to gl_calls.csv)
+    cgcc::installGLCallCounters();
+    // Every buffer and texture from here on is recorded (report and gpu_memory.csv on exit)
+    cgcc::installGPUMemoryTracker();
 
     // Get version information
     const GLubyte* renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -332,8 +331,10 @@ int main()
     glViewport(0, 0, width, height);
 
 
-    // Compile and build the shader program
-    GLuint shaderID = setupShader();
+    // Start compiling the shader programs (in the background, from assets/shaders)
+    setupShaders();
+    // Clustered lighting needs shader storage buffers (OpenGL 4.3)
+    clusteredLighting = cgcc::glCaps.storageBuffers;
 
     // Generate a simple buffer with triangle geometry
     // GLuint VAO = setupGeometry(); // Remove this line
@@ -342,46 +343,33 @@ int main()
     // cubeOffsets.push_back(glm::vec3(0.0f, 0.0f, 0.0f)); // Remove this line
 
     // Load OBJ models
-    int numVerticesSuzanne;
-    std::vector<glm::vec3> verticesSuzanne;
-    GLuint suzanneVAO = loadSimpleOBJ("../../assets/Modelos3D/Suzanne.obj", numVerticesSuzanne, glm::vec3(1.0f, 0.0f, 0.0f), verticesSuzanne); // Red color
-    if (suzanneVAO != -1) {
-        models.push_back(OBJModel(suzanneVAO, numVerticesSuzanne));
-        models.back().vertices = verticesSuzanne;
-    }
-
-    // Load another Suzanne model
-    int numVerticesSuzanne2;
-    std::vector<glm::vec3> verticesSuzanne2;
-    GLuint suzanneVAO2 = loadSimpleOBJ("../../assets/Modelos3D/Suzanne.obj", numVerticesSuzanne2, glm::vec3(1.0f, 1.0f, 0.0f), verticesSuzanne2); // Yellow color
-    if (suzanneVAO2 != -1) {
-        models.push_back(OBJModel(suzanneVAO2, numVerticesSuzanne2));
-        models.back().vertices = verticesSuzanne2;
-    }
-
-
-    glUseProgram(shaderID);
-
-    GLint modelLoc = glGetUniformLocation(shaderID, "model");
-    GLint viewLoc = glGetUniformLocation(shaderID, "view");
-    GLint projLoc = glGetUniformLocation(shaderID, "projection");
-
-    GLint camPosLoc = glGetUniformLocation(shaderID, "camPos");
-    GLint kaLoc = glGetUniformLocation(shaderID, "ka");
-    GLint kdLoc = glGetUniformLocation(shaderID, "kd");
-    GLint ksLoc = glGetUniformLocation(shaderID, "ks");
-    GLint qLoc = glGetUniformLocation(shaderID, "q");
+    {
+        CGCC_ALLOC_SCOPE("load");
+        cgcc::LinearArena loadScratch(1024 * 1024);
+        int numVerticesSuzanne;
+        std::vector<glm::vec3> verticesSuzanne;
+        GLuint suzanneVBO, suzannePositionVAO, suzannePositionVBO;
+        GLuint suzanneVAO = loadSimpleOBJ("../../assets/Modelos3D/Suzanne.obj", numVerticesSuzanne, glm::vec3(1.0f, 0.0f, 0.0f), verticesSuzanne, suzanneVBO, loadScratch, &suzannePositionVAO, &suzannePositionVBO); // Red color
+        if (suzanneVAO != -1) {
+            models.push_back(OBJModel(suzanneVAO, suzanneVBO, numVerticesSuzanne));
+            models.back().positionVAO = suzannePositionVAO;
+            models.back().positionVBO = suzannePositionVBO;
+            models.back().vertices = std::move(verticesSuzanne);
+            computeBounds(models.back());
+        }
 
-    // Light struct uniforms
-    GLint lightPosLoc[3], lightColorLoc[3], lightIntensityLoc[3];
-    char nameBuf[64];
-    for (int i = 0; i < 3; ++i) {
-        sprintf(nameBuf, "lights[%d].position", i);
-        lightPosLoc[i] = glGetUniformLocation(shaderID, nameBuf);
-        sprintf(nameBuf, "lights[%d].color", i);
-        lightColorLoc[i] = glGetUniformLocation(shaderID, nameBuf);
-        sprintf(nameBuf, "lights[%d].intensity", i);
-        lightIntensityLoc[i] = glGetUniformLocation(shaderID, nameBuf);
+        // Load another Suzanne model
+        int numVerticesSuzanne2;
+        std::vector<glm::vec3> verticesSuzanne2;
+        GLuint suzanneVBO2, suzannePositionVAO2, suzannePositionVBO2;
+        GLuint suzanneVAO2 = loadSimpleOBJ("../../assets/Modelos3D/Suzanne.obj", numVerticesSuzanne2, glm::vec3(1.0f, 1.0f, 0.0f), verticesSuzanne2, suzanneVBO2, loadScratch, &suzannePositionVAO2, &suzannePositionVBO2); // Yellow color
+        if (suzanneVAO2 != -1) {
+            models.push_back(OBJModel(suzanneVAO2, suzanneVBO2, numVerticesSuzanne2));
+            models.back().positionVAO = suzannePositionVAO2;
+            models.back().positionVBO = suzannePositionVBO2;
+            models.back().vertices = std::move(verticesSuzanne2);
+            computeBounds(models.back());
+        }
     }
 
     glEnable(GL_DEPTH_TEST);
@@ -394,6 +382,23 @@ int main()
         glm::vec3(1.0f, 1.0f, 1.0f)
     };
     float lightIntensities[3] = { 1.0f, 0.5f, 0.3f };
+    // Radius large enough that the three main lights look like the unbounded ones
+    const float mainLightRadius = 20.0f;
+
+    // Draw order of the models, nearest first
+    std::vector<uint32_t> drawOrder;
+    std::vector<glm::vec3> modelCenters;
+
+    // Movement, rotation and shader compiles need every frame: draw
+    // continuously, paced by vsync
+    cgcc::FramePacer framePacer;
+    cgcc::initFramePacer(framePacer, window);
+
+    cgcc::initFrameTimer(frameTimer);
+    float lastTitleUpdate = 0.0f;
+
+    // Per-frame arrays (model matrices, sort keys), without touching the heap once warm
+    cgcc::FrameArena frameArena;
 
     while (!glfwWindowShouldClose(window))
     {
@@ -401,19 +406,55 @@ int main()
         float deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        glfwPollEvents();
+        cgcc::beginFrame(framePacer);
+        CGCC_TRACE_ZONE("frame");
+        CGCC_ALLOC_SCOPE("frame");
+        CGCC_ALLOC_FRAME();
+        cgcc::LinearArena& frameScratch = frameArena.beginFrame();
+        cgcc::beginFrameTimer(frameTimer);
+        cgcc::beginGLCallFrame();
+        pollShaders(currentFrame);
+
+        // Window resized: the viewport and the size-dependent targets (G-buffer,
+        // Hi-Z culler, cluster grid) follow the framebuffer; 0x0 while minimized
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        if ((framebufferWidth != width || framebufferHeight != height) && framebufferWidth > 0 && framebufferHeight > 0) {
+            width = framebufferWidth;
+            height = framebufferHeight;
+            glViewport(0, 0, width, height);
+        }
+
+        // Program that draws the models and program that evaluates the lights:
+        // the same forward shader, or the G-buffer pass and the deferred lighting pass.
+        // Modes whose programs are still compiling fall back to forward / the flat shader
+        const PhongProgram& forward = clusteredLighting ? clusteredProgram : forwardProgram;
+        const PhongProgram& deferredLighting = clusteredLighting ? deferredClusteredProgram : deferredProgram;
+        bool deferredActive = deferredShading && cgcc::asyncProgramReady(gBufferProgram.async) && cgcc::asyncProgramReady(deferredLighting.async);
+        const PhongProgram& drawProgram = deferredActive ? gBufferProgram : (cgcc::asyncProgramReady(forward.async) ? forward : fallbackProgram);
+        const PhongProgram& lightingProgram = deferredActive ? deferredLighting : drawProgram;
+        bool prepassActive = depthPrepass && cgcc::asyncProgramReady(prepassProgram.async) && &drawProgram != &fallbackProgram;
+        GLuint activeShaderID = drawProgram.async.program;
+        const PhongUniforms& u = drawProgram.uniforms;
+        GLuint lightingShaderID = lightingProgram.async.program;
+        const PhongUniforms& lu = lightingProgram.uniforms;
 
         // Camera
         glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 5.0f);
         viewMatrix = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         projectionMatrix = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 100.0f);
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-        glUniform3fv(camPosLoc, 1, glm::value_ptr(cameraPos));
-        glUniform1f(kaLoc, ka);
-        glUniform1f(kdLoc, kd);
-        glUniform1f(ksLoc, ks);
-        glUniform1f(qLoc, q);
+        // Uniforms a program does not use have location -1 and are ignored
+        for (int pass = 0; pass < (deferredActive ? 2 : 1); ++pass) {
+            const PhongUniforms& pu = pass == 0 ? u : lu;
+            glUseProgram(pass == 0 ? activeShaderID : lightingShaderID);
+            glUniformMatrix4fv(pu.view, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+            glUniformMatrix4fv(pu.projection, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+            glUniform3fv(pu.camPos, 1, glm::value_ptr(cameraPos));
+            glUniform1f(pu.ka, ka);
+            glUniform1f(pu.kd, kd);
+            glUniform1f(pu.ks, ks);
+            glUniform1f(pu.q, q);
+        }
 
         glm::vec3 objPos = models[selectedModelIndex].position;
         float objScale = models[selectedModelIndex].scale.x;
@@ -422,17 +463,31 @@ int main()
             objPos + glm::vec3(-2.0f * objScale, 1.0f * objScale, 2.0f * objScale),
             objPos + glm::vec3(0.0f, 3.0f * objScale, -2.0f * objScale)
         };
-        for (int i = 0; i < 3; ++i) {
-            glUniform3fv(lightPosLoc[i], 1, glm::value_ptr(lightPositions[i]));
-            glUniform3fv(lightColorLoc[i], 1, glm::value_ptr(lightColors[i]));
-            glUniform1f(lightIntensityLoc[i], lightIntensities[i]);
+        if (clusteredLighting) {
+            for (int i = 0; i < 3; ++i)
+                pointLights[i] = { lightPositions[i], mainLightRadius, lightColors[i], lightIntensities[i] };
+            if (clusterGrid.width != width || clusterGrid.height != height || !(clusterGrid.projection == projectionMatrix)) {
+                cgcc::GPUMemoryTag memoryTag("cluster grid");
+                cgcc::initClusterGrid(clusterGrid, width, height, projectionMatrix, 0.1f, 100.0f);
+            }
+            cgcc::buildClusters(clusterGrid, pointLights, viewMatrix);
+        } else {
+            for (int i = 0; i < 3; ++i) {
+                glUniform3fv(lu.lightPos[i], 1, glm::value_ptr(lightPositions[i]));
+                glUniform3fv(lu.lightColor[i], 1, glm::value_ptr(lightColors[i]));
+                glUniform1f(lu.lightIntensity[i], lightIntensities[i]);
+            }
         }
 
+        cgcc::beginGpuPass(frameTimer, "clear");
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        cgcc::endGpuPass(frameTimer);
         glLineWidth(2);
         glPointSize(5);
 
+        // Update transformations and build the model matrices
+        glm::mat4* modelMatrices = frameScratch.allocate<glm::mat4>(models.size());
         for (size_t i = 0; i < models.size(); i++) {
             glm::mat4 model = glm::mat4(1);
             if (i == selectedModelIndex) {
@@ -453,21 +508,129 @@ int main()
                         models[i].rotation.z += rotationSpeed * deltaTime;
                 }
             }
-            model = glm::translate(model, models[i].position);
-            model = glm::rotate(model, glm::radians(models[i].rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(models[i].rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(models[i].rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-            model = glm::scale(model, glm::vec3(models[i].scale));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            model = cgcc::composeModelMatrix(models[i].position, models[i].rotation, glm::vec3(models[i].scale));
+            modelMatrices[i] = model;
+        }
+
+        // Front-to-back order by the view depth of each bounding box center
+        modelCenters.resize(models.size());
+        for (size_t i = 0; i < models.size(); i++)
+            modelCenters[i] = glm::vec3(modelMatrices[i] * glm::vec4(0.5f * (models[i].boundsMin + models[i].boundsMax), 1.0f));
+        cgcc::sortFrontToBack(drawOrder, modelCenters, viewMatrix, &frameScratch);
+
+        // Occlusion culling: depth prepass + Hi-Z pyramid + per-model visibility on the GPU
+        if (occlusionCulling) {
+            cgcc::beginGpuPass(frameTimer, "culling");
+            cgcc::GPUMemoryTag memoryTag("Hi-Z culler");
+            if (hiZCuller.prepassProgram == 0) {
+                // Without it there is nothing to cull with: draw everything, and try again on the next 'O'
+                if (!cgcc::initHiZCuller(hiZCuller, width, height)) {
+                    std::cout << "ERROR::HIZ::INIT_FAILED occlusion culling turned off" << std::endl;
+                    cgcc::destroyHiZCuller(hiZCuller);
+                    occlusionCulling = false;
+                }
+            } else if (hiZCuller.width != width || hiZCuller.height != height) {
+                cgcc::resizeHiZCuller(hiZCuller, width, height);
+            }
+        }
+        if (occlusionCulling) {
+            hiZInstances.resize(models.size());
+            for (size_t i = 0; i < models.size(); i++)
+                hiZInstances[i] = { models[i].VAO, 0, models[i].numVertices, modelMatrices[i], models[i].boundsMin, models[i].boundsMax };
+            cgcc::hiZBeginFrame(hiZCuller, hiZInstances, projectionMatrix * viewMatrix);
+        }
+        // Bound after the culler, whose compute pass reuses the storage buffer slots
+        if (clusteredLighting) {
+            glUseProgram(lightingShaderID);
+            cgcc::bindClusters(clusterGrid, lightingShaderID);
+        }
+
+        if (deferredActive) {
+            if (gBuffer.width != width || gBuffer.height != height) {
+                cgcc::GPUMemoryTag memoryTag("G-buffer");
+                cgcc::initGBuffer(gBuffer, width, height);
+            }
+            cgcc::beginGeometryPass(gBuffer);
+        }
+
+        // Depth prepass: positions only, no color writes
+        if (prepassActive) {
+            cgcc::beginGpuPass(frameTimer, "prepass");
+            const PhongUniforms& prepassUniforms = prepassProgram.uniforms;
+            glUseProgram(prepassProgram.async.program);
+            glUniformMatrix4fv(prepassUniforms.view, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+            glUniformMatrix4fv(prepassUniforms.projection, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+            cgcc::beginDepthPrepass();
+            for (uint32_t i : drawOrder) {
+                glUniformMatrix4fv(prepassUniforms.model, 1, GL_FALSE, glm::value_ptr(modelMatrices[i]));
+                glBindVertexArray(models[i].positionVAO);
+                glDrawArrays(GL_TRIANGLES, 0, models[i].numVertices);
+            }
+            glBindVertexArray(0);
+            cgcc::beginEqualDepthPass();
+        }
+
+        cgcc::beginGpuPass(frameTimer, "opaque");
+        glUseProgram(activeShaderID);
+        for (uint32_t i : drawOrder) {
+            glUniformMatrix4fv(u.model, 1, GL_FALSE, glm::value_ptr(modelMatrices[i]));
+            if (occlusionCulling) {
+                cgcc::hiZDrawInstance(hiZCuller, hiZInstances, i);
+                continue;
+            }
             glBindVertexArray(models[i].VAO);
             glDrawArrays(GL_TRIANGLES, 0, models[i].numVertices);
             glBindVertexArray(0);
         }
-        glfwSwapBuffers(window);
+        if (prepassActive)
+            cgcc::endEqualDepthPass();
+
+        // Deferred lighting: one fullscreen pass into the window framebuffer
+        if (deferredActive) {
+            cgcc::beginGpuPass(frameTimer, "lighting");
+            glUseProgram(lightingShaderID);
+            cgcc::drawLightingPass(gBuffer, lightingShaderID, projectionMatrix * viewMatrix);
+        }
+        // The overlay below is not part of the scene's calls
+        cgcc::endGLCallFrame();
+
+        // Timing overlay on top of the frame, min/avg/p99 and the GL calls in the title twice a second
+        if (frameTimer.overlay) {
+            cgcc::drawFrameTimerOverlay(frameTimer, width, height);
+            if (currentFrame - lastTitleUpdate > 0.5f) {
+                std::string title = cgcc::frameTimerSummary(frameTimer) + " | " + cgcc::glCallSummary(cgcc::lastGLCallFrame());
+                glfwSetWindowTitle(window, title.c_str());
+                lastTitleUpdate = currentFrame;
+            }
+        }
+        cgcc::endFrameTimer(frameTimer);
+        cgcc::endFrame(framePacer);
     }
     for (const auto& model : models) {
         glDeleteVertexArrays(1, &model.VAO);
+        glDeleteBuffers(1, &model.VBO);
+        glDeleteVertexArrays(1, &model.positionVAO);
+        glDeleteBuffers(1, &model.positionVBO);
     }
+    if (hiZCuller.prepassProgram != 0)
+        cgcc::destroyHiZCuller(hiZCuller);
+    if (clusterGrid.lightSSBO != 0)
+        cgcc::destroyClusterGrid(clusterGrid);
+    if (gBuffer.FBO != 0)
+        cgcc::destroyGBuffer(gBuffer);
+    cgcc::writeFrameTimerCSV(frameTimer, "frame_times.csv");
+    std::cout << cgcc::frameTimerSummary(frameTimer) << std::endl;
+    cgcc::destroyFrameTimer(frameTimer);
+    std::cout << "Last frame: " << cgcc::glCallSummary(cgcc::lastGLCallFrame()) << std::endl;
+    for (PhongProgram* program : { &forwardProgram, &clusteredProgram, &gBufferProgram, &deferredProgram, &deferredClusteredProgram, &prepassProgram, &fallbackProgram })
+        cgcc::destroyAsyncProgram(program->async);
+    CGCC_TRACE_WRITE("trace.json");
+    // Anything still allocated here is a leak
+    cgcc::reportGPUMemory(std::cout);
+    cgcc::writeGPUMemoryCSV("gpu_memory.csv");
+    cgcc::removeGPUMemoryTracker();
+    cgcc::removeGLCallCounters();
+    CGCC_ALLOC_REPORT(std::cout);
     glfwTerminate();
     return 0;
 }
@@ -502,6 +665,61 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     if (key == GLFW_KEY_LEFT_BRACKET) isScalingDown = (action != GLFW_RELEASE);
     if (key == GLFW_KEY_RIGHT_BRACKET) isScalingUp = (action != GLFW_RELEASE);
 
+    // Toggle GPU occlusion culling on 'O' press
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        occlusionCulling = !occlusionCulling;
+        std::cout << "Occlusion culling: " << (occlusionCulling ? (cgcc::glCaps.compute ? "ON (Hi-Z compute)" : "ON (occlusion queries)") : "OFF") << std::endl;
+    }
+
+    // Toggle clustered lighting on 'L' press (needs OpenGL 4.3)
+    if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        if (cgcc::glCaps.storageBuffers)
+            clusteredLighting = !clusteredLighting;
+        std::cout << "Clustered lighting: " << (clusteredLighting ? "ON" : "OFF") << " (" << pointLights.size() << " lights)" << std::endl;
+    }
+
+    // Toggle the depth prepass on 'P' press
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        depthPrepass = !depthPrepass;
+        std::cout << "Depth prepass: " << (depthPrepass ? "ON" : "OFF") << std::endl;
+    }
+
+    // Toggle deferred shading on 'G' press
+    if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+        deferredShading = !deferredShading;
+        std::cout << "Deferred shading: " << (deferredShading ? "ON" : "OFF") << std::endl;
+    }
+
+    // Toggle the frame timing overlay on 'T' press (numbers in the window title)
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        frameTimer.overlay = !frameTimer.overlay;
+        if (!frameTimer.overlay)
+            glfwSetWindowTitle(window, windowTitle);
+        std::cout << "Frame timing overlay: " << (frameTimer.overlay ? "ON" : "OFF") << std::endl;
+    }
+
+    // Log the GL call counts of every frame to gl_calls.csv on 'C' press
+    if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+        static bool logging = false;
+        logging = !logging;
+        if (logging)
+            cgcc::openGLCallLog("gl_calls.csv");
+        else
+            cgcc::closeGLCallLog();
+        std::cout << "GL call log: " << (logging ? "ON (gl_calls.csv)" : "OFF") << std::endl;
+    }
+
+    // Spawn more random point lights on 'K' press
+    if (key == GLFW_KEY_K && action == GLFW_PRESS) {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (size_t i = 0; i < lightsPerSpawn; ++i) {
+            glm::vec3 position((float)dis(gen), (float)dis(gen), (float)dis(gen));
+            glm::vec3 color(unit(gen), unit(gen), unit(gen));
+            pointLights.push_back({ position, 1.0f + unit(gen), color, 0.5f });
+        }
+        std::cout << "Point lights: " << pointLights.size() << (clusteredLighting ? "" : " (press L to use them)") << std::endl;
+    }
+
     // Select next model on 'M' press
     // if (key == GLFW_KEY_M && action == GLFW_PRESS) { // Remove this block
     //     selectedModelIndex = (selectedModelIndex + 1) % models.size();
@@ -515,6 +733,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
     {
+        cgcc::beginCpuSection(frameTimer, "picking");
         double xpos, ypos;
         glfwGetCursorPos(window, &xpos, &ypos);
 
@@ -546,11 +765,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 
         for (size_t i = 0; i < models.size(); ++i)
         {
-            glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), models[i].position);
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(models[i].rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(models[i].rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(models[i].rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-            modelMatrix = glm::scale(modelMatrix, glm::vec3(models[i].scale));
+            glm::mat4 modelMatrix = cgcc::composeModelMatrix(models[i].position, models[i].rotation, glm::vec3(models[i].scale));
 
             glm::mat4 inverseModelMatrix = glm::inverse(modelMatrix);
 
@@ -565,7 +780,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
                 glm::vec3 v2 = models[i].vertices[j + 2];
 
                 float distance;
-                if (intersectTriangle(localRayOrigin, localRayDir, v0, v1, v2, distance))
+                if (cgcc::intersectTriangle(localRayOrigin, localRayDir, v0, v1, v2, distance))
                 {
                     if (distance < closestDistance)
                     {
@@ -576,6 +791,8 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
             }
         }
 
+        cgcc::endCpuSection(frameTimer, "picking");
+
         if (intersectedModelIndex != -1)
         {
             selectedModelIndex = intersectedModelIndex;
@@ -584,49 +801,46 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
     }
 }
 
-// This function is quite hardcoded - objective is to compile and build a simple and unique shader program in this code example
-// The vertex and fragment shader source code is in the vertexShaderSource and fragmentShader source arrays at the beginning of this file
-// The function returns the shader program identifier
-int setupShader()
+// Starts compiling every program from the files in assets/shaders. Nothing here waits
+// on the driver: the programs become ready over the next frames (pollShaders) and
+// are relinked whenever one of their files is edited
+void setupShaders()
 {
-    // Vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    // Check for compilation errors (display via log in the terminal)
-    GLint success;
-    GLchar infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    // Fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    // Check for compilation errors (display via log in the terminal)
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)	{
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    using cgcc::ShaderStageSource;
+    ShaderStageSource phongVertex = { GL_VERTEX_SHADER, "", shaderDir + "phong.vert" };
+
+    std::string forwardDefines = cgcc::permutationDefines(forwardPermutation);
+    cgcc::beginAsyncProgram(forwardProgram.async, { phongVertex,
+        { GL_FRAGMENT_SHADER, "#version 450\n" + forwardDefines, shaderDir + "phong.frag" } });
+    // G-buffer pass of the deferred path; the lighting pass draws a fullscreen triangle
+    cgcc::beginAsyncProgram(gBufferProgram.async, { phongVertex,
+        { GL_FRAGMENT_SHADER, std::string("#version 450\n") + cgcc::gBufferOutputGLSL, shaderDir + "gbuffer.frag" } });
+    cgcc::beginAsyncProgram(deferredProgram.async, { { GL_VERTEX_SHADER, cgcc::fullscreenVertexShaderSource, "" },
+        { GL_FRAGMENT_SHADER, std::string("#version 450\n") + cgcc::gBufferInputGLSL, shaderDir + "deferred_lighting.frag" } });
+    // Depth prepass: same vertex shader, empty fragment shader
+    cgcc::beginAsyncProgram(prepassProgram.async, { phongVertex, { GL_FRAGMENT_SHADER, cgcc::depthOnlyFragmentShaderSource, "" } });
+
+    // Clustered variants need shader storage buffers (OpenGL 4.3)
+    if (cgcc::glCaps.storageBuffers) {
+        cgcc::beginAsyncProgram(clusteredProgram.async, { phongVertex,
+            { GL_FRAGMENT_SHADER, "#version 430\n" + forwardDefines + cgcc::clusteredLightingGLSL, shaderDir + "phong_clustered.frag" } });
+        cgcc::beginAsyncProgram(deferredClusteredProgram.async, { { GL_VERTEX_SHADER, cgcc::fullscreenVertexShaderSource, "" },
+            { GL_FRAGMENT_SHADER, std::string("#version 430\n#define CLUSTERED\n") + cgcc::clusteredLightingGLSL + cgcc::gBufferInputGLSL,
+              shaderDir + "deferred_lighting.frag" } });
     }
-    // Link shaders and create shader program identifier
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    // Check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
 
-    return shaderProgram;
+    fallbackProgram.async.program = cgcc::buildProgram(fallbackVertexShaderSource, fallbackFragmentShaderSource);
+    fallbackProgram.uniforms = getPhongUniforms(fallbackProgram.async.program);
+}
+
+// Finishes the programs that are done compiling and picks up edited files
+void pollShaders(double now)
+{
+    PhongProgram* programs[] = { &forwardProgram, &clusteredProgram, &gBufferProgram, &deferredProgram, &deferredClusteredProgram, &prepassProgram };
+    for (PhongProgram* program : programs) {
+        if (cgcc::pollAsyncProgram(program->async, now))
+            program->uniforms = getPhongUniforms(program->async.program);
+    }
 }
 
 // This function is quite hardcoded - objective is to create the buffers that store the
@@ -687,13 +901,10 @@ int setupGeometry()
     // Size in bytes
     // Offset from byte zero
     
-    // Position attribute (x, y, z)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(0);
-
-    // Color attribute (r, g, b)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3*sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
+    // Here they come from the PositionColor layout: position attribute (x, y, z)
+    // at location 0, color attribute (r, g, b) at location 1
+    static_assert(PositionColor::floats == 6, "the array above is x, y, z, r, g, b");
+    cgcc::setupVertexAttributes<PositionColor>();
 
 
     // Note that this is allowed, the call to glVertexAttribPointer registered the VBO as the currently
@@ -0,0 +1,20 @@
+/* BenchNoise.h - the deterministic noise the benchmarks place things with
+ *
+ * cgcc_bench and cgcc_microbench scatter positions, rotations, rays and
+ * lights with it, so every run and every machine sees the same inputs.
+ */
+
+#ifndef CGCC_BENCHNOISE_H
+#define CGCC_BENCHNOISE_H
+
+#include <cstdint>
+
+// Deterministic value in [0, 1) for index i of sequence k (a PCG-style hash)
+inline float benchNoise(int i, int k)
+{
+    uint32_t h = (uint32_t)i * 747796405u + (uint32_t)k * 2891336453u;
+    h = ((h >> ((h >> 28) + 4)) ^ h) * 277803737u;
+    return ((h >> 22) ^ h) / 4294967296.0f;
+}
+
+#endif // CGCC_BENCHNOISE_H
@@ -0,0 +1,312 @@
+/* GoldenCheck - the sample scenes against stored images, and within their frame budget
+ *
+ * Runs each example headless (Common/glfw_headless.cpp: fixed clock, fixed
+ * number of frames, no input but the keys given) so it stops on the same
+ * frame every time, and compares the last frame with a PNG in assets/golden.
+ * The comparison is perceptual: each pixel's color difference is measured in
+ * CIELAB (delta E 1976, where about 2.3 is the smallest difference people
+ * notice), against the closest of the golden's pixels around it so that a
+ * one-pixel shift of an edge is not a change. A scene fails when more than
+ * --max-bad of its pixels differ by more than --delta-e.
+ *
+ * The fast paths (the depth prepass, and AV2's deferred shading, occlusion
+ * culling and clustered lighting) are switched on with their keys and, but
+ * for AV2's prepass (see below), compared with the same golden as the plain
+ * path: they must not change the image.
+ *
+ * Textures are always loaded from their PNGs (CGCC_IGNORE_KTX2, see
+ * TextureStreamer.h): SpherePhong_textured's golden is the 8-bit palette path,
+ * which a pixelWall.ktx2 left by the compress_textures target would replace.
+ *
+ * Each scene also has a frame budget: the average frame time after the first
+ * frame, as printed by the headless backend, must stay under it. The budgets
+ * leave room on llvmpipe at the examples' window sizes; --budget-scale
+ * tightens them for a GPU or loosens them for a slower machine.
+ *
+ * Usage (from the build directory, configured with -DCGCC_HEADLESS=ON):
+ *   cgcc_golden [--scene name]... [--golden ../assets/golden] [--out golden_out]
+ *               [--delta-e 3.0] [--max-bad 0.001] [--budget-scale 1.0] [--update]
+ *   --update writes the current frames as the goldens instead of comparing.
+ *   Failing scenes leave <scene>.png and <scene>_diff.png (the pixels over
+ *   the threshold in red) in the --out directory. The exit code is 1 if any
+ *   scene failed.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+struct GoldenScene {
+    std::string name;
+    std::string executable;  // relative to the build directory
+    std::string workingDir;  // where the example finds its assets
+    int frames;
+    std::string keys;        // CGCC_HEADLESS_KEYS
+    std::string golden;      // file in the golden directory
+    double budgetMs;         // average frame time after the first frame
+};
+
+static const std::vector<GoldenScene> goldenScenes = {
+    { "SpherePhong", "SpherePhong/SpherePhong", ".", 90, "", "SpherePhong.png", 40.0 },
+    { "SpherePhong_prepass", "SpherePhong/SpherePhong", ".", 90, "P", "SpherePhong.png", 40.0 },
+    // The wall texture streams in over the first frames; by 240 it is all there
+    { "SpherePhong_textured", "SpherePhong/SpherePhong", ".", 240, "T", "SpherePhong_textured.png", 40.0 },
+    { "TriangleTex", "TriangleTex/TriangleTex", ".", 60, "", "TriangleTex.png", 10.0 },
+    { "AV2", "Atividade Vivencial 2/Hello3D_AV2", "Atividade Vivencial 2", 60, "", "AV2.png", 75.0 },
+    // The two Suzannes start in the same place. Drawn with GL_LESS the first
+    // (red) one keeps the pixels; after a prepass both pass GL_EQUAL and the
+    // last (yellow) one does, so the prepass has its own golden
+    { "AV2_prepass", "Atividade Vivencial 2/Hello3D_AV2", "Atividade Vivencial 2", 60, "P", "AV2_prepass.png", 75.0 },
+    { "AV2_deferred", "Atividade Vivencial 2/Hello3D_AV2", "Atividade Vivencial 2", 60, "G", "AV2.png", 150.0 },
+    { "AV2_occlusion", "Atividade Vivencial 2/Hello3D_AV2", "Atividade Vivencial 2", 60, "O", "AV2.png", 120.0 },
+    { "AV2_clustered", "Atividade Vivencial 2/Hello3D_AV2", "Atividade Vivencial 2", 60, "L", "AV2.png", 75.0 },
+};
+
+struct Image {
+    int width = 0, height = 0;
+    std::vector<unsigned char> rgb;
+};
+
+// The binary PPM the headless backend captures
+static bool readPPM(const std::string& path, Image& image)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int maxValue = 0;
+    if (!(file >> magic >> image.width >> image.height >> maxValue) || magic != "P6" || maxValue != 255)
+        return false;
+    file.get();
+    image.rgb.resize((size_t)image.width * image.height * 3);
+    return (bool)file.read((char*)image.rgb.data(), (std::streamsize)image.rgb.size());
+}
+
+static bool readPNG(const std::string& path, Image& image)
+{
+    int channels;
+    stbi_uc* pixels = stbi_load(path.c_str(), &image.width, &image.height, &channels, 3);
+    if (!pixels)
+        return false;
+    image.rgb.assign(pixels, pixels + (size_t)image.width * image.height * 3);
+    stbi_image_free(pixels);
+    return true;
+}
+
+static bool writePNG(const std::string& path, const Image& image)
+{
+    if (stbi_write_png(path.c_str(), image.width, image.height, 3, image.rgb.data(), image.width * 3))
+        return true;
+    std::cout << "ERROR::GOLDEN::FILE_NOT_WRITTEN\n" << path << std::endl;
+    return false;
+}
+
+// sRGB (0-255) to CIELAB, D65 white
+static void toLab(const unsigned char* rgb, float* lab)
+{
+    float linear[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        float c = rgb[i] / 255.0f;
+        linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    float xyz[3] = {
+        (0.4124f * linear[0] + 0.3576f * linear[1] + 0.1805f * linear[2]) / 0.95047f,
+        0.2126f * linear[0] + 0.7152f * linear[1] + 0.0722f * linear[2],
+        (0.0193f * linear[0] + 0.1192f * linear[1] + 0.9505f * linear[2]) / 1.08883f,
+    };
+    for (float& t : xyz)
+        t = t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+    lab[0] = 116.0f * xyz[1] - 16.0f;
+    lab[1] = 500.0f * (xyz[0] - xyz[1]);
+    lab[2] = 200.0f * (xyz[1] - xyz[2]);
+}
+
+struct Comparison {
+    double badFraction = 0.0, meanDeltaE = 0.0, maxDeltaE = 0.0;
+    Image diff; // the frame darkened, with the pixels over the threshold in red
+};
+
+static Comparison compareImages(const Image& frame, const Image& golden, float deltaE)
+{
+    size_t pixels = (size_t)frame.width * frame.height;
+    std::vector<float> frameLab(pixels * 3), goldenLab(pixels * 3);
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        toLab(&frame.rgb[i * 3], &frameLab[i * 3]);
+        toLab(&golden.rgb[i * 3], &goldenLab[i * 3]);
+    }
+
+    Comparison result;
+    result.diff = frame;
+    size_t bad = 0;
+    for (int y = 0; y < frame.height; ++y)
+    {
+        for (int x = 0; x < frame.width; ++x)
+        {
+            size_t i = (size_t)y * frame.width + x;
+            const float* a = &frameLab[i * 3];
+            float closest = 1e30f;
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    int gx = std::clamp(x + dx, 0, frame.width - 1), gy = std::clamp(y + dy, 0, frame.height - 1);
+                    const float* b = &goldenLab[((size_t)gy * frame.width + gx) * 3];
+                    float d = std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+                    closest = std::min(closest, d);
+                }
+            }
+            result.meanDeltaE += closest;
+            result.maxDeltaE = std::max(result.maxDeltaE, (double)closest);
+            unsigned char* out = &result.diff.rgb[i * 3];
+            if (closest > deltaE)
+            {
+                ++bad;
+                out[0] = 255; out[1] = 0; out[2] = 0;
+            }
+            else
+            {
+                out[0] /= 4; out[1] /= 4; out[2] /= 4;
+            }
+        }
+    }
+    result.meanDeltaE /= pixels;
+    result.badFraction = (double)bad / pixels;
+    return result;
+}
+
+// Runs the example and returns its output; the last frame goes to capture
+static bool runScene(const GoldenScene& scene, const std::filesystem::path& build, const std::filesystem::path& capture, std::string& output)
+{
+    std::filesystem::path executable = build / scene.executable;
+    if (!std::filesystem::exists(executable))
+    {
+        std::cout << "ERROR::GOLDEN::EXECUTABLE_NOT_FOUND\n" << executable.string() << std::endl;
+        return false;
+    }
+    // CGCC_IGNORE_KTX2: the PNG path, whether or not compress_textures was built
+    std::string command = "cd \"" + (build / scene.workingDir).string() + "\" && CGCC_IGNORE_KTX2=1 CGCC_HEADLESS_FRAMES=" + std::to_string(scene.frames)
+        + " CGCC_HEADLESS_KEYS=\"" + scene.keys + "\" CGCC_HEADLESS_CAPTURE=\"" + capture.string() + "\" \""
+        + executable.string() + "\" 2>&1";
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe)
+        return false;
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), pipe))
+        output += buffer;
+    return pclose(pipe) == 0;
+}
+
+// "HEADLESS: N frames in X ms (Y ms/frame, Z ms/frame after the first)" -> Z
+static double steadyFrameMs(const std::string& output)
+{
+    size_t line = output.rfind("HEADLESS: ");
+    size_t comma = line == std::string::npos ? line : output.find(", ", line);
+    return comma == std::string::npos ? -1.0 : std::atof(output.c_str() + comma + 2);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> names;
+    std::string golden = "../assets/golden", out = "golden_out";
+    float deltaE = 3.0f;
+    double maxBad = 0.001, budgetScale = 1.0;
+    bool update = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--scene" && hasValue) names.push_back(argv[++i]);
+        else if (arg == "--golden" && hasValue) golden = argv[++i];
+        else if (arg == "--out" && hasValue) out = argv[++i];
+        else if (arg == "--delta-e" && hasValue) deltaE = (float)std::atof(argv[++i]);
+        else if (arg == "--max-bad" && hasValue) maxBad = std::atof(argv[++i]);
+        else if (arg == "--budget-scale" && hasValue) budgetScale = std::atof(argv[++i]);
+        else if (arg == "--update") update = true;
+        else
+        {
+            std::cout << "Usage: cgcc_golden [--scene name]... [--golden dir] [--out dir] [--delta-e 3.0]"
+                         " [--max-bad 0.001] [--budget-scale 1.0] [--update]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::filesystem::path build = std::filesystem::absolute(".");
+    std::filesystem::path outDir = std::filesystem::absolute(out);
+    std::filesystem::create_directories(outDir);
+    int failed = 0, checked = 0;
+    for (const GoldenScene& scene : goldenScenes)
+    {
+        if (!names.empty() && std::find(names.begin(), names.end(), scene.name) == names.end())
+            continue;
+        // Scenes sharing a golden are updated by the first of them
+        bool ownsGolden = std::find_if(goldenScenes.begin(), goldenScenes.end(), [&](const GoldenScene& other) {
+            return other.golden == scene.golden; })->name == scene.name;
+        if (update && !ownsGolden)
+            continue;
+        ++checked;
+        std::filesystem::path capture = outDir / (scene.name + ".ppm");
+        std::filesystem::remove(capture);
+        std::string output;
+        Image frame;
+        if (!runScene(scene, build, capture, output) || !readPPM(capture.string(), frame))
+        {
+            std::cout << scene.name << ": FAILED to run\n" << output << std::endl;
+            ++failed;
+            continue;
+        }
+        std::filesystem::remove(capture);
+        double frameMs = steadyFrameMs(output), budgetMs = scene.budgetMs * budgetScale;
+        std::string goldenPath = golden + "/" + scene.golden;
+
+        if (update)
+        {
+            if (writePNG(goldenPath, frame))
+                std::cout << scene.name << ": wrote " << goldenPath << " (" << frameMs << " ms/frame)" << std::endl;
+            continue;
+        }
+
+        Image reference;
+        if (!readPNG(goldenPath, reference))
+        {
+            std::cout << scene.name << ": FAILED, no golden at " << goldenPath << " (write it with --update)" << std::endl;
+            ++failed;
+            continue;
+        }
+        bool sameSize = reference.width == frame.width && reference.height == frame.height;
+        Comparison comparison;
+        if (sameSize)
+            comparison = compareImages(frame, reference, deltaE);
+        bool imageOk = sameSize && comparison.badFraction <= maxBad;
+        bool timeOk = frameMs >= 0.0 && frameMs <= budgetMs;
+
+        std::cout << scene.name << ": " << (imageOk && timeOk ? "ok" : "FAILED");
+        if (sameSize)
+            std::cout << "  image " << comparison.badFraction * 100.0 << "% over dE " << deltaE << " (mean " << comparison.meanDeltaE
+                      << ", max " << comparison.maxDeltaE << ")";
+        else
+            std::cout << "  image " << frame.width << "x" << frame.height << ", golden " << reference.width << "x" << reference.height;
+        std::cout << "  " << frameMs << " ms/frame (budget " << budgetMs << ")" << std::endl;
+        if (!imageOk)
+        {
+            writePNG((outDir / (scene.name + ".png")).string(), frame);
+            if (sameSize)
+                writePNG((outDir / (scene.name + "_diff.png")).string(), comparison.diff);
+        }
+        if (!imageOk || !timeOk)
+            ++failed;
+    }
+    if (!update)
+        std::cout << checked - failed << " of " << checked << " scenes passed" << std::endl;
+    return failed ? 1 : 0;
+}
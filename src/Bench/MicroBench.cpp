@@ -0,0 +1,378 @@
+/* MicroBench - the CPU kernels of the examples, measured one at a time
+ *
+ * Runs each kernel on bundled and generated inputs, repeating it until both
+ * a minimum number of repetitions and a minimum time are reached, and reports
+ * the median, the fastest run and the spread, with the throughput of the
+ * median run:
+ *
+ *   obj_parse       cgcc::parseSimpleOBJ (loadSimpleOBJ without the GL upload)
+ *                   on Cube, Suzanne, SuzanneSubdiv1 and a generated grid of
+ *                   --big-triangles triangles: MB/s and triangles/s
+ *   sphere          cgcc::generateUVSphere / generateIcosphere: triangles/s
+ *   ray_pick        a ray against every triangle of a model, closest hit, as
+ *                   the Atividade Vivencial click does (cgcc::intersectTriangle):
+ *                   rays/s
+ *   model_matrix    cgcc::composeModelMatrix, the per-model matrix of the AV2
+ *                   loop: matrices/s
+ *   texture_decode  stb_image on the bundled PNGs, from memory: MB/s of file
+ *                   and pixels/s
+ *
+ * Usage: cgcc_microbench [--filter text] [--min-reps N] [--min-time s]
+ *                        [--big-triangles N] [--assets dir] [--out microbench.json]
+ *   --filter runs only the kernels whose name contains the text. The
+ *   generated OBJ (10M triangles by default, several hundred MB) is written
+ *   once into the working directory and reused; --big-triangles 0 skips it.
+ *
+ * No window or GL context is needed.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <glm/glm.hpp>
+
+#include <cgcc/OBJLoader.h>
+#include <cgcc/Picking.h>
+#include <cgcc/Primitives.h>
+
+#include "BenchNoise.h"
+
+// The AV2 OBJ vertex: float position, 8-bit color, 10-bit normal
+using ObjVertex = cgcc::VertexLayout<
+    cgcc::VertexAttrib<cgcc::VertexAttribute::Position>,
+    cgcc::VertexAttrib<cgcc::VertexAttribute::Color, cgcc::VertexFormat::UNorm8x3>,
+    cgcc::VertexAttrib<cgcc::VertexAttribute::Normal, cgcc::VertexFormat::SNorm10x3>>;
+// Positions only: a triangle soup of glm::vec3
+using PositionOnly = cgcc::VertexLayout<cgcc::VertexAttrib<cgcc::VertexAttribute::Position>>;
+
+struct MicroOptions {
+    std::string filter;
+    int minReps = 5;
+    double minTime = 1.0;
+    int maxReps = 1000;
+    long long bigTriangles = 10000000;
+    std::string assets = "../assets";
+};
+
+struct MicroResult {
+    std::string kernel, input;
+    int reps = 0;
+    double medianMs = 0.0, minMs = 0.0, spread = 0.0; // spread: stddev / mean
+    double work = 0.0;       // units per run
+    std::string unit;        // "tris", "rays", ...
+    double bytes = 0.0;      // bytes read per run, 0 if not meaningful
+};
+
+// Results of the kernels go here so the compiler cannot drop them
+static volatile uint64_t benchSink = 0;
+
+// One warm-up run, then repetitions until minReps and minTime are both reached
+static MicroResult measure(const MicroOptions& options, const std::string& kernel, const std::string& input,
+                           double work, const std::string& unit, double bytes, const std::function<void()>& run)
+{
+    run();
+    std::vector<double> times;
+    double total = 0.0;
+    while ((int)times.size() < options.maxReps && ((int)times.size() < options.minReps || total < options.minTime * 1000.0))
+    {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        times.push_back(ms);
+        total += ms;
+    }
+    MicroResult result;
+    result.kernel = kernel;
+    result.input = input;
+    result.reps = (int)times.size();
+    result.work = work;
+    result.unit = unit;
+    result.bytes = bytes;
+    double mean = total / times.size(), variance = 0.0;
+    for (double ms : times)
+        variance += (ms - mean) * (ms - mean);
+    result.spread = times.size() > 1 ? std::sqrt(variance / (times.size() - 1)) / mean : 0.0;
+    std::sort(times.begin(), times.end());
+    result.minMs = times.front();
+    result.medianMs = times[times.size() / 2];
+    return result;
+}
+
+static void printResult(const MicroResult& r)
+{
+    double seconds = r.medianMs * 1e-3;
+    std::cout << std::left << std::setw(15) << r.kernel << std::setw(24) << r.input << std::right << std::fixed
+              << std::setprecision(3) << std::setw(11) << r.medianMs << " ms (min " << r.minMs << ", +-"
+              << std::setprecision(1) << r.spread * 100.0 << "%, " << r.reps << " runs)  "
+              << std::setprecision(2);
+    double rate = r.work / seconds;
+    if (rate >= 1e6)
+        std::cout << rate / 1e6 << " M" << r.unit << "/s";
+    else
+        std::cout << rate / 1e3 << " k" << r.unit << "/s";
+    if (r.bytes > 0.0)
+        std::cout << "  " << r.bytes / seconds / (1024.0 * 1024.0) << " MB/s";
+    std::cout << std::endl;
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& bytes)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static double fileSize(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? (double)file.tellg() : 0.0;
+}
+
+// A square grid of quads in the xz plane with normals and texture
+// coordinates, two triangles per quad, in the format the exporter writes
+static bool writeGridOBJ(const std::string& path, long long triangles)
+{
+    std::ofstream file(path);
+    if (!file)
+        return false;
+    long long side = std::max(1LL, (long long)std::ceil(std::sqrt(triangles / 2.0)));
+    long long quads = (triangles + 1) / 2;
+    file << std::fixed << std::setprecision(6);
+    for (long long z = 0; z <= side; ++z)
+        for (long long x = 0; x <= side; ++x)
+            file << "v " << (double)x / side << " " << 0.01 * std::sin(x * 0.1) << " " << (double)z / side << "\n";
+    for (long long z = 0; z <= side; ++z)
+        for (long long x = 0; x <= side; ++x)
+            file << "vt " << (double)x / side << " " << (double)z / side << "\n";
+    file << "vn 0.000000 1.000000 0.000000\n";
+    for (long long q = 0; q < quads; ++q)
+    {
+        long long x = q % side, z = q / side;
+        long long a = z * (side + 1) + x + 1, b = a + 1, c = a + side + 1, d = c + 1;
+        file << "f " << a << "/" << a << "/1 " << c << "/" << c << "/1 " << b << "/" << b << "/1\n";
+        if (2 * q + 1 < triangles)
+            file << "f " << b << "/" << b << "/1 " << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+    }
+    return true;
+}
+
+static void benchOBJParse(const MicroOptions& options, std::vector<MicroResult>& results)
+{
+    std::vector<std::pair<std::string, std::string>> inputs = {
+        { "Cube", options.assets + "/Modelos3D/Cube.obj" },
+        { "Suzanne", options.assets + "/Modelos3D/Suzanne.obj" },
+        { "SuzanneSubdiv1", options.assets + "/Modelos3D/SuzanneSubdiv1.obj" },
+    };
+    if (options.bigTriangles > 0)
+    {
+        std::string path = "microbench_grid_" + std::to_string(options.bigTriangles) + ".obj";
+        if (fileSize(path) == 0.0)
+        {
+            std::cout << "Writing " << path << "..." << std::endl;
+            if (!writeGridOBJ(path, options.bigTriangles))
+                std::cout << "ERROR::MICROBENCH::FILE_NOT_WRITTEN\n" << path << std::endl;
+        }
+        inputs.push_back({ "grid " + std::to_string(options.bigTriangles), path });
+    }
+    for (const auto& input : inputs)
+    {
+        double bytes = fileSize(input.second);
+        cgcc::PackedVertices<ObjVertex> vBuffer;
+        std::vector<glm::vec3> positions;
+        if (bytes == 0.0 || !cgcc::parseSimpleOBJ(input.second, glm::vec3(1.0f, 0.0f, 0.0f), vBuffer, positions))
+            continue;
+        double triangles = vBuffer.count() / 3.0;
+        results.push_back(measure(options, "obj_parse", input.first, triangles, "tris", bytes, [&]() {
+            cgcc::PackedVertices<ObjVertex> out;
+            std::vector<glm::vec3> outPositions;
+            cgcc::parseSimpleOBJ(input.second, glm::vec3(1.0f, 0.0f, 0.0f), out, outPositions);
+            benchSink += out.size();
+        }));
+        printResult(results.back());
+    }
+}
+
+static void benchSphere(const MicroOptions& options, std::vector<MicroResult>& results)
+{
+    for (int lat : { 16, 64, 256 })
+    {
+        int lon = lat * 2;
+        double triangles = cgcc::generateUVSphere(1.0f, lat, lon).indices.size() / 3.0;
+        results.push_back(measure(options, "sphere", "uv " + std::to_string(lat) + "x" + std::to_string(lon), triangles, "tris", 0.0, [&]() {
+            benchSink += cgcc::generateUVSphere(1.0f, lat, lon).indices.size();
+        }));
+        printResult(results.back());
+    }
+    for (int subdivisions : { 3, 5 })
+    {
+        double triangles = cgcc::generateIcosphere(1.0f, subdivisions).indices.size() / 3.0;
+        results.push_back(measure(options, "sphere", "ico " + std::to_string(subdivisions), triangles, "tris", 0.0, [&]() {
+            benchSink += cgcc::generateIcosphere(1.0f, subdivisions).indices.size();
+        }));
+        printResult(results.back());
+    }
+}
+
+static void benchRayPick(const MicroOptions& options, std::vector<MicroResult>& results)
+{
+    const int rayCount = 256;
+    for (const char* model : { "Suzanne", "SuzanneSubdiv1" })
+    {
+        cgcc::PackedVertices<PositionOnly> soup;
+        std::vector<glm::vec3> positions;
+        if (!cgcc::parseSimpleOBJ(options.assets + "/Modelos3D/" + model + ".obj", glm::vec3(1.0f), soup, positions))
+            continue;
+        const glm::vec3* triangles = (const glm::vec3*)soup.data();
+        size_t corners = soup.count() - soup.count() % 3;
+
+        // Rays from a sphere around the model towards points inside its bounds
+        // (about half of them hit)
+        std::vector<glm::vec3> origins, directions;
+        for (int i = 0; i < rayCount; ++i)
+        {
+            float theta = 6.2831853f * benchNoise(i, 1), y = 2.0f * benchNoise(i, 2) - 1.0f;
+            float r = std::sqrt(1.0f - y * y);
+            glm::vec3 origin = 5.0f * glm::vec3(r * std::cos(theta), y, r * std::sin(theta));
+            glm::vec3 target = glm::vec3(benchNoise(i, 3), benchNoise(i, 4), benchNoise(i, 5)) * 2.0f - 1.0f;
+            origins.push_back(origin);
+            directions.push_back(glm::normalize(target - origin));
+        }
+        results.push_back(measure(options, "ray_pick", model, rayCount, "rays", 0.0, [&]() {
+            uint64_t hits = 0;
+            for (int i = 0; i < rayCount; ++i)
+            {
+                float closest = 1e30f;
+                for (size_t j = 0; j < corners; j += 3)
+                {
+                    float distance;
+                    if (cgcc::intersectTriangle(origins[i], directions[i], triangles[j], triangles[j + 1], triangles[j + 2], distance) && distance < closest)
+                        closest = distance;
+                }
+                hits += closest < 1e30f;
+            }
+            benchSink += hits;
+        }));
+        printResult(results.back());
+    }
+}
+
+static void benchModelMatrix(const MicroOptions& options, std::vector<MicroResult>& results)
+{
+    const int count = 100000;
+    std::vector<glm::vec3> positions(count), rotations(count), scales(count);
+    for (int i = 0; i < count; ++i)
+    {
+        positions[i] = glm::vec3(benchNoise(i, 1), benchNoise(i, 2), benchNoise(i, 3)) * 10.0f;
+        rotations[i] = glm::vec3(benchNoise(i, 4), benchNoise(i, 5), benchNoise(i, 6)) * 360.0f;
+        scales[i] = glm::vec3(0.5f + benchNoise(i, 7));
+    }
+    std::vector<glm::mat4> matrices(count);
+    results.push_back(measure(options, "model_matrix", "100k transforms", count, "matrices", 0.0, [&]() {
+        for (int i = 0; i < count; ++i)
+            matrices[i] = cgcc::composeModelMatrix(positions[i], rotations[i], scales[i]);
+        benchSink += (uint64_t)matrices[count / 2][3][0];
+    }));
+    printResult(results.back());
+}
+
+static void benchTextureDecode(const MicroOptions& options, std::vector<MicroResult>& results)
+{
+    for (const char* image : { "tex/pixelWall.png", "Modelos3D/Suzanne.png", "Modelos3D/SuzanneUV.png" })
+    {
+        std::vector<unsigned char> file;
+        if (!readFile(options.assets + "/" + image, file))
+            continue;
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &channels, 4);
+        if (!pixels)
+            continue;
+        stbi_image_free(pixels);
+        std::string name = image;
+        results.push_back(measure(options, "texture_decode", name.substr(name.find('/') + 1), (double)width * height, "pixels", (double)file.size(), [&]() {
+            int w, h, c;
+            stbi_uc* decoded = stbi_load_from_memory(file.data(), (int)file.size(), &w, &h, &c, 4);
+            benchSink += decoded ? decoded[0] : 0;
+            stbi_image_free(decoded);
+        }));
+        printResult(results.back());
+    }
+}
+
+// One kernel/input per line, like cgcc_bench's bench.json
+static bool writeResults(const std::string& path, const std::vector<MicroResult>& results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::MICROBENCH::FILE_NOT_WRITTEN\n" << path << std::endl;
+        return false;
+    }
+    file << "{\n  \"kernels\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const MicroResult& r = results[i];
+        double seconds = r.medianMs * 1e-3;
+        file << "    {\"kernel\": \"" << r.kernel << "\", \"input\": \"" << r.input << "\", \"reps\": " << r.reps
+             << ", \"median_ms\": " << r.medianMs << ", \"min_ms\": " << r.minMs << ", \"spread\": " << r.spread
+             << ", \"" << r.unit << "_per_sec\": " << r.work / seconds;
+        if (r.bytes > 0.0)
+            file << ", \"mb_per_sec\": " << r.bytes / seconds / (1024.0 * 1024.0);
+        file << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    MicroOptions options;
+    std::string out;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--min-reps" && hasValue) options.minReps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--min-time" && hasValue) options.minTime = std::atof(argv[++i]);
+        else if (arg == "--big-triangles" && hasValue) options.bigTriangles = std::atoll(argv[++i]);
+        else if (arg == "--assets" && hasValue) options.assets = argv[++i];
+        else if (arg == "--out" && hasValue) out = argv[++i];
+        else
+        {
+            std::cout << "Usage: cgcc_microbench [--filter text] [--min-reps N] [--min-time s] [--big-triangles N]"
+                         " [--assets dir] [--out microbench.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::vector<std::pair<std::string, std::function<void(const MicroOptions&, std::vector<MicroResult>&)>>> kernels = {
+        { "obj_parse", benchOBJParse },
+        { "sphere", benchSphere },
+        { "ray_pick", benchRayPick },
+        { "model_matrix", benchModelMatrix },
+        { "texture_decode", benchTextureDecode },
+    };
+    std::vector<MicroResult> results;
+    for (const auto& kernel : kernels)
+    {
+        if (kernel.first.find(options.filter) != std::string::npos)
+            kernel.second(options, results);
+    }
+    if (!out.empty())
+        writeResults(out, results);
+    return 0;
+}
@@ -0,0 +1,701 @@
+/* SceneBench - stress scenes that show whether a rendering change is faster
+ *
+ * Draws each scene for a fixed number of frames with vsync off and reports,
+ * per scene, the frame time (swap to swap: min, p50, p95, p99, average), the
+ * GPU time of the scene pass, draw calls and triangles per frame, and
+ * triangles per second. The results are written as JSON.
+ *
+ * Usage: cgcc_bench [--scene kind:count[:lights]]... [--frames N] [--warmup N]
+ *                   [--size WxH] [--assets dir] [--out bench.json]
+ *                   [--baseline old.json] [--tolerance 0.10]
+ *   cubes:N      N Tarefa 2 cubes, one draw call each, every cube turning
+ *   suzanne:N:L  N Suzannes lit by L orbiting point lights (clustered
+ *                forward shading, cgcc/ClusteredLighting.h; GL 4.3)
+ *   sprites:N    N blended textured quads from a texture array, one draw each
+ *   Without --scene the default suite runs (see defaultSuite below).
+ *
+ * --baseline compares the run with an earlier bench.json. A scene regresses
+ * when its p50 or p99 frame time or its draw calls grow, or its triangles per
+ * second drop, by more than the tolerance (a fraction). The comparison is
+ * printed and the exit code is 1 if any scene regressed. Compare only runs
+ * from the same machine and renderer; the renderer is stored in the file.
+ *
+ * The animation advances a fixed step per frame, so every run draws the same
+ * frames. Configured with CGCC_HEADLESS the bench runs without a display on
+ * llvmpipe (Common/glfw_headless.cpp), built without its frame limit, so no
+ * frame is slowed down by the backend's end-of-run glFinish.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <cgcc/GLExt.h>
+#include <cgcc/Shader.h>
+#include <cgcc/StaticGeometry.h>
+#include <cgcc/ClusteredLighting.h>
+#include <cgcc/TextureArray.h>
+#include <cgcc/FrameTimer.h>
+#include <cgcc/GLCallCounters.h>
+
+#include "BenchNoise.h"
+
+struct BenchScene {
+    std::string kind;
+    int count = 0;
+    int lights = 0;
+};
+
+struct BenchResult {
+    std::string name;
+    int frames = 0;
+    double frameMin = 0.0, frameP50 = 0.0, frameP95 = 0.0, frameP99 = 0.0, frameAvg = 0.0;
+    double gpuAvg = 0.0;
+    double drawsPerFrame = 0.0, trianglesPerFrame = 0.0, trianglesPerSecond = 0.0;
+};
+
+// GL objects of the scene being measured
+struct SceneState {
+    GLuint program = 0;
+    GLuint VAO = 0, VBO = 0, EBO = 0;
+    GLsizei indexCount = 0, vertexCount = 0;
+    cgcc::TextureArray textures;
+    cgcc::ClusterGrid clusters;
+    std::vector<cgcc::PointLight> lights;
+    std::vector<glm::vec3> positions;
+    glm::mat4 view = glm::mat4(1.0f), projection = glm::mat4(1.0f);
+    float aspect = 1.0f;
+    GLint modelLoc = -1, viewProjectionLoc = -1, viewLoc = -1, layerLoc = -1;
+};
+
+static const std::vector<BenchScene> defaultSuite = {
+    { "cubes", 100 }, { "cubes", 1000 }, { "cubes", 10000 },
+    { "suzanne", 16, 3 }, { "suzanne", 16, 100 }, { "suzanne", 16, 1000 },
+    { "sprites", 1000 }, { "sprites", 10000 },
+};
+
+static const double animationStep = 1.0 / 60.0; // seconds of animation per frame
+
+static std::string sceneName(const BenchScene& scene)
+{
+    std::string name = scene.kind + ":" + std::to_string(scene.count);
+    if (scene.kind == "suzanne")
+        name += ":" + std::to_string(scene.lights);
+    return name;
+}
+
+static bool parseScene(const std::string& text, BenchScene& scene)
+{
+    std::istringstream in(text);
+    std::string count, lights;
+    std::getline(in, scene.kind, ':');
+    std::getline(in, count, ':');
+    std::getline(in, lights, ':');
+    scene.count = std::atoi(count.c_str());
+    scene.lights = lights.empty() ? 3 : std::atoi(lights.c_str());
+    bool known = scene.kind == "cubes" || scene.kind == "suzanne" || scene.kind == "sprites";
+    return known && scene.count > 0 && scene.lights > 0;
+}
+
+// ---------------------------------------------------------------------------
+// Scenes
+// ---------------------------------------------------------------------------
+
+using PositionColor = cgcc::VertexLayout<cgcc::VertexAttrib<cgcc::VertexAttribute::Position>, cgcc::VertexAttrib<cgcc::VertexAttribute::Color>>;
+constexpr auto cubeSoup = cgcc::cubeGeometry(1.0f, { { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 1, 1, 0 }, { 1, 0, 1 }, { 0, 1, 1 } } });
+static constexpr auto cubeMesh = cgcc::indexGeometry<PositionColor, cgcc::uniqueVertexCount<PositionColor>(cubeSoup)>(cubeSoup);
+
+static const GLchar* cubeVertexShader = R"(#version 410
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+uniform mat4 viewProjection;
+uniform mat4 model;
+out vec3 vertexColor;
+void main()
+{
+    gl_Position = viewProjection * model * vec4(position, 1.0);
+    vertexColor = color;
+}
+)";
+
+static const GLchar* cubeFragmentShader = R"(#version 410
+in vec3 vertexColor;
+out vec4 color;
+void main()
+{
+    color = vec4(vertexColor, 1.0);
+}
+)";
+
+static const GLchar* suzanneVertexShader = R"(#version 430
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+uniform mat4 viewProjection;
+uniform mat4 view;
+uniform mat4 model;
+out vec3 worldPosition;
+out vec3 worldNormal;
+out float viewDepth;
+void main()
+{
+    vec4 world = model * vec4(position, 1.0);
+    worldPosition = world.xyz;
+    worldNormal = mat3(model) * normal;
+    viewDepth = -(view * world).z;
+    gl_Position = viewProjection * world;
+}
+)";
+
+static const GLchar* suzanneFragmentMain = R"(
+in vec3 worldPosition;
+in vec3 worldNormal;
+in float viewDepth;
+out vec4 color;
+void main()
+{
+    vec3 n = normalize(worldNormal);
+    vec3 albedo = vec3(0.8, 0.25, 0.2);
+    vec3 result = albedo * 0.05;
+    uvec2 range = clusterLightRange(viewDepth);
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        PointLight light = pointLights[lightIndices[range.x + i]];
+        vec3 toLight = light.position - worldPosition;
+        float dist = length(toLight);
+        float diffuse = max(dot(n, toLight / dist), 0.0);
+        result += albedo * light.color * light.intensity * diffuse * lightFalloff(dist, light.radius);
+    }
+    color = vec4(result, 1.0);
+}
+)";
+
+static const GLchar* spriteVertexShader = R"(#version 410
+layout (location = 0) in vec2 corner;
+uniform mat4 viewProjection;
+uniform mat4 model;
+out vec2 texCoord;
+void main()
+{
+    gl_Position = viewProjection * model * vec4(corner, 0.0, 1.0);
+    texCoord = corner + 0.5;
+}
+)";
+
+static const GLchar* spriteFragmentShader = R"(#version 410
+in vec2 texCoord;
+uniform sampler2DArray sprites;
+uniform float layer;
+out vec4 color;
+void main()
+{
+    color = vec4(texture(sprites, vec3(texCoord, layer)).rgb, 0.6);
+}
+)";
+
+// Positions and normals of an OBJ file, triangulated, for glDrawArrays
+static bool loadOBJPositionsNormals(const std::string& path, std::vector<GLfloat>& vertices)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "Failed to open " << path << std::endl;
+        return false;
+    }
+    std::vector<glm::vec3> positions, normals;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream in(line);
+        std::string word;
+        in >> word;
+        if (word == "v" || word == "vn")
+        {
+            glm::vec3 v;
+            in >> v.x >> v.y >> v.z;
+            (word == "v" ? positions : normals).push_back(v);
+        }
+        else if (word == "f")
+        {
+            std::vector<std::pair<int, int>> corners;
+            std::string token;
+            while (in >> token)
+            {
+                int p = std::atoi(token.c_str()), n = 0;
+                size_t last = token.rfind('/');
+                if (last != std::string::npos)
+                    n = std::atoi(token.c_str() + last + 1);
+                corners.push_back({ p - 1, n - 1 });
+            }
+            for (size_t i = 2; i < corners.size(); ++i)
+            {
+                for (size_t c : { (size_t)0, i - 1, i })
+                {
+                    glm::vec3 p = positions[corners[c].first];
+                    glm::vec3 n = corners[c].second >= 0 ? normals[corners[c].second] : glm::vec3(0.0f, 1.0f, 0.0f);
+                    vertices.insert(vertices.end(), { p.x, p.y, p.z, n.x, n.y, n.z });
+                }
+            }
+        }
+    }
+    return !vertices.empty();
+}
+
+static bool setupCubes(SceneState& state, int count)
+{
+    state.program = cgcc::buildProgram(cubeVertexShader, cubeFragmentShader);
+    glGenVertexArrays(1, &state.VAO);
+    glBindVertexArray(state.VAO);
+    glGenBuffers(1, &state.VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, state.VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeMesh.vertices), cubeMesh.vertices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &state.EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeMesh.indices), cubeMesh.indices.data(), GL_STATIC_DRAW);
+    cgcc::setupVertexAttributes<PositionColor>();
+    glBindVertexArray(0);
+    state.indexCount = (GLsizei)cubeMesh.indices.size();
+
+    // A cube of cubes, two units apart
+    int side = (int)std::ceil(std::cbrt((double)count));
+    for (int i = 0; i < count; ++i)
+    {
+        glm::vec3 cell((float)(i % side), (float)((i / side) % side), (float)(i / (side * side)));
+        state.positions.push_back((cell - (side - 1) * 0.5f) * 2.0f);
+    }
+    float distance = side * 3.0f + 3.0f;
+    state.view = glm::lookAt(glm::vec3(0.0f, side * 0.8f, distance), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    state.projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, distance * 3.0f);
+    return state.program != 0;
+}
+
+static bool setupSuzannes(SceneState& state, int count, int lightCount, const std::string& assets, int width, int height)
+{
+    if (!cgcc::glCaps.storageBuffers)
+    {
+        std::cout << "suzanne scenes need GL 4.3 storage buffers; skipped" << std::endl;
+        return false;
+    }
+    std::vector<GLfloat> vertices;
+    if (!loadOBJPositionsNormals(assets + "/Modelos3D/Suzanne.obj", vertices))
+        return false;
+    std::string fragment = std::string("#version 430\n") + cgcc::clusteredLightingGLSL + suzanneFragmentMain;
+    state.program = cgcc::buildProgram(suzanneVertexShader, fragment.c_str());
+    glGenVertexArrays(1, &state.VAO);
+    glBindVertexArray(state.VAO);
+    glGenBuffers(1, &state.VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, state.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    state.vertexCount = (GLsizei)(vertices.size() / 6);
+
+    // A square of Suzannes on the ground plane, seen from above and in front
+    int side = (int)std::ceil(std::sqrt((double)count));
+    float spacing = 2.5f;
+    for (int i = 0; i < count; ++i)
+        state.positions.push_back(glm::vec3((i % side - (side - 1) * 0.5f) * spacing, 0.0f, (i / side - (side - 1) * 0.5f) * spacing));
+    float extent = side * spacing;
+    float zFar = extent * 3.0f + 10.0f;
+    state.view = glm::lookAt(glm::vec3(0.0f, extent * 0.7f + 2.0f, extent * 0.9f + 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    state.projection = glm::perspective(glm::radians(45.0f), (float)width / height, 0.1f, zFar);
+    cgcc::initClusterGrid(state.clusters, width, height, state.projection, 0.1f, zFar);
+    for (int i = 0; i < lightCount; ++i)
+    {
+        cgcc::PointLight light;
+        light.radius = 2.0f + 3.0f * benchNoise(i, 4);
+        light.color = glm::vec3(0.3f + 0.7f * benchNoise(i, 5), 0.3f + 0.7f * benchNoise(i, 6), 0.3f + 0.7f * benchNoise(i, 7));
+        light.intensity = 1.0f;
+        state.lights.push_back(light);
+    }
+    return state.program != 0;
+}
+
+static bool setupSprites(SceneState& state, int count, const std::string& assets, int width, int height)
+{
+    if (!cgcc::buildTextureArray(state.textures, { assets + "/tex/pixelWall.png", assets + "/Modelos3D/Suzanne.png", assets + "/Modelos3D/SuzanneUV.png" }, 256, 256))
+        return false;
+    state.program = cgcc::buildProgram(spriteVertexShader, spriteFragmentShader);
+    const GLfloat corners[] = { -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f };
+    glGenVertexArrays(1, &state.VAO);
+    glBindVertexArray(state.VAO);
+    glGenBuffers(1, &state.VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, state.VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    state.vertexCount = 4;
+    for (int i = 0; i < count; ++i)
+        state.positions.push_back(glm::vec3(benchNoise(i, 1), benchNoise(i, 2), benchNoise(i, 3)));
+    // The window is the unit square, origin at the bottom left
+    state.projection = glm::ortho(0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f);
+    state.aspect = (float)width / height;
+    return state.program != 0;
+}
+
+static void destroyScene(SceneState& state)
+{
+    if (state.program) glDeleteProgram(state.program);
+    if (state.VAO) glDeleteVertexArrays(1, &state.VAO);
+    if (state.VBO) glDeleteBuffers(1, &state.VBO);
+    if (state.EBO) glDeleteBuffers(1, &state.EBO);
+    cgcc::destroyTextureArray(state.textures);
+    cgcc::destroyClusterGrid(state.clusters);
+    state = SceneState();
+}
+
+static void drawScene(SceneState& state, const BenchScene& scene, double time)
+{
+    glUseProgram(state.program);
+    glBindVertexArray(state.VAO);
+    glm::mat4 viewProjection = state.projection * state.view;
+    if (state.modelLoc < 0)
+    {
+        state.modelLoc = glGetUniformLocation(state.program, "model");
+        state.viewProjectionLoc = glGetUniformLocation(state.program, "viewProjection");
+        state.viewLoc = glGetUniformLocation(state.program, "view");
+        state.layerLoc = glGetUniformLocation(state.program, "layer");
+    }
+    glUniformMatrix4fv(state.viewProjectionLoc, 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+    if (scene.kind == "cubes")
+    {
+        for (size_t i = 0; i < state.positions.size(); ++i)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), state.positions[i]);
+            model = glm::rotate(model, (float)time + i * 0.1f, glm::vec3(0.3f, 1.0f, 0.2f));
+            model = glm::scale(model, glm::vec3(0.8f));
+            glUniformMatrix4fv(state.modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glDrawElements(GL_TRIANGLES, state.indexCount, GL_UNSIGNED_SHORT, 0);
+        }
+    }
+    else if (scene.kind == "suzanne")
+    {
+        // The lights circle above the field, each on its own orbit
+        float extent = std::sqrt((float)state.positions.size()) * 2.5f;
+        for (size_t i = 0; i < state.lights.size(); ++i)
+        {
+            float angle = (float)time * (0.3f + benchNoise((int)i, 8)) + 6.2831853f * benchNoise((int)i, 9);
+            float orbit = extent * 0.6f * benchNoise((int)i, 10);
+            state.lights[i].position = glm::vec3(std::cos(angle) * orbit, 0.5f + 1.5f * benchNoise((int)i, 11), std::sin(angle) * orbit);
+        }
+        cgcc::buildClusters(state.clusters, state.lights, state.view);
+        cgcc::bindClusters(state.clusters, state.program);
+        glUniformMatrix4fv(state.viewLoc, 1, GL_FALSE, glm::value_ptr(state.view));
+        for (size_t i = 0; i < state.positions.size(); ++i)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), state.positions[i]);
+            model = glm::rotate(model, (float)time * 0.5f + i, glm::vec3(0.0f, 1.0f, 0.0f));
+            glUniformMatrix4fv(state.modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, state.vertexCount);
+        }
+    }
+    else
+    {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, state.textures.texture);
+        float size = 0.5f / std::sqrt((float)state.positions.size()) + 0.02f;
+        for (size_t i = 0; i < state.positions.size(); ++i)
+        {
+            glm::vec3 p = state.positions[i];
+            float x = std::fmod(p.x + (float)time * (0.02f + 0.05f * p.z), 1.0f);
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x, p.y, 0.0f));
+            model = glm::scale(model, glm::vec3(size / state.aspect, size, 1.0f));
+            glUniformMatrix4fv(state.modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glUniform1f(state.layerLoc, (float)(i % 3));
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, state.vertexCount);
+        }
+        glDisable(GL_BLEND);
+    }
+    glBindVertexArray(0);
+}
+
+// ---------------------------------------------------------------------------
+// Measurement
+// ---------------------------------------------------------------------------
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    return sorted[(size_t)std::ceil(p * sorted.size()) - 1];
+}
+
+static bool runScene(GLFWwindow* window, const BenchScene& scene, int warmup, int frames, const std::string& assets, BenchResult& result)
+{
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    SceneState state;
+    bool ready = false;
+    if (scene.kind == "cubes")
+        ready = setupCubes(state, scene.count);
+    else if (scene.kind == "suzanne")
+        ready = setupSuzannes(state, scene.count, scene.lights, assets, width, height);
+    else
+        ready = setupSprites(state, scene.count, assets, width, height);
+    if (!ready)
+    {
+        destroyScene(state);
+        return false;
+    }
+
+    cgcc::FrameTimer timer;
+    cgcc::initFrameTimer(timer);
+    std::vector<double> frameTimes;
+    uint64_t draws = 0, triangles = 0;
+    glViewport(0, 0, width, height);
+    // Sprites are blended in order, all at the same depth
+    if (scene.kind == "sprites")
+        glDisable(GL_DEPTH_TEST);
+    else
+        glEnable(GL_DEPTH_TEST);
+    glClearColor(0.1f, 0.1f, 0.12f, 1.0f);
+
+    auto last = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < warmup + frames; ++frame)
+    {
+        glfwPollEvents();
+        cgcc::beginFrameTimer(timer);
+        cgcc::beginGLCallFrame();
+        cgcc::beginGpuPass(timer, "scene");
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawScene(state, scene, frame * animationStep);
+        cgcc::endFrameTimer(timer);
+        cgcc::endGLCallFrame();
+        glfwSwapBuffers(window);
+
+        auto now = std::chrono::steady_clock::now();
+        if (frame >= warmup)
+        {
+            frameTimes.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+            draws += cgcc::lastGLCallFrame().draws;
+            triangles += cgcc::lastGLCallFrame().triangles;
+        }
+        last = now;
+    }
+    glFinish();
+
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double ms : sorted)
+        total += ms;
+    result.name = sceneName(scene);
+    result.frames = frames;
+    result.frameMin = sorted.front();
+    result.frameP50 = percentile(sorted, 0.50);
+    result.frameP95 = percentile(sorted, 0.95);
+    result.frameP99 = percentile(sorted, 0.99);
+    result.frameAvg = total / frames;
+    result.gpuAvg = timer.series.size() > 1 ? cgcc::timingStats(timer.series[1]).avg : 0.0;
+    result.drawsPerFrame = (double)draws / frames;
+    result.trianglesPerFrame = (double)triangles / frames;
+    result.trianglesPerSecond = triangles / (total * 1e-3);
+
+    cgcc::destroyFrameTimer(timer);
+    destroyScene(state);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Results
+// ---------------------------------------------------------------------------
+
+// One scene per line, so a baseline can be read back line by line
+static bool writeResults(const std::string& path, const std::string& renderer, const std::vector<BenchResult>& results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::BENCH::FILE_NOT_WRITTEN\n" << path << std::endl;
+        return false;
+    }
+    file << "{\n  \"renderer\": \"" << renderer << "\",\n  \"scenes\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& r = results[i];
+        file << "    {\"name\": \"" << r.name << "\", \"frames\": " << r.frames
+             << ", \"frame_ms_min\": " << r.frameMin << ", \"frame_ms_p50\": " << r.frameP50
+             << ", \"frame_ms_p95\": " << r.frameP95 << ", \"frame_ms_p99\": " << r.frameP99
+             << ", \"frame_ms_avg\": " << r.frameAvg << ", \"gpu_ms_avg\": " << r.gpuAvg
+             << ", \"draws_per_frame\": " << r.drawsPerFrame << ", \"triangles_per_frame\": " << r.trianglesPerFrame
+             << ", \"triangles_per_sec\": " << r.trianglesPerSecond << "}"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+static std::string jsonString(const std::string& line, const std::string& key)
+{
+    size_t at = line.find("\"" + key + "\": \"");
+    if (at == std::string::npos)
+        return "";
+    at += key.size() + 5;
+    return line.substr(at, line.find('"', at) - at);
+}
+
+static double jsonNumber(const std::string& line, const std::string& key)
+{
+    size_t at = line.find("\"" + key + "\": ");
+    return at == std::string::npos ? 0.0 : std::atof(line.c_str() + at + key.size() + 4);
+}
+
+// Reads a file written by writeResults()
+static bool readResults(const std::string& path, std::string& renderer, std::vector<BenchResult>& results)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::BENCH::BASELINE_NOT_FOUND\n" << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.find("\"renderer\"") != std::string::npos)
+            renderer = jsonString(line, "renderer");
+        if (line.find("\"name\"") == std::string::npos)
+            continue;
+        BenchResult r;
+        r.name = jsonString(line, "name");
+        r.frames = (int)jsonNumber(line, "frames");
+        r.frameP50 = jsonNumber(line, "frame_ms_p50");
+        r.frameP99 = jsonNumber(line, "frame_ms_p99");
+        r.drawsPerFrame = jsonNumber(line, "draws_per_frame");
+        r.trianglesPerSecond = jsonNumber(line, "triangles_per_sec");
+        results.push_back(r);
+    }
+    return true;
+}
+
+// Prints every compared metric; returns the number of regressions
+static int compareResults(const std::vector<BenchResult>& baseline, const std::vector<BenchResult>& results, double tolerance)
+{
+    int regressions = 0;
+    auto check = [&](const std::string& scene, const char* metric, double before, double after, bool lowerIsBetter) {
+        double change = before != 0.0 ? (after - before) / before : 0.0;
+        bool regressed = lowerIsBetter ? change > tolerance : change < -tolerance;
+        regressions += regressed;
+        std::cout << "  " << scene << " " << metric << ": " << before << " -> " << after
+                  << " (" << (change >= 0.0 ? "+" : "") << change * 100.0 << "%)" << (regressed ? "  REGRESSION" : "") << std::endl;
+    };
+    for (const BenchResult& r : results)
+    {
+        auto base = std::find_if(baseline.begin(), baseline.end(), [&](const BenchResult& b) { return b.name == r.name; });
+        if (base == baseline.end())
+        {
+            std::cout << "  " << r.name << ": not in the baseline" << std::endl;
+            continue;
+        }
+        check(r.name, "frame_ms_p50", base->frameP50, r.frameP50, true);
+        check(r.name, "frame_ms_p99", base->frameP99, r.frameP99, true);
+        check(r.name, "draws_per_frame", base->drawsPerFrame, r.drawsPerFrame, true);
+        check(r.name, "triangles_per_sec", base->trianglesPerSecond, r.trianglesPerSecond, false);
+    }
+    return regressions;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<BenchScene> scenes;
+    int frames = 300, warmup = 30, width = 1280, height = 720;
+    double tolerance = 0.10;
+    std::string assets = "../assets", out = "bench.json", baselinePath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        BenchScene scene;
+        if (arg == "--scene" && hasValue && parseScene(argv[i + 1], scene)) { scenes.push_back(scene); ++i; }
+        else if (arg == "--frames" && hasValue) frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--warmup" && hasValue) warmup = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--size" && hasValue) std::sscanf(argv[++i], "%dx%d", &width, &height);
+        else if (arg == "--assets" && hasValue) assets = argv[++i];
+        else if (arg == "--out" && hasValue) out = argv[++i];
+        else if (arg == "--baseline" && hasValue) baselinePath = argv[++i];
+        else if (arg == "--tolerance" && hasValue) tolerance = std::atof(argv[++i]);
+        else
+        {
+            std::cout << "Usage: cgcc_bench [--scene cubes:N | suzanne:N:L | sprites:N]... [--frames N] [--warmup N] [--size WxH]"
+                         " [--assets dir] [--out bench.json] [--baseline old.json] [--tolerance 0.10]" << std::endl;
+            return 1;
+        }
+    }
+    if (scenes.empty())
+        scenes = defaultSuite;
+
+    glfwInit();
+    GLFWwindow* window = glfwCreateWindow(width, height, "cgcc_bench", nullptr, nullptr);
+    if (!window)
+    {
+        std::cout << "Failed to create the window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return 1;
+    }
+    cgcc::loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    cgcc::installGLCallCounters();
+    glfwSwapInterval(0);
+    std::string renderer = (const char*)glGetString(GL_RENDERER);
+    std::cout << "Renderer: " << renderer << std::endl;
+
+    std::vector<BenchResult> results;
+    for (const BenchScene& scene : scenes)
+    {
+        BenchResult result;
+        if (!runScene(window, scene, warmup, frames, assets, result))
+            continue;
+        std::cout << result.name << ": " << result.frameP50 << " ms p50, " << result.frameP99 << " ms p99, "
+                  << result.drawsPerFrame << " draws, " << result.trianglesPerSecond / 1e6 << " Mtris/s" << std::endl;
+        results.push_back(result);
+    }
+    writeResults(out, renderer, results);
+
+    int regressions = 0;
+    if (!baselinePath.empty())
+    {
+        std::string baselineRenderer;
+        std::vector<BenchResult> baseline;
+        if (!readResults(baselinePath, baselineRenderer, baseline))
+            regressions = 1;
+        else
+        {
+            if (baselineRenderer != renderer)
+                std::cout << "Warning: the baseline was measured on " << baselineRenderer << std::endl;
+            std::cout << "Compared with " << baselinePath << " (tolerance " << tolerance * 100.0 << "%):" << std::endl;
+            regressions = compareResults(baseline, results, tolerance);
+            std::cout << regressions << " regression(s)" << std::endl;
+        }
+    }
+
+    cgcc::removeGLCallCounters();
+    glfwTerminate();
+    return regressions > 0 ? 1 : 0;
+}
@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <assert.h>
 
 using namespace std;
@@ -27,6 +28,29 @@ using namespace std;
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+// Pré-passo de profundidade opcional
+#include <cgcc/DepthPrepass.h>
+
+// Carregamento de texturas em segundo plano (decodificação em threads, upload
+// por PBOs dentro de um orçamento por quadro; usa o KTX2 gerado pelo TexCompress)
+#include <cgcc/TextureStreamer.h>
+
+// Variações especializadas do shader (permutações), compiladas pelo cache em disco
+// de binários de programas
+#include <cgcc/ShaderPermutation.h>
+
+// Malhas procedurais indexadas (esfera, cubo...), geradas uma vez e guardadas em cache
+#include <cgcc/Primitives.h>
+
+// Vsync, limite de quadros por segundo e redesenho só quando algo muda
+#include <cgcc/FramePacer.h>
+
+// Zonas de tempo por thread, exportadas para chrome://tracing (com CGCC_TRACING)
+#include <cgcc/Trace.h>
+
+// Buffers e texturas com tamanho e tempo de vida; relatório de vazamentos ao sair
+#include <cgcc/GPUMemory.h>
+
 using namespace glm;
 
 #include <cmath>
@@ -35,46 +59,73 @@ using namespace glm;
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 
 // Protótipos das funções
-int setupShader();
-int setupGeometry();
-GLuint loadTexture(string filePath, int &width, int &height);
-
-void drawGeometry(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, float angle, int nVertices, vec3 color= vec3(1.0,0.0,0.0), vec3 axis = (vec3(0.0, 0.0, 1.0)));
-GLuint generateSphere(float radius, int latSegments, int lonSegments, int &nVertices);
+void drawGeometry(GLuint shaderID, const cgcc::PrimitiveMesh &mesh, vec3 position, vec3 dimensions, float angle, vec3 color= vec3(1.0,0.0,0.0), vec3 axis = (vec3(0.0, 0.0, 1.0)));
  
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 800;
 
-// Código fonte do Vertex Shader (em GLSL): ainda hardcoded
-const GLchar *vertexShaderSource = R"(
-#version 400
+// Pré-passo de profundidade (tecla P): desenha só a profundidade e depois sombreia
+// com GL_EQUAL, assim cada pixel executa o fragment shader uma única vez
+bool depthPrepass = false;
+
+// Textura no lugar da cor do vértice (tecla T); usa outra permutação do shader
+bool useTexture = false;
+
+// A cena é estática: só é redesenhada quando uma tecla, a janela ou o streamer
+// de texturas mudam alguma coisa (modo sob demanda); tecla V liga/desliga o vsync
+cgcc::FramePacer framePacer;
+
+// Templates dos shaders (em GLSL): o #version e os #defines de cada permutação
+// (LIGHT_COUNT, USE_TEXTURE, USE_PALETTE, USE_SPECULAR, VERTEX_COLOR, VERTEX_TEXCOORD) são
+// inseridos antes do código por cgcc::permutationSource
+const GLchar *vertexShaderTemplate = R"(
 layout (location = 0) in vec3 position;
+#ifdef VERTEX_COLOR
 layout (location = 1) in vec3 color;
+#endif
 layout (location = 2) in vec3 normal;
+#ifdef VERTEX_TEXCOORD
 layout (location = 3) in vec2 texc;
+#endif
 
 uniform mat4 projection;
 uniform mat4 model;
 
+#ifdef USE_TEXTURE
 out vec2 texCoord;
+#endif
 out vec3 vNormal;
 out vec4 fragPos; 
+#ifdef VERTEX_COLOR
 out vec4 vColor;
+#endif
+invariant gl_Position; // o pré-passo de profundidade reutiliza este shader
 void main()
 {
    	gl_Position = projection * model * vec4(position.x, position.y, position.z, 1.0);
 	fragPos = model * vec4(position.x, position.y, position.z, 1.0);
+#ifdef USE_TEXTURE
 	texCoord = texc;
+#endif
 	vNormal = normal;
+#ifdef VERTEX_COLOR
 	vColor = vec4(color,1.0);
+#endif
 })";
 
-// Código fonte do Fragment Shader (em GLSL): ainda hardcoded
-const GLchar *fragmentShaderSource = R"(
-#version 400
+const GLchar *fragmentShaderTemplate = R"(
+#ifdef USE_TEXTURE
 in vec2 texCoord;
+#ifdef USE_PALETTE
+uniform usampler2D texIndex;  // um byte por texel: índice na paleta
+uniform sampler2D texPalette; // as cores, numa linha
+#else
 uniform sampler2D texBuff;
-uniform vec3 lightPos;
+#endif
+#endif
+#if LIGHT_COUNT > 0
+uniform vec3 lightPos[LIGHT_COUNT];
+#endif
 uniform vec3 camPos;
 uniform float ka;
 uniform float kd;
@@ -83,40 +134,71 @@ uniform float q;
 out vec4 color;
 in vec4 fragPos;
 in vec3 vNormal;
+#ifdef VERTEX_COLOR
 in vec4 vColor;
+#endif
 void main()
 {
 
 	vec3 lightColor = vec3(1.0,1.0,1.0);
-	//vec4 objectColor = texture(texBuff,texCoord);
+#if defined(USE_TEXTURE) && defined(USE_PALETTE)
+	vec4 objectColor = texelFetch(texPalette, ivec2(texture(texIndex,texCoord).r, 0), 0);
+#elif defined(USE_TEXTURE)
+	vec4 objectColor = texture(texBuff,texCoord);
+#elif defined(VERTEX_COLOR)
 	vec4 objectColor = vColor;
+#else
+	vec4 objectColor = vec4(1.0);
+#endif
 
-	//Coeficiente de luz ambiente
-	vec3 ambient = ka * lightColor;
-
-	//Coeficiente de reflexão difusa
 	vec3 N = normalize(vNormal);
-	vec3 L = normalize(lightPos - vec3(fragPos));
-	float diff = max(dot(N, L),0.0);
-	vec3 diffuse = kd * diff * lightColor;
-
-	//Coeficiente de reflexão especular
-	vec3 R = normalize(reflect(-L,N));
 	vec3 V = normalize(camPos - vec3(fragPos));
-	float spec = max(dot(R,V),0.0);
-	spec = pow(spec,q);
-	vec3 specular = ks * spec * lightColor; 
-
-	vec3 result = (ambient + diffuse) * vec3(objectColor) + specular;
+	vec3 result = vec3(0.0);
+	// Com LIGHT_COUNT constante o laço é desenrolado pelo compilador; sem luzes
+	// (LIGHT_COUNT 0) não há lightPos e o resultado fica preto
+#if LIGHT_COUNT > 0
+	for (int i = 0; i < LIGHT_COUNT; ++i)
+	{
+		//Coeficiente de luz ambiente
+		vec3 ambient = ka * lightColor;
+
+		//Coeficiente de reflexão difusa
+		vec3 L = normalize(lightPos[i] - vec3(fragPos));
+		float diff = max(dot(N, L),0.0);
+		vec3 diffuse = kd * diff * lightColor;
+
+		result += (ambient + diffuse) * vec3(objectColor);
+
+#ifdef USE_SPECULAR
+		//Coeficiente de reflexão especular
+		vec3 R = normalize(reflect(-L,N));
+		float spec = max(dot(R,V),0.0);
+		spec = pow(spec,q);
+		result += ks * spec * lightColor;
+#endif
+	}
+#endif
 	color = vec4(result,1.0);
 
 })";
 
+// Permutações usadas pela cena: a esfera tem cor, normal e UV por vértice,
+// uma luz e especular; a tecla T troca a cor do vértice pela textura
+constexpr uint32_t spherePermutation = cgcc::shaderPermutation(1, cgcc::FeatureSpecular | cgcc::FeatureVertexColor | cgcc::FeatureTexCoord);
+constexpr uint32_t texturedSpherePermutation = spherePermutation | cgcc::FeatureTexture;
+static_assert(cgcc::permutationValid(texturedSpherePermutation), "textura precisa de coordenadas de textura");
+// A mesma, para a textura importada como paleta (pixel art com até 256 cores)
+constexpr uint32_t palettedSpherePermutation = texturedSpherePermutation | cgcc::FeaturePalette;
+static_assert(cgcc::permutationValid(palettedSpherePermutation), "paleta precisa de textura");
+
+cgcc::ShaderPermutations phongShaders = { "#version 400", vertexShaderTemplate, fragmentShaderTemplate };
+
 // Função MAIN
 int main()
 {
 	// Inicialização da GLFW
 	glfwInit();
+	CGCC_TRACE_THREAD("main");
 
 	// Muita atenção aqui: alguns ambientes não aceitam essas configurações
 	// Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -143,6 +225,10 @@ int main()
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
 	}
+	// Funções da OpenGL mais novas que o perfil da GLAD (cache de binários de shader)
+	cgcc::loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+	// Todo buffer e textura criados daqui em diante são registrados (relatório ao sair)
+	cgcc::installGPUMemoryTracker();
 
 	// Obtendo as informações de versão
 	const GLubyte *renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -155,72 +241,140 @@ int main()
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
-	// Compilando e buildando o programa de shader
-	GLuint shaderID = setupShader();
-
-	// Gerando um buffer simples, com a geometria de um triângulo
-	int nVertices;
-	GLuint VAO = generateSphere(0.5, 16, 16, nVertices);
-
-	// Carregando uma textura e armazenando seu id
-	int imgWidth, imgHeight;
-	GLuint texID = loadTexture("../assets/tex/pixelWall.png",imgWidth,imgHeight);
+	// Compilando e buildando o programa de shader (só a permutação usada no início;
+	// a texturizada é compilada quando for pedida pela primeira vez)
+	GLuint shaderID = cgcc::getPermutation(phongShaders, spherePermutation);
+	// Programa do pré-passo: mesmo vertex shader, fragment shader vazio
+	std::string prepassVertexSource = cgcc::permutationSource(phongShaders.version, vertexShaderTemplate, spherePermutation);
+	GLuint prepassID = cgcc::buildDepthPrepassProgram(prepassVertexSource.c_str());
+
+	// Esfera indexada da biblioteca de primitivas; sphere.positionVAO (só as
+	// posições, nos mesmos buffers) é usado no pré-passo
+	cgcc::PrimitiveCache primitives;
+	cgcc::PrimitiveMesh sphere = cgcc::uvSphere(primitives, 0.5f, 16, 16);
+	// A malha não tem cor por vértice: o atributo 1 fica desligado e o shader lê
+	// este valor constante
+	glVertexAttrib3f(1, 1.0f, 0.0f, 0.0f);
+
+	// Pedindo a textura ao streamer: ela é lida e decodificada em outra thread e
+	// enviada aos poucos; até lá streamedTexture() devolve uma textura cinza provisória
+	cgcc::TextureStreamer streamer;
+	cgcc::initTextureStreamer(streamer);
+	// pixelWall é pixel art: se tiver no máximo 256 cores vira índices de 8 bits + paleta
+	int wallTexture = cgcc::requestTexture(streamer, "../assets/tex/pixelWall.png", cgcc::MipOptions(), true);
 
 	float ka = 0.1, kd =0.5, ks = 0.5, q = 10.0;
 	vec3 lightPos = vec3(0.6, 1.2, -0.5);
 	vec3 camPos = vec3(0.0,0.0,-3.0);
 
 
-	glUseProgram(shaderID);
-
-	// Enviar a informação de qual variável armazenará o buffer da textura
-	glUniform1i(glGetUniformLocation(shaderID, "texBuff"), 0);
+	// Matriz de projeção paralela ortográfica
+	// mat4 projection = ortho(-10.0, 10.0, -10.0, 10.0, -1.0, 1.0);
+	mat4 projection = ortho(-1.0, 1.0, -1.0, 1.0, -3.0, 3.0);
 
-	glUniform1f(glGetUniformLocation(shaderID, "ka"), ka);
-	glUniform1f(glGetUniformLocation(shaderID, "kd"), kd);
-	glUniform1f(glGetUniformLocation(shaderID, "ks"), ks);
-	glUniform1f(glGetUniformLocation(shaderID, "q"), q);
-	glUniform3f(glGetUniformLocation(shaderID, "lightPos"), lightPos.x,lightPos.y,lightPos.z);
-	glUniform3f(glGetUniformLocation(shaderID, "camPos"), camPos.x,camPos.y,camPos.z);
+	// Uniforms de cada permutação (enviados quando ela passa a ser usada)
+	auto setupUniforms = [&](GLuint programID) {
+		glUseProgram(programID);
+
+		// Enviar a informação de qual variável armazenará o buffer da textura
+		glUniform1i(glGetUniformLocation(programID, "texBuff"), 0);
+		glUniform1i(glGetUniformLocation(programID, "texIndex"), 0);
+		glUniform1i(glGetUniformLocation(programID, "texPalette"), 1);
+
+		glUniform1f(glGetUniformLocation(programID, "ka"), ka);
+		glUniform1f(glGetUniformLocation(programID, "kd"), kd);
+		glUniform1f(glGetUniformLocation(programID, "ks"), ks);
+		glUniform1f(glGetUniformLocation(programID, "q"), q);
+		glUniform3f(glGetUniformLocation(programID, "lightPos"), lightPos.x,lightPos.y,lightPos.z);
+		glUniform3f(glGetUniformLocation(programID, "camPos"), camPos.x,camPos.y,camPos.z);
+		glUniformMatrix4fv(glGetUniformLocation(programID, "projection"), 1, GL_FALSE, value_ptr(projection));
+	};
+	setupUniforms(shaderID);
 
 	//Ativando o primeiro buffer de textura da OpenGL
 	glActiveTexture(GL_TEXTURE0);
-	
 
-	// Matriz de projeção paralela ortográfica
-	// mat4 projection = ortho(-10.0, 10.0, -10.0, 10.0, -1.0, 1.0);
-	mat4 projection = ortho(-1.0, 1.0, -1.0, 1.0, -3.0, 3.0);
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
+	glUseProgram(prepassID);
+	glUniformMatrix4fv(glGetUniformLocation(prepassID, "projection"), 1, GL_FALSE, value_ptr(projection));
+	glUseProgram(shaderID);
 
-	// Matriz de modelo: transformações na geometria (objeto)
-	mat4 model = mat4(1); // matriz identidade
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
+	glEnable(GL_DEPTH_TEST);
+
+	framePacer.mode = cgcc::PacingMode::OnDemand;
+	framePacer.targetFps = 60.0;
+	cgcc::initFramePacer(framePacer, window);
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
-		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
-		glfwPollEvents();
+		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes;
+		// sem nada para redesenhar, espera por eles sem ocupar a CPU
+		if (!cgcc::beginFrame(framePacer))
+			continue;
+		CGCC_TRACE_ZONE("frame");
+
+		// Envia para a GPU um pedaço das texturas já decodificadas (no máximo 2 ms por quadro)
+		cgcc::updateTextureStreamer(streamer, 2.0);
+		// Enquanto houver textura chegando, o próximo quadro também precisa ser desenhado
+		if (!cgcc::textureStreamerIdle(streamer))
+			cgcc::requestRedraw(framePacer);
+
+		// Permutação do shader para o estado atual (compilada na primeira vez que é usada)
+		GLuint wallPalette = cgcc::streamedPalette(streamer, wallTexture);
+		uint32_t permutation = !useTexture ? spherePermutation : (wallPalette ? palettedSpherePermutation : texturedSpherePermutation);
+		GLuint activeID = cgcc::getPermutation(phongShaders, permutation);
+		if (activeID != shaderID)
+		{
+			shaderID = activeID;
+			setupUniforms(shaderID);
+		}
 
-		// Limpa o buffer de cor
+		// Limpa os buffers de cor e de profundidade
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // cor de fundo
-		glClear(GL_COLOR_BUFFER_BIT);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindVertexArray(VAO); // Conectando ao buffer de geometria
-		glBindTexture(GL_TEXTURE_2D, texID); //conectando com o buffer de textura que será usado no draw
+		// Pré-passo: só profundidade, com o buffer de posições
+		if (depthPrepass)
+		{
+			glUseProgram(prepassID);
+			glBindVertexArray(sphere.positionVAO);
+			cgcc::beginDepthPrepass();
+			drawGeometry(prepassID, sphere, vec3(0, 0, 0), vec3(1, 1, 1), 0.0);
+			cgcc::beginEqualDepthPass();
+			glUseProgram(shaderID);
+		}
+
+		glBindVertexArray(sphere.vao); // Conectando ao buffer de geometria
+		glBindTexture(GL_TEXTURE_2D, cgcc::streamedTexture(streamer, wallTexture)); //conectando com o buffer de textura que será usado no draw
+		if (wallPalette)
+		{
+			// A paleta vai na unidade 1 (texPalette)
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, wallPalette);
+			glActiveTexture(GL_TEXTURE0);
+		}
 
 		// Primeiro Triângulo
-		drawGeometry(shaderID, VAO, vec3(0, 0, 0), vec3(1, 1, 1), 0.0, nVertices);
+		drawGeometry(shaderID, sphere, vec3(0, 0, 0), vec3(1, 1, 1), 0.0);
 
+		if (depthPrepass)
+			cgcc::endEqualDepthPass();
 	
 		glBindVertexArray(0); // Desconectando o buffer de geometria
 
-		// Troca os buffers da tela
-		glfwSwapBuffers(window);
+		// Troca os buffers da tela e espera a vez do próximo quadro
+		cgcc::endFrame(framePacer);
 	}
 	// Pede pra OpenGL desalocar os buffers
-	glDeleteVertexArrays(1, &VAO);
+	cgcc::destroyPrimitiveCache(primitives);
+	cgcc::destroyTextureStreamer(streamer);
+	cgcc::destroyPermutations(phongShaders);
+	glDeleteProgram(prepassID);
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
+	CGCC_TRACE_WRITE("trace.json");
+	// O que ainda estiver alocado aqui é vazamento
+	cgcc::reportGPUMemory(std::cout);
+	cgcc::removeGPUMemoryTracker();
 	glfwTerminate();
 	return 0;
 }
@@ -232,167 +386,33 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
-}
 
-// Esta função está basntante hardcoded - objetivo é compilar e "buildar" um programa de
-//  shader simples e único neste exemplo de código
-//  O código fonte do vertex e fragment shader está nos arrays vertexShaderSource e
-//  fragmentShader source no iniçio deste arquivo
-//  A função retorna o identificador do programa de shader
-int setupShader()
-{
-	// Vertex shader
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-	// Checando erros de compilação (exibição via log no terminal)
-	GLint success;
-	GLchar infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success)
+	// Liga/desliga o pré-passo de profundidade
+	if (key == GLFW_KEY_P && action == GLFW_PRESS)
 	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
+		depthPrepass = !depthPrepass;
+		cout << "Pre-passo de profundidade: " << (depthPrepass ? "ligado" : "desligado") << endl;
 	}
-	// Fragment shader
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-	// Checando erros de compilação (exibição via log no terminal)
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
-	}
-	// Linkando os shaders e criando o identificador do programa de shader
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-	// Checando por erros de linkagem
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-	if (!success)
-	{
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-				  << infoLog << std::endl;
-	}
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	return shaderProgram;
-}
-
-// Esta função está bastante harcoded - objetivo é criar os buffers que armazenam a
-// geometria de um triângulo
-// Apenas atributo coordenada nos vértices
-// 1 VBO com as coordenadas, VAO com apenas 1 ponteiro para atributo
-// A função retorna o identificador do VAO
-int setupGeometry()
-{
-	// Aqui setamos as coordenadas x, y e z do triângulo e as armazenamos de forma
-	// sequencial, já visando mandar para o VBO (Vertex Buffer Objects)
-	// Cada atributo do vértice (coordenada, cores, coordenadas de textura, normal, etc)
-	// Pode ser arazenado em um VBO único ou em VBOs separados
-	GLfloat vertices[] = {
-		// x    y    z   s    t    nx  ny    nz
-		// T0
-		-0.5, -0.5, 0.0, 0.0, 0.0, 0.0, 0.0, -1.0,    // v0
-		 0.5, -0.5, 0.0, 1.0, 0.0, 0.0, 0.0, -1.0,   // v1
-		 0.0,  0.5, 0.0, 0.5, 1.0, 0.0, 0.0, -1.0 	  // v2
-	};
-
-	GLuint VBO, VAO;
-	// Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-	// Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos
-	glBindVertexArray(VAO);
-	// Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
-	//  Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	//  Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
-	//  Tipo do dado
-	//  Se está normalizado (entre zero e um)
-	//  Tamanho em bytes
-	//  Deslocamento a partir do byte zero
-
-	//Atributo posição - coord x, y, z - 3 valores
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid *)0);
-	glEnableVertexAttribArray(0);
-
-	//Atributo coordenada de textura - coord s, t - 2 valores
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid *)(3* sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	//Atributo componentes vetor normal
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid *)(5* sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
-
-	return VAO;
-}
-
-GLuint loadTexture(string filePath, int &width, int &height)
-{
-	GLuint texID; // id da textura a ser carregada
-
-	// Gera o identificador da textura na memória
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
-
-	// Ajuste dos parâmetros de wrapping e filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Carregamento da imagem usando a função stbi_load da biblioteca stb_image
-	int nrChannels;
-
-	unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
 
-	if (data)
+	// Liga/desliga a textura (troca a permutação do shader)
+	if (key == GLFW_KEY_T && action == GLFW_PRESS)
 	{
-		if (nrChannels == 3) // jpg, bmp
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		else // assume que é 4 canais png
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
+		useTexture = !useTexture;
+		cout << "Textura: " << (useTexture ? "ligada" : "desligada") << endl;
 	}
-	else
+
+	// Liga/desliga o vsync
+	if (key == GLFW_KEY_V && action == GLFW_PRESS)
 	{
-		std::cout << "Failed to load texture " << filePath << std::endl;
+		cgcc::setSwapInterval(framePacer, framePacer.swapInterval ? 0 : 1);
+		cout << "Vsync: " << (framePacer.swapInterval ? "ligado" : "desligado") << endl;
 	}
 
-	stbi_image_free(data);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	return texID;
+	// Qualquer tecla pode ter mudado a cena
+	cgcc::requestRedraw(framePacer);
 }
 
-void drawGeometry(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, float angle, int nVertices, vec3 color, vec3 axis)
+void drawGeometry(GLuint shaderID, const cgcc::PrimitiveMesh &mesh, vec3 position, vec3 dimensions, float angle, vec3 color, vec3 axis)
 {
 	// Matriz de modelo: transformações na geometria (objeto)
 	mat4 model = mat4(1); // matriz identidade
@@ -407,85 +427,5 @@ void drawGeometry(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, f
 	//glUniform4f(glGetUniformLocation(shaderID, "inputColor"), color.r, color.g, color.b, 1.0f); // enviando cor para variável uniform inputColor
 																								//  Chamada de desenho - drawcall
 																								//  Poligono Preenchido - GL_TRIANGLES
-	glDrawArrays(GL_TRIANGLES, 0, nVertices);
+	cgcc::drawPrimitive(mesh);
 }
-
-GLuint generateSphere(float radius, int latSegments, int lonSegments, int &nVertices) {
-    vector<GLfloat> vBuffer; // Posição + Cor + Normal + UV
-
-    vec3 color = vec3(1.0f, 0.0f, 0.0f); // Laranja
-
-    auto calcPosUVNormal = [&](int lat, int lon, vec3& pos, vec2& uv, vec3& normal) {
-        float theta = lat * pi<float>() / latSegments;
-        float phi = lon * 2.0f * pi<float>() / lonSegments;
-
-        pos = vec3(
-            radius * cos(phi) * sin(theta),
-            radius * cos(theta),
-            radius * sin(phi) * sin(theta)
-        );
-
-        uv = vec2(
-            phi / (2.0f * pi<float>()),  // u
-            theta / pi<float>()          // v
-        );
-
-        // Normal é a posição normalizada (posição/radius)
-        normal = normalize(pos);
-    };
-
-    for (int i = 0; i < latSegments; ++i) {
-        for (int j = 0; j < lonSegments; ++j) {
-            vec3 v0, v1, v2, v3;
-            vec2 uv0, uv1, uv2, uv3;
-            vec3 n0, n1, n2, n3;
-
-            calcPosUVNormal(i, j, v0, uv0, n0);
-            calcPosUVNormal(i + 1, j, v1, uv1, n1);
-            calcPosUVNormal(i, j + 1, v2, uv2, n2);
-            calcPosUVNormal(i + 1, j + 1, v3, uv3, n3);
-
-            // Primeiro triângulo
-            vBuffer.insert(vBuffer.end(), { v0.x, v0.y, v0.z, color.r, color.g, color.b, n0.x, n0.y, n0.z, uv0.x, uv0.y });
-            vBuffer.insert(vBuffer.end(), { v1.x, v1.y, v1.z, color.r, color.g, color.b, n1.x, n1.y, n1.z, uv1.x, uv1.y });
-            vBuffer.insert(vBuffer.end(), { v2.x, v2.y, v2.z, color.r, color.g, color.b, n2.x, n2.y, n2.z, uv2.x, uv2.y });
-
-            // Segundo triângulo
-            vBuffer.insert(vBuffer.end(), { v1.x, v1.y, v1.z, color.r, color.g, color.b, n1.x, n1.y, n1.z, uv1.x, uv1.y });
-            vBuffer.insert(vBuffer.end(), { v3.x, v3.y, v3.z, color.r, color.g, color.b, n3.x, n3.y, n3.z, uv3.x, uv3.y });
-            vBuffer.insert(vBuffer.end(), { v2.x, v2.y, v2.z, color.r, color.g, color.b, n2.x, n2.y, n2.z, uv2.x, uv2.y });
-        }
-    }
-
-    // Criar VAO e VBO
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vBuffer.size() * sizeof(GLfloat), vBuffer.data(), GL_STATIC_DRAW);
-
-    // Layout da posição (location 0)
-glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(0));
-glEnableVertexAttribArray(0);
-
-// Layout da cor (location 1)
-glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-glEnableVertexAttribArray(1);
-
-// Layout da normal (location 2)
-glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-glEnableVertexAttribArray(2);
-
-// Layout da UV (location 3)
-glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(9 * sizeof(GLfloat)));
-glEnableVertexAttribArray(3);
-
-    glBindVertexArray(0);
-
-    nVertices = vBuffer.size() / 11; // Cada vértice agora tem 11 floats!
-
-    return VAO;
-}
\ No newline at end of file
@@ -23,13 +23,28 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Cache em disco dos binários dos programas de shader
+#include <cgcc/ProgramCache.h>
+
+// Geometria gerada pelo compilador (constexpr) no formato de vértice declarado abaixo
+#include <cgcc/StaticGeometry.h>
+
+// Vsync, limite de quadros por segundo e redesenho só quando algo muda
+#include <cgcc/FramePacer.h>
+
+// Zonas de tempo por thread, exportadas para chrome://tracing (com CGCC_TRACING)
+#include <cgcc/Trace.h>
+
+// Buffers e texturas com tamanho e tempo de vida; relatório de vazamentos ao sair
+#include <cgcc/GPUMemory.h>
+
 
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 
 // Protótipos das funções
 int setupShader();
-int setupGeometry();
+int setupGeometry(GLuint& VBO, GLuint& EBO);
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 1000, HEIGHT = 1000;
@@ -58,11 +73,28 @@ const GLchar* fragmentShaderSource = "#version 450\n"
 
 bool rotateX=false, rotateY=false, rotateZ=false;
 
+// Parada, a pirâmide só é redesenhada quando uma tecla ou a janela pedem;
+// girando, todo quadro (com vsync)
+cgcc::FramePacer framePacer;
+
+// Formato dos vértices: posição (location 0) e cor (location 1); os ponteiros
+// de atributo de setupGeometry() saem desta declaração
+using PositionColor = cgcc::VertexLayout<cgcc::VertexAttrib<cgcc::VertexAttribute::Position>, cgcc::VertexAttrib<cgcc::VertexAttribute::Color>>;
+
+const cgcc::GeometryColor yellow = { 1.0, 1.0, 0.0 }, cyan = { 0.0, 1.0, 1.0 }, magenta = { 1.0, 0.0, 1.0 };
+
+// Pirâmide de base 1 e altura 1: a base com os cantos amarelo, magenta e ciano
+// em cada triângulo, os lados com uma cor cada. Calculada na compilação; os
+// vértices repetidos (mesma posição e cor) viram um só, referenciado por índices
+constexpr auto pyramidSoup = cgcc::pyramidGeometry(1.0f, 1.0f, { yellow, magenta, cyan }, { yellow, cyan, yellow, magenta });
+static constexpr auto pyramid = cgcc::indexGeometry<PositionColor, cgcc::uniqueVertexCount<PositionColor>(pyramidSoup)>(pyramidSoup);
+
 // Função MAIN
 int main()
 {
 	// Inicialização da GLFW
 	glfwInit();
+	CGCC_TRACE_THREAD("main");
 
 	//Muita atenção aqui: alguns ambientes não aceitam essas configurações
 	//Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -90,6 +122,10 @@ int main()
 		std::cout << "Failed to initialize GLAD" << std::endl;
 
 	}
+	// Funções da OpenGL mais novas que o perfil da GLAD (cache de binários de shader)
+	cgcc::loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+	// Todo buffer criado daqui em diante é registrado (relatório ao sair)
+	cgcc::installGPUMemoryTracker();
 
 	// Obtendo as informações de versão
 	const GLubyte* renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -107,7 +143,8 @@ int main()
 	GLuint shaderID = setupShader();
 
 	// Gerando um buffer simples, com a geometria de um triângulo
-	GLuint VAO = setupGeometry();
+	GLuint VBO, EBO;
+	GLuint VAO = setupGeometry(VBO, EBO);
 
 
 	glUseProgram(shaderID);
@@ -120,12 +157,16 @@ int main()
 
 	glEnable(GL_DEPTH_TEST);
 
+	framePacer.mode = cgcc::PacingMode::OnDemand;
+	cgcc::initFramePacer(framePacer, window);
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
 		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
-		glfwPollEvents();
+		if (!cgcc::beginFrame(framePacer))
+			continue;
+		CGCC_TRACE_ZONE("frame");
 
 		// Limpa o buffer de cor
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f); //cor de fundo
@@ -158,20 +199,30 @@ int main()
 		// Poligono Preenchido - GL_TRIANGLES
 		
 		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, 18);
+		glDrawElements(GL_TRIANGLES, (GLsizei)pyramid.indices.size(), GL_UNSIGNED_SHORT, 0);
 
 		// Chamada de desenho - drawcall
 		// CONTORNO - GL_LINE_LOOP
 		
-		glDrawArrays(GL_POINTS, 0, 18);
+		glDrawElements(GL_POINTS, (GLsizei)pyramid.indices.size(), GL_UNSIGNED_SHORT, 0);
 		glBindVertexArray(0);
 
 		// Troca os buffers da tela
-		glfwSwapBuffers(window);
+		cgcc::endFrame(framePacer);
+
+		// A rotação depende do tempo: o próximo quadro já é diferente
+		if (rotateX || rotateY || rotateZ)
+			cgcc::requestRedraw(framePacer);
 	}
 	// Pede pra OpenGL desalocar os buffers
 	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
+	CGCC_TRACE_WRITE("trace.json");
+	// O que ainda estiver alocado aqui é vazamento
+	cgcc::reportGPUMemory(std::cout);
+	cgcc::removeGPUMemoryTracker();
 	glfwTerminate();
 	return 0;
 }
@@ -205,8 +256,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		rotateZ = true;
 	}
 
-
-
+	cgcc::requestRedraw(framePacer);
 }
 
 //Esta função está basntante hardcoded - objetivo é compilar e "buildar" um programa de
@@ -216,6 +266,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 // A função retorna o identificador do programa de shader
 int setupShader()
 {
+	CGCC_TRACE_ZONE("setupShader");
+	// Se o programa já foi linkado numa execução anterior, recupera o binário do cache
+	uint64_t cacheKey = cgcc::programCacheKey({ vertexShaderSource, fragmentShaderSource });
+	if (GLuint cachedProgram = cgcc::loadCachedProgram(cacheKey))
+		return cachedProgram;
+
 	// Vertex shader
 	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
@@ -242,6 +298,7 @@ int setupShader()
 	}
 	// Linkando os shaders e criando o identificador do programa de shader
 	GLuint shaderProgram = glCreateProgram();
+	cgcc::markProgramRetrievable(shaderProgram);
 	glAttachShader(shaderProgram, vertexShader);
 	glAttachShader(shaderProgram, fragmentShader);
 	glLinkProgram(shaderProgram);
@@ -253,6 +310,9 @@ int setupShader()
 	}
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
+	// Guarda o binário linkado para as próximas execuções
+	if (success)
+		cgcc::storeCachedProgram(cacheKey, shaderProgram);
 
 	return shaderProgram;
 }
@@ -261,46 +321,15 @@ int setupShader()
 // geometria de um triângulo
 // Apenas atributo coordenada nos vértices
 // 1 VBO com as coordenadas, VAO com apenas 1 ponteiro para atributo
-// A função retorna o identificador do VAO
-int setupGeometry()
+// A função retorna o identificador do VAO; o VBO e o EBO voltam nos parâmetros
+// para serem apagados no fim
+int setupGeometry(GLuint& VBO, GLuint& EBO)
 {
-	// Aqui setamos as coordenadas x, y e z do triângulo e as armazenamos de forma
-	// sequencial, já visando mandar para o VBO (Vertex Buffer Objects)
-	// Cada atributo do vértice (coordenada, cores, coordenadas de textura, normal, etc)
-	// Pode ser arazenado em um VBO único ou em VBOs separados
-	GLfloat vertices[] = {
-
-		//Base da pirâmide: 2 triângulos
-		//x    y    z    r    g    b
-		-0.5, -0.5, -0.5, 1.0, 1.0, 0.0,
-		-0.5, -0.5,  0.5, 0.0, 1.0, 1.0,
-		 0.5, -0.5, -0.5, 1.0, 0.0, 1.0,
-
-		 -0.5, -0.5, 0.5, 1.0, 1.0, 0.0,
-		  0.5, -0.5,  0.5, 0.0, 1.0, 1.0,
-		  0.5, -0.5, -0.5, 1.0, 0.0, 1.0,
-
-		 //
-		 -0.5, -0.5, -0.5, 1.0, 1.0, 0.0,
-		  0.0,  0.5,  0.0, 1.0, 1.0, 0.0,
-		  0.5, -0.5, -0.5, 1.0, 1.0, 0.0,
-
-		  -0.5, -0.5, -0.5, 1.0, 0.0, 1.0,
-		  0.0,  0.5,  0.0, 1.0, 0.0, 1.0,
-		  -0.5, -0.5, 0.5, 1.0, 0.0, 1.0,
-
-		   -0.5, -0.5, 0.5, 1.0, 1.0, 0.0,
-		  0.0,  0.5,  0.0, 1.0, 1.0, 0.0,
-		  0.5, -0.5, 0.5, 1.0, 1.0, 0.0,
+	// Os vértices (x, y, z, r, g, b) e os índices já estão prontos em pyramid,
+	// gerados pelo compilador; aqui eles só são enviados para a OpenGL
+	static_assert(PositionColor::floats == 6, "x, y, z, r, g, b");
 
-		   0.5, -0.5, 0.5, 0.0, 1.0, 1.0,
-		  0.0,  0.5,  0.0, 0.0, 1.0, 1.0,
-		  0.5, -0.5, -0.5, 0.0, 1.0, 1.0,
-
-
-	};
-
-	GLuint VBO, VAO;
+	GLuint VAO;
 
 	//Geração do identificador do VBO
 	glGenBuffers(1, &VBO);
@@ -309,7 +338,7 @@ int setupGeometry()
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
 	//Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(pyramid.vertices), pyramid.vertices.data(), GL_STATIC_DRAW);
 
 	//Geração do identificador do VAO (Vertex Array Object)
 	glGenVertexArrays(1, &VAO);
@@ -317,6 +346,11 @@ int setupGeometry()
 	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
 	// e os ponteiros para os atributos 
 	glBindVertexArray(VAO);
+
+	// Buffer de índices (fica associado ao VAO)
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(pyramid.indices), pyramid.indices.data(), GL_STATIC_DRAW);
 	
 	//Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando: 
 	// Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
@@ -326,13 +360,9 @@ int setupGeometry()
 	// Tamanho em bytes 
 	// Deslocamento a partir do byte zero 
 	
-	//Atributo posição (x, y, z)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	//Atributo cor (r, g, b)
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3*sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
+	// Aqui esses valores vêm do formato PositionColor:
+	//Atributo posição (x, y, z) na location 0, atributo cor (r, g, b) na location 1
+	cgcc::setupVertexAttributes<PositionColor>();
 
 
 	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice 
@@ -25,6 +25,21 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// On-disk cache of linked shader program binaries
+#include <cgcc/ProgramCache.h>
+
+// Geometry generated by the compiler (constexpr) in the vertex format declared below
+#include <cgcc/StaticGeometry.h>
+
+// Vsync, frame rate cap and redrawing only when something changes
+#include <cgcc/FramePacer.h>
+
+// Per-thread timing zones exported for chrome://tracing (with CGCC_TRACING)
+#include <cgcc/Trace.h>
+
+// Buffers and textures with size and lifetime; leak report on exit
+#include <cgcc/GPUMemory.h>
+
 // Random number generator for cube positions
 std::random_device rd;
 std::mt19937 gen(rd());
@@ -36,7 +51,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 // Function prototypes
 int setupShader();
-int setupGeometry();
+int setupGeometry(GLuint& VBO, GLuint& EBO);
 
 // Window dimensions (can be changed at runtime)
 const GLuint WIDTH = 1000, HEIGHT = 1000;
@@ -66,14 +81,27 @@ bool rotateX=false, rotateY=false, rotateZ=false;
 float translateX = 0.0f, translateY = 0.0f, translateZ = 0.0f;
 float scale = 1.0f;
 
+// Redraws on key presses and window events, and every frame while a cube rotates
+cgcc::FramePacer framePacer;
+
 // Use a vector for dynamic cube offsets
 std::vector<glm::vec3> cubeOffsets;
 
+// Vertex format: position (location 0) and color (location 1); the attribute
+// pointers in setupGeometry() are derived from this declaration
+using PositionColor = cgcc::VertexLayout<cgcc::VertexAttrib<cgcc::VertexAttribute::Position>, cgcc::VertexAttrib<cgcc::VertexAttribute::Color>>;
+
+// Unit cube with one color per face (+X red, -X green, +Y blue, -Y yellow,
+// +Z magenta, -Z cyan), built at compile time: 24 shared vertices, 36 indices
+constexpr auto cubeSoup = cgcc::cubeGeometry(1.0f, { { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 1, 1, 0 }, { 1, 0, 1 }, { 0, 1, 1 } } });
+static constexpr auto cube = cgcc::indexGeometry<PositionColor, cgcc::uniqueVertexCount<PositionColor>(cubeSoup)>(cubeSoup);
+
 // MAIN function
 int main()
 {
 	// GLFW initialization
 	glfwInit();
+	CGCC_TRACE_THREAD("main");
 
 	//Muita atenção aqui: alguns ambientes não aceitam essas configurações
 	//Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -101,6 +129,10 @@ int main()
 		std::cout << "Failed to initialize GLAD" << std::endl;
 
 	}
+	// Entry points newer than the GLAD profile (shader binary cache)
+	cgcc::loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+	// Every buffer from here on is recorded (report on exit)
+	cgcc::installGPUMemoryTracker();
 
 	// Get version information
 	const GLubyte* renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -118,7 +150,8 @@ int main()
 	GLuint shaderID = setupShader();
 
 	// Generate a simple buffer with triangle geometry
-	GLuint VAO = setupGeometry();
+	GLuint VBO, EBO;
+	GLuint VAO = setupGeometry(VBO, EBO);
 
     // Initial cube offset - start with just one cube at the origin
     cubeOffsets.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
@@ -129,10 +162,15 @@ int main()
 	GLint modelLoc = glGetUniformLocation(shaderID, "model");
 	glEnable(GL_DEPTH_TEST);
 
+	framePacer.mode = cgcc::PacingMode::OnDemand;
+	cgcc::initFramePacer(framePacer, window);
+
 	// Application loop - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
-		glfwPollEvents();
+		if (!cgcc::beginFrame(framePacer))
+			continue;
+		CGCC_TRACE_ZONE("frame");
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glLineWidth(2);
@@ -175,14 +213,24 @@ int main()
 			model = glm::scale(model, glm::vec3(scale));
 			
 			glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			glDrawElements(GL_TRIANGLES, (GLsizei)cube.indices.size(), GL_UNSIGNED_SHORT, 0);
 		}
 		glBindVertexArray(0);
-		glfwSwapBuffers(window);
+		cgcc::endFrame(framePacer);
+
+		// Rotation follows the clock, so the next frame differs
+		if (rotateX || rotateY || rotateZ)
+			cgcc::requestRedraw(framePacer);
 	}
 	// Request OpenGL to deallocate buffers
 	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
 	// Terminate GLFW execution, cleaning up allocated resources
+	CGCC_TRACE_WRITE("trace.json");
+	// Anything still allocated here is a leak
+	cgcc::reportGPUMemory(std::cout);
+	cgcc::removeGPUMemoryTracker();
 	glfwTerminate();
 	return 0;
 }
@@ -194,6 +242,9 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
 
+	// Any key may change the scene
+	cgcc::requestRedraw(framePacer);
+
 	// Rotation
 	if (key == GLFW_KEY_X && action == GLFW_PRESS) {
 		rotateX = true; rotateY = false; rotateZ = false;
@@ -239,6 +290,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 // The function returns the shader program identifier
 int setupShader()
 {
+	CGCC_TRACE_ZONE("setupShader");
+	// If the program was linked on a previous run, restore the binary from the cache
+	uint64_t cacheKey = cgcc::programCacheKey({ vertexShaderSource, fragmentShaderSource });
+	if (GLuint cachedProgram = cgcc::loadCachedProgram(cacheKey))
+		return cachedProgram;
+
 	// Vertex shader
 	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
@@ -264,6 +321,7 @@ int setupShader()
 	}
 	// Link shaders and create shader program identifier
 	GLuint shaderProgram = glCreateProgram();
+	cgcc::markProgramRetrievable(shaderProgram);
 	glAttachShader(shaderProgram, vertexShader);
 	glAttachShader(shaderProgram, fragmentShader);
 	glLinkProgram(shaderProgram);
@@ -275,6 +333,9 @@ int setupShader()
 	}
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
+	// Keep the linked binary for the next runs
+	if (success)
+		cgcc::storeCachedProgram(cacheKey, shaderProgram);
 
 	return shaderProgram;
 }
@@ -283,35 +344,15 @@ int setupShader()
 // triangle geometry
 // Only coordinate attribute in vertices
 // 1 VBO with coordinates, VAO with only 1 attribute pointer
-// The function returns the VAO identifier
-int setupGeometry()
+// The function returns the VAO identifier; the VBO and EBO are returned in the
+// parameters so that they can be deleted at the end
+int setupGeometry(GLuint& VBO, GLuint& EBO)
 {
-	// Here we set the x, y, and z coordinates of the triangle and store them sequentially,
-	// already aiming to send them to the VBO (Vertex Buffer Objects)
-	// Each vertex attribute (coordinate, colors, texture coordinates, normal, etc.)
-	// Can be stored in a single VBO or in separate VBOs
-	GLfloat vertices[] = {
-		// Face +X (red)
-		 0.5, -0.5, -0.5, 1,0,0,   0.5,  0.5, -0.5, 1,0,0,   0.5,  0.5,  0.5, 1,0,0,
-		 0.5, -0.5, -0.5, 1,0,0,   0.5,  0.5,  0.5, 1,0,0,   0.5, -0.5,  0.5, 1,0,0,
-		// Face -X (green)
-		-0.5, -0.5,  0.5, 0,1,0,  -0.5,  0.5,  0.5, 0,1,0,  -0.5,  0.5, -0.5, 0,1,0,
-		-0.5, -0.5,  0.5, 0,1,0,  -0.5,  0.5, -0.5, 0,1,0,  -0.5, -0.5, -0.5, 0,1,0,
-		// Face +Y (blue)
-		-0.5,  0.5, -0.5, 0,0,1,   0.5,  0.5, -0.5, 0,0,1,   0.5,  0.5,  0.5, 0,0,1,
-		-0.5,  0.5, -0.5, 0,0,1,   0.5,  0.5,  0.5, 0,0,1,  -0.5,  0.5,  0.5, 0,0,1,
-		// Face -Y (yellow)
-		-0.5, -0.5,  0.5, 1,1,0,   0.5, -0.5,  0.5, 1,1,0,   0.5, -0.5, -0.5, 1,1,0,
-		-0.5, -0.5,  0.5, 1,1,0,   0.5, -0.5, -0.5, 1,1,0,  -0.5, -0.5, -0.5, 1,1,0,
-		// Face +Z (magenta)
-		-0.5, -0.5,  0.5, 1,0,1,  -0.5,  0.5,  0.5, 1,0,1,   0.5,  0.5,  0.5, 1,0,1,
-		-0.5, -0.5,  0.5, 1,0,1,   0.5,  0.5,  0.5, 1,0,1,   0.5, -0.5,  0.5, 1,0,1,
-		// Face -Z (cyan)
-		-0.5,  0.5, -0.5, 0,1,1,  -0.5, -0.5, -0.5, 0,1,1,   0.5, -0.5, -0.5, 0,1,1,
-		-0.5,  0.5, -0.5, 0,1,1,   0.5, -0.5, -0.5, 0,1,1,   0.5,  0.5, -0.5, 0,1,1,
-	};
-
-	GLuint VBO, VAO;
+	// The vertices (x, y, z, r, g, b) and indices are already in cube, generated
+	// by the compiler; here they are only sent to OpenGL
+	static_assert(PositionColor::floats == 6, "x, y, z, r, g, b");
+
+	GLuint VAO;
 
 	// Generate VBO identifier
 	glGenBuffers(1, &VBO);
@@ -320,7 +361,7 @@ int setupGeometry()
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
 	// Send the float array data to the OpenGL buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cube.vertices), cube.vertices.data(), GL_STATIC_DRAW);
 
 	// Generate VAO (Vertex Array Object) identifier
 	glGenVertexArrays(1, &VAO);
@@ -328,6 +369,11 @@ int setupGeometry()
 	// Bind the VAO first, then connect and set the vertex buffer(s)
 	// and attribute pointers
 	glBindVertexArray(VAO);
+
+	// Index buffer (its binding is stored in the VAO)
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cube.indices), cube.indices.data(), GL_STATIC_DRAW);
 	
 	// For each vertex attribute, create an "AttribPointer" (pointer to the attribute), indicating:
 	// Location in the shader * (attribute locations must match the layout specified in the vertex shader)
@@ -337,13 +383,9 @@ int setupGeometry()
 	// Size in bytes
 	// Offset from byte zero
 	
-	// Position attribute (x, y, z)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	// Color attribute (r, g, b)
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3*sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
+	// Here these values come from the PositionColor layout:
+	// position attribute (x, y, z) at location 0, color attribute (r, g, b) at location 1
+	cgcc::setupVertexAttributes<PositionColor>();
 
 
 	// Note that this is allowed, the call to glVertexAttribPointer registered the VBO as the currently
@@ -0,0 +1,114 @@
+/* TexCompress - offline block compression of the texture assets
+ *
+ * Decodes an image with stb_image, builds its mip chain (cgcc/MipChain.h) and
+ * writes every level block-compressed into a KTX2 file (cgcc/BlockCompression.h,
+ * cgcc/KTX2.h). The texture streamer (cgcc/TextureStreamer.h, used by
+ * SpherePhong) looks for <image>.ktx2 next to each image it is asked for and
+ * uploads it as is, so that PNG is not decoded. Texture arrays
+ * (cgcc/TextureArray.h, TriangleTex) resample their layers and always read the
+ * PNG.
+ *
+ * Usage: TexCompress [--bc1 | --bc3 | --bc7] [--srgb] [--no-mips] [--linear-mips] [--kaiser] input [output.ktx2]
+ *   The default format is BC1 for fully opaque images (8x smaller than RGBA8)
+ *   and BC7 for images with alpha (4x). --srgb marks the data as sRGB encoded
+ *   (the examples currently sample their textures as linear).
+ *   Mips are filtered in linear light assuming sRGB-encoded color, whatever the
+ *   format says; --linear-mips averages the raw values instead (normal maps,
+ *   masks) and --kaiser uses the sharper Kaiser filter instead of a 2x2 box.
+ *
+ * The "compress_textures" CMake target runs it over the images in assets/.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <cgcc/BlockCompression.h>
+#include <cgcc/MipChain.h>
+#include <cgcc/KTX2.h>
+
+static const char* formatName(cgcc::BlockFormat format)
+{
+    switch (format)
+    {
+    case cgcc::BlockFormat::BC1: return "BC1";
+    case cgcc::BlockFormat::BC3: return "BC3";
+    default: return "BC7";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool forceFormat = false, srgb = false, mips = true;
+    cgcc::MipOptions mipOptions;
+    cgcc::BlockFormat format = cgcc::BlockFormat::BC7;
+    std::string input, output;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--bc1") { format = cgcc::BlockFormat::BC1; forceFormat = true; }
+        else if (arg == "--bc3") { format = cgcc::BlockFormat::BC3; forceFormat = true; }
+        else if (arg == "--bc7") { format = cgcc::BlockFormat::BC7; forceFormat = true; }
+        else if (arg == "--srgb") srgb = true;
+        else if (arg == "--no-mips") mips = false;
+        else if (arg == "--linear-mips") mipOptions.srgb = false;
+        else if (arg == "--kaiser") mipOptions.filter = cgcc::MipFilter::Kaiser;
+        else if (input.empty()) input = arg;
+        else if (output.empty()) output = arg;
+        else
+        {
+            std::cout << "Unexpected argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (input.empty())
+    {
+        std::cout << "Usage: TexCompress [--bc1 | --bc3 | --bc7] [--srgb] [--no-mips] [--linear-mips] [--kaiser] input [output.ktx2]" << std::endl;
+        return 1;
+    }
+    if (output.empty())
+        output = cgcc::compressedTexturePath(input);
+
+    int width, height, channels;
+    unsigned char* data = stbi_load(input.c_str(), &width, &height, &channels, 4);
+    if (!data)
+    {
+        std::cout << "Failed to load image " << input << std::endl;
+        return 1;
+    }
+    std::vector<std::vector<uint8_t>> images(1, std::vector<uint8_t>(data, data + (size_t)width * height * 4));
+    stbi_image_free(data);
+
+    if (!forceFormat)
+        format = cgcc::imageHasAlpha(images[0].data(), width, height) ? cgcc::BlockFormat::BC7 : cgcc::BlockFormat::BC1;
+
+    auto start = std::chrono::steady_clock::now();
+    if (mips)
+        cgcc::generateMipLevels(images, width, height, mipOptions);
+    std::vector<std::vector<uint8_t>> levels;
+    size_t uncompressedBytes = 0, compressedBytes = 0;
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        int levelWidth = std::max(1, width >> i), levelHeight = std::max(1, height >> i);
+        levels.push_back(cgcc::compressImage(format, images[i].data(), levelWidth, levelHeight));
+        uncompressedBytes += images[i].size();
+        compressedBytes += levels.back().size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!cgcc::writeKTX2(output, format, srgb, width, height, levels))
+    {
+        std::cout << "Failed to write " << output << std::endl;
+        return 1;
+    }
+    std::cout << input << " (" << width << "x" << height << ", " << levels.size() << " levels) -> " << output << ": "
+              << formatName(format) << (srgb ? " sRGB" : "") << ", " << uncompressedBytes / 1024 << " KB -> "
+              << compressedBytes / 1024 << " KB (" << (double)uncompressedBytes / compressedBytes << "x) in "
+              << seconds << " s" << std::endl;
+    return 0;
+}
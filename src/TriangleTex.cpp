@@ -10,6 +10,7 @@
 #include <iostream>
 #include <string>
 #include <assert.h>
+#include <cstddef>
 
 using namespace std;
 
@@ -24,9 +25,30 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Cache em disco dos binários dos programas de shader
+#include <cgcc/ProgramCache.h>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+// Várias texturas como camadas de uma única GL_TEXTURE_2D_ARRAY
+#include <cgcc/TextureArray.h>
+
+// Formato dos vértices declarado uma vez: os ponteiros de atributo saem dele
+#include <cgcc/VertexLayout.h>
+
+// Vsync, limite de quadros por segundo e redesenho só quando algo muda
+#include <cgcc/FramePacer.h>
+
+// Zonas de tempo por thread, exportadas para chrome://tracing (com CGCC_TRACING)
+#include <cgcc/Trace.h>
+
+// Buffers e texturas com tamanho e tempo de vida; relatório de vazamentos ao sair
+#include <cgcc/GPUMemory.h>
+
+// x, y, z, s, t em floats, nas localizações 0 e 1
+using PositionTexCoord = cgcc::VertexLayout<cgcc::VertexAttrib<cgcc::VertexAttribute::Position>, cgcc::VertexAttrib<cgcc::VertexAttribute::TexCoord>>;
+
 using namespace glm;
 
 #include <cmath>
@@ -36,10 +58,15 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 
 // Protótipos das funções
 int setupShader();
-int setupGeometry();
-GLuint loadTexture(string filePath, int &width, int &height);
+int setupGeometry(GLuint& VBO);
 
-void drawTriangle(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, float angle, vec3 color, vec3 axis = (vec3(0.0, 0.0, 1.0)));
+// Dados de cada instância do triângulo: matriz de modelo e camada da textura
+struct TriangleInstance {
+	mat4 model;
+	float layer;
+};
+GLuint setupInstances(GLuint VAO, const TriangleInstance *instances, int count);
+mat4 triangleModel(vec3 position, vec3 dimensions, float angle, vec3 axis = (vec3(0.0, 0.0, 1.0)));
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 600;
@@ -49,24 +76,28 @@ const GLchar *vertexShaderSource = R"(
 #version 400
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec2 texc;
+layout (location = 2) in mat4 model; // por instância (ocupa as localizações 2 a 5)
+layout (location = 6) in float layer; // por instância
 uniform mat4 projection;
-uniform mat4 model;
 out vec2 texCoord;
+flat out float texLayer;
 void main()
 {
    	gl_Position = projection * model * vec4(position.x, position.y, position.z, 1.0);
 	texCoord = texc;
+	texLayer = layer;
 })";
 
 // Código fonte do Fragment Shader (em GLSL): ainda hardcoded
 const GLchar *fragmentShaderSource = R"(
 #version 400
 in vec2 texCoord;
-uniform sampler2D texBuff;
+flat in float texLayer;
+uniform sampler2DArray texBuff;
 out vec4 color;
 void main()
 {
-	color = texture(texBuff,texCoord);
+	color = texture(texBuff,vec3(texCoord,texLayer));
 })";
 
 // Função MAIN
@@ -74,6 +105,7 @@ int main()
 {
 	// Inicialização da GLFW
 	glfwInit();
+	CGCC_TRACE_THREAD("main");
 
 	// Muita atenção aqui: alguns ambientes não aceitam essas configurações
 	// Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -100,6 +132,10 @@ int main()
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
 	}
+	// Funções da OpenGL mais novas que o perfil da GLAD (cache de binários de shader)
+	cgcc::loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+	// Todo buffer e textura criados daqui em diante são registrados (relatório ao sair)
+	cgcc::installGPUMemoryTracker();
 
 	// Obtendo as informações de versão
 	const GLubyte *renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -116,11 +152,25 @@ int main()
 	GLuint shaderID = setupShader();
 
 	// Gerando um buffer simples, com a geometria de um triângulo
-	GLuint VAO = setupGeometry();
-
-	// Carregando uma textura e armazenando seu id
-	int imgWidth, imgHeight;
-	GLuint texID = loadTexture("../assets/tex/pixelWall.png",imgWidth,imgHeight);
+	GLuint VBO;
+	GLuint VAO = setupGeometry(VBO);
+
+	// Carregando a textura como camada de um array de texturas (redimensionada para
+	// 512x512, mais do que o maior triângulo ocupa na tela): os três triângulos usam
+	// a mesma camada e saem numa única chamada de desenho. Outras texturas entrariam
+	// como novas camadas, e cada instância escolheria a sua
+	cgcc::TextureArray textures;
+	cgcc::buildTextureArray(textures, { "../assets/tex/pixelWall.png" }, 512, 512);
+	const float wallLayer = (float)cgcc::textureArrayLayer(textures, "../assets/tex/pixelWall.png");
+
+	// Uma instância por triângulo, cada uma com a sua matriz de modelo e camada
+	const TriangleInstance instances[] = {
+		{ triangleModel(vec3(100.0, 500.0, 0.0), vec3(100.0, 100.0, 1.0), 0.0), wallLayer },
+		{ triangleModel(vec3(350.0, 300.0, 0.0), vec3(200.0, 200.0, 1.0), 180.0), wallLayer },
+		{ triangleModel(vec3(600.0, 200.0, 0.0), vec3(300.0, 300.0, 1.0), 0.0), wallLayer },
+	};
+	const int instanceCount = sizeof(instances) / sizeof(instances[0]);
+	GLuint instanceVBO = setupInstances(VAO, instances, instanceCount);
 
 	glUseProgram(shaderID);
 
@@ -136,40 +186,45 @@ int main()
 	mat4 projection = ortho(0.0, 800.0, 0.0, 600.0, -1.0, 1.0);
 	glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
 
-	// Matriz de modelo: transformações na geometria (objeto)
-	mat4 model = mat4(1); // matriz identidade
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
+	// Nada se move na cena: ela só é redesenhada quando a janela pede (exposta,
+	// redimensionada); no resto do tempo o loop fica esperando por eventos
+	cgcc::FramePacer framePacer;
+	framePacer.mode = cgcc::PacingMode::OnDemand;
+	cgcc::initFramePacer(framePacer, window);
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
 		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
-		glfwPollEvents();
+		if (!cgcc::beginFrame(framePacer))
+			continue;
+		CGCC_TRACE_ZONE("frame");
 
 		// Limpa o buffer de cor
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // cor de fundo
 		glClear(GL_COLOR_BUFFER_BIT);
 
 		glBindVertexArray(VAO); // Conectando ao buffer de geometria
-		glBindTexture(GL_TEXTURE_2D, texID); //conectando com o buffer de textura que será usado no draw
+		glBindTexture(GL_TEXTURE_2D_ARRAY, textures.texture); //conectando com o array de texturas que será usado no draw
 
-		// Primeiro Triângulo
-		drawTriangle(shaderID, VAO, vec3(100.0, 500.0, 0.0), vec3(100.0, 100.0, 1.0), 0.0, vec3(0.0, 0.0, 1.0));
-
-		// Segundo Triângulo
-		drawTriangle(shaderID, VAO, vec3(350.0, 300.0, 0.0), vec3(200.0, 200.0, 1.0), 180.0, vec3(0.0, 1.0, 0.0));
-
-		// Terceiro Triângulo
-		drawTriangle(shaderID, VAO, vec3(600.0, 200.0, 0.0), vec3(300.0, 300.0, 1.0), 0.0, vec3(1.0, 0.0, 0.0));
+		// Os três triângulos de uma vez, cada instância com a sua camada da textura
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 3, instanceCount);
 
 		glBindVertexArray(0); // Desconectando o buffer de geometria
 
 		// Troca os buffers da tela
-		glfwSwapBuffers(window);
+		cgcc::endFrame(framePacer);
 	}
 	// Pede pra OpenGL desalocar os buffers
 	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &instanceVBO);
+	cgcc::destroyTextureArray(textures);
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
+	CGCC_TRACE_WRITE("trace.json");
+	// O que ainda estiver alocado aqui é vazamento
+	cgcc::reportGPUMemory(std::cout);
+	cgcc::removeGPUMemoryTracker();
 	glfwTerminate();
 	return 0;
 }
@@ -190,6 +245,12 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 //  A função retorna o identificador do programa de shader
 int setupShader()
 {
+	CGCC_TRACE_ZONE("setupShader");
+	// Se o programa já foi linkado numa execução anterior, recupera o binário do cache
+	uint64_t cacheKey = cgcc::programCacheKey({ vertexShaderSource, fragmentShaderSource });
+	if (GLuint cachedProgram = cgcc::loadCachedProgram(cacheKey))
+		return cachedProgram;
+
 	// Vertex shader
 	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
@@ -218,6 +279,7 @@ int setupShader()
 	}
 	// Linkando os shaders e criando o identificador do programa de shader
 	GLuint shaderProgram = glCreateProgram();
+	cgcc::markProgramRetrievable(shaderProgram);
 	glAttachShader(shaderProgram, vertexShader);
 	glAttachShader(shaderProgram, fragmentShader);
 	glLinkProgram(shaderProgram);
@@ -231,6 +293,9 @@ int setupShader()
 	}
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
+	// Guarda o binário linkado para as próximas execuções
+	if (success)
+		cgcc::storeCachedProgram(cacheKey, shaderProgram);
 
 	return shaderProgram;
 }
@@ -239,8 +304,9 @@ int setupShader()
 // geometria de um triângulo
 // Apenas atributo coordenada nos vértices
 // 1 VBO com as coordenadas, VAO com apenas 1 ponteiro para atributo
-// A função retorna o identificador do VAO
-int setupGeometry()
+// A função retorna o identificador do VAO; o VBO volta no parâmetro para ser
+// apagado no fim
+int setupGeometry(GLuint& VBO)
 {
 	// Aqui setamos as coordenadas x, y e z do triângulo e as armazenamos de forma
 	// sequencial, já visando mandar para o VBO (Vertex Buffer Objects)
@@ -254,7 +320,7 @@ int setupGeometry()
 		 0.0,  0.5, 0.0, 0.5, 1.0  	  // v2
 	};
 
-	GLuint VBO, VAO;
+	GLuint VAO;
 	// Geração do identificador do VBO
 	glGenBuffers(1, &VBO);
 	// Faz a conexão (vincula) do buffer como um buffer de array
@@ -275,13 +341,11 @@ int setupGeometry()
 	//  Tamanho em bytes
 	//  Deslocamento a partir do byte zero
 
-	//Atributo posição - coord x, y, z - 3 valores
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)0);
-	glEnableVertexAttribArray(0);
-
-	//Atributo coordenada de textura - coord s, t - 2 valores
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)(3* sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
+	// Aqui eles vêm do formato PositionTexCoord:
+	//Atributo posição - coord x, y, z - 3 valores, na localização 0
+	//Atributo coordenada de textura - coord s, t - 2 valores, na localização 1
+	static_assert(PositionTexCoord::floats == 5, "o array acima é x, y, z, s, t");
+	cgcc::setupVertexAttributes<PositionTexCoord>();
 
 	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
 	// atualmente vinculado - para que depois possamos desvincular com segurança
@@ -293,51 +357,33 @@ int setupGeometry()
 	return VAO;
 }
 
-GLuint loadTexture(string filePath, int &width, int &height)
+// Cria o VBO com os dados por instância e o conecta ao VAO: a matriz de modelo ocupa
+// 4 localizações (uma por coluna) e a camada mais uma; o divisor 1 faz esses
+// atributos avançarem uma vez por instância em vez de uma vez por vértice
+GLuint setupInstances(GLuint VAO, const TriangleInstance *instances, int count)
 {
-	GLuint texID; // id da textura a ser carregada
-
-	// Gera o identificador da textura na memória
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
-
-	// Ajuste dos parâmetros de wrapping e filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLuint instanceVBO;
+	glGenBuffers(1, &instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(TriangleInstance), instances, GL_STATIC_DRAW);
 
-	// Carregamento da imagem usando a função stbi_load da biblioteca stb_image
-	int nrChannels;
-
-	unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-	if (data)
-	{
-		if (nrChannels == 3) // jpg, bmp
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		else // assume que é 4 canais png
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
+	glBindVertexArray(VAO);
+	for (int column = 0; column < 4; column++)
 	{
-		std::cout << "Failed to load texture " << filePath << std::endl;
+		glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(TriangleInstance), (GLvoid *)(offsetof(TriangleInstance, model) + column * sizeof(vec4)));
+		glEnableVertexAttribArray(2 + column);
+		glVertexAttribDivisor(2 + column, 1);
 	}
+	glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, sizeof(TriangleInstance), (GLvoid *)offsetof(TriangleInstance, layer));
+	glEnableVertexAttribArray(6);
+	glVertexAttribDivisor(6, 1);
+	glBindVertexArray(0);
 
-	stbi_image_free(data);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	return texID;
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return instanceVBO;
 }
 
-void drawTriangle(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, float angle, vec3 color, vec3 axis)
+mat4 triangleModel(vec3 position, vec3 dimensions, float angle, vec3 axis)
 {
 	// Matriz de modelo: transformações na geometria (objeto)
 	mat4 model = mat4(1); // matriz identidade
@@ -347,10 +393,5 @@ void drawTriangle(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, f
 	model = rotate(model, radians(angle), axis);
 	// Escala
 	model = scale(model, dimensions);
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-
-	glUniform4f(glGetUniformLocation(shaderID, "inputColor"), color.r, color.g, color.b, 1.0f); // enviando cor para variável uniform inputColor
-																								//  Chamada de desenho - drawcall
-																								//  Poligono Preenchido - GL_TRIANGLES
-	glDrawArrays(GL_TRIANGLES, 0, 3);
+	return model;
 }